@@ -0,0 +1,58 @@
+// Connections per second a running server accepts and hands a client id:
+// every thread connects, does the GetClientId handshake and disconnects in
+// a loop. Run it against different -a/-b settings to compare listeners.
+//
+//   acceptBench HOST PORT [SECONDS] [THREADS]
+#include "benchClient.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace std::chrono;
+
+int main(int argc, char **argv) {
+  if (argc < 3) {
+    fprintf(stderr, "Usage: %s HOST PORT [SECONDS] [THREADS]\n", argv[0]);
+    return 1;
+  }
+  duration<double> length(argc > 3 ? atof(argv[3]) : 3.0);
+  unsigned threads_count = argc > 4 ? strtoul(argv[4], nullptr, 10) : 8;
+
+  raise_fd_limit();
+  std::atomic_size_t accepted = 0, failed = 0;
+  auto start = steady_clock::now();
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < threads_count; t++) {
+    threads.emplace_back([&]() {
+      while (steady_clock::now() - start < length) {
+        uint32_t client_id;
+        int fd = bench_connect(argv[1], argv[2]);
+        if (fd == -1) {
+          failed++;
+          continue;
+        }
+        if (bench_handshake(fd, client_id))
+          accepted++;
+        else
+          failed++;
+        // Reset instead of FIN, so the client side doesn't run out of
+        // ports in TIME_WAIT
+        linger reset{1, 0};
+        setsockopt(fd, SOL_SOCKET, SO_LINGER, &reset, sizeof(reset));
+        close(fd);
+      }
+    });
+  }
+  for (auto &thread : threads)
+    thread.join();
+  double seconds = duration<double>(steady_clock::now() - start).count();
+
+  printf("%u threads: %.0f connections/s, %zu accepted, %zu failed\n",
+         threads_count, accepted / seconds, accepted.load(), failed.load());
+  return failed > 0;
+}
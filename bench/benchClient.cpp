@@ -0,0 +1,44 @@
+#include "benchClient.hpp"
+#include "jsonutils.hpp"
+#include "networkEvents.hpp"
+#include <netdb.h>
+#include <netinet/tcp.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+int bench_connect(const char *host, const char *port) {
+  addrinfo hints{}, *resolved;
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  if (getaddrinfo(host, port, &hints, &resolved) != 0)
+    return -1;
+
+  int fd = socket(resolved->ai_family, resolved->ai_socktype, 0);
+  if (fd != -1 &&
+      connect(fd, resolved->ai_addr, resolved->ai_addrlen) == -1) {
+    close(fd);
+    fd = -1;
+  }
+  freeaddrinfo(resolved);
+  if (fd == -1)
+    return -1;
+
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  return fd;
+}
+
+bool bench_handshake(int fd, uint32_t &client_id) {
+  return write_uint32(fd, NetworkEvents::GetClientId) &&
+         write_uint32(fd, 0) && expectEvent(fd, NetworkEvents::GetClientId) &&
+         read_uint32(fd, client_id);
+}
+
+void raise_fd_limit() {
+  rlimit limit;
+  if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limit);
+  }
+}
@@ -0,0 +1,11 @@
+#pragma once
+#include <cstdint>
+
+// Blocking TCP connection to the server, -1 on failure
+int bench_connect(const char *host, const char *port);
+
+// Asks for a client id without any capabilities, so payloads stay JSON
+bool bench_handshake(int fd, uint32_t &client_id);
+
+// Thousands of connections need more descriptors than the default limit
+void raise_fd_limit();
@@ -0,0 +1,91 @@
+// Encode and decode throughput of a full game state in each wire format,
+// for every room type. JSON goes through BSON like on the wire, decoding
+// through the same InputCursor path the server reads frames with.
+//
+//   codecBench [SECONDS_PER_MEASUREMENT]
+#include "binaryCodec.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+using namespace std::chrono;
+
+static const char *FORMAT_NAMES[WIRE_FORMATS] = {"json", "binary",
+                                                 "quantized"};
+
+// All asteroid slots and a third of the bullets active, at random
+static GameManager full_game(RoomType type) {
+  std::mt19937 rng(1);
+  auto uniform = [&](float min, float max) {
+    return std::uniform_real_distribution<float>(min, max)(rng);
+  };
+  GameManager gm;
+  gm.type = type;
+  gm.NewGame(std::vector<PlayerIdState>(Constants::PLAYERS_MAX));
+  for (size_t i = 0; i < gm.asteroids.count(); i++)
+    gm.asteroids.set(i, Asteroid{true,
+                                 {uniform(0, Constants::screenWidth),
+                                  uniform(0, Constants::screenHeight)},
+                                 {uniform(-200, 200), uniform(-200, 200)},
+                                 uniform(0, 360),
+                                 uniform(-90, 90),
+                                 (int)uniform(1, 4) * 16,
+                                 (int)uniform(3, 9)});
+  for (size_t k = 0; k < gm.bullets.count(); k += 3)
+    gm.bullets.set(k, Bullet{true,
+                             {uniform(0, Constants::screenWidth),
+                              uniform(0, Constants::screenHeight)},
+                             uniform(0, 360)});
+  return gm;
+}
+
+// Runs f until length has passed, returns seconds per call
+template <typename F> static double per_call(duration<double> length, F f) {
+  size_t calls = 0;
+  auto start = steady_clock::now();
+  do {
+    f();
+    calls++;
+  } while (steady_clock::now() - start < length);
+  return duration<double>(steady_clock::now() - start).count() / calls;
+}
+
+int main(int argc, char **argv) {
+  duration<double> length(argc > 1 ? atof(argv[1]) : 0.5);
+
+  SetTraceLogLevel(LOG_WARNING);
+  printf("room     asteroids  format        bytes  encode us  decode us  "
+         "encode MB/s  decode MB/s\n");
+  for (RoomType type : {RoomType::Duel, RoomType::Classic, RoomType::Arena}) {
+    GameManager gm = full_game(type);
+    for (size_t f = 0; f < WIRE_FORMATS; f++) {
+      WireFormat format = (WireFormat)f;
+      std::vector<uint8_t> bytes;
+      double encode = per_call(length, [&]() {
+        bytes.clear();
+        write_value(bytes, gm, format);
+      });
+
+      InputBuffer in;
+      in.append(bytes.data(), bytes.size());
+      GameManager decoded;
+      bool ok = true;
+      double decode = per_call(length, [&]() {
+        InputCursor cursor(in);
+        ok = ok && read_value(cursor, decoded, format, -1) == ReadStatus::Ok;
+      });
+      if (!ok) {
+        fprintf(stderr, "%s state of a %s room didn't decode\n",
+                FORMAT_NAMES[f], room_type_name(type));
+        return 1;
+      }
+
+      printf("%-8s %9zu  %-9s  %9zu  %9.1f  %9.1f  %11.1f  %11.1f\n",
+             room_type_name(type), gm.asteroids.count(), FORMAT_NAMES[f],
+             bytes.size(), encode * 1e6, decode * 1e6,
+             bytes.size() / encode / 1e6, bytes.size() / decode / 1e6);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,82 @@
+// Circle tests per second of the vector kernels in collision.cpp against a
+// loop of raylib's CheckCollisionCircles, for the block sizes of the rooms:
+// one asteroid against 4 players or 6, 12, 20 or 64 bullets.
+//
+//   collisionBench [SECONDS_PER_MEASUREMENT]
+#include "collision.hpp"
+#include "integration.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace std::chrono;
+
+static uint64_t scalar_hits(Vector2 center, float radius, const float *x,
+                            const float *y, float block_radius, size_t count) {
+  uint64_t hits = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (CheckCollisionCircles(center, radius, Vector2{x[i], y[i]},
+                              block_radius))
+      hits |= uint64_t(1) << i;
+  }
+  return hits;
+}
+
+// Calls f for centers in turn until length has passed, returns ns per call.
+// The hits are summed so the calls aren't optimized away.
+template <typename F>
+static double ns_per_call(const std::vector<Vector2> &centers,
+                          duration<double> length, uint64_t &sum, F f) {
+  size_t calls = 0;
+  auto start = steady_clock::now();
+  do {
+    for (Vector2 center : centers)
+      sum += f(center);
+    calls += centers.size();
+  } while (steady_clock::now() - start < length);
+  return duration<double>(steady_clock::now() - start).count() * 1e9 / calls;
+}
+
+int main(int argc, char **argv) {
+  duration<double> length(argc > 1 ? atof(argv[1]) : 0.5);
+
+  std::mt19937 rng(1);
+  auto uniform = [&](float min, float max) {
+    return std::uniform_real_distribution<float>(min, max)(rng);
+  };
+  std::vector<Vector2> centers(1024);
+  for (auto &center : centers)
+    center = {uniform(0, 900), uniform(0, 650)};
+
+  printf("Kernels: %s\n", CollisionKernels());
+  printf("block  kernel ns/call  scalar ns/call  speedup  kernel M tests/s\n");
+  for (size_t count : {4, 6, 12, 20, 64}) {
+    std::vector<float> x(PaddedSlots(count)), y(PaddedSlots(count));
+    for (size_t i = 0; i < count; i++) {
+      x[i] = uniform(0, 900);
+      y[i] = uniform(0, 650);
+    }
+    uint64_t kernel_sum = 0, scalar_sum = 0;
+    double kernel = ns_per_call(centers, length, kernel_sum, [&](Vector2 c) {
+      return CircleHits(c, 40, x.data(), y.data(), 5, count);
+    });
+    double scalar = ns_per_call(centers, length, scalar_sum, [&](Vector2 c) {
+      return scalar_hits(c, 40, x.data(), y.data(), 5, count);
+    });
+    // Both ran whole passes over the same centers
+    uint64_t kernel_pass = 0, scalar_pass = 0;
+    for (Vector2 c : centers) {
+      kernel_pass += CircleHits(c, 40, x.data(), y.data(), 5, count);
+      scalar_pass += scalar_hits(c, 40, x.data(), y.data(), 5, count);
+    }
+    if (kernel_pass != scalar_pass) {
+      fprintf(stderr, "Block of %zu: the kernel's hits differ\n", count);
+      return 1;
+    }
+    printf("%5zu  %14.2f  %14.2f  %6.1fx  %16.0f\n", count, kernel, scalar,
+           scalar / kernel, count * 1e3 / kernel);
+  }
+  return 0;
+}
@@ -0,0 +1,28 @@
+#!/bin/sh
+# Loopback comparison of the epoll and io_uring worker backends. Starts the
+# server from BUILD_DIR with each backend in turn and runs the connection and
+# accept benchmarks against it.
+#
+#   bench/compareIoBackends.sh [BUILD_DIR] [PORT] [WORKERS] [SECONDS]
+set -e
+build=${1:-build}
+port=${2:-5555}
+workers=${3:-$(nproc)}
+seconds=${4:-3}
+log=$(mktemp)
+trap 'rm -f "$log"' EXIT
+
+for backend in epoll io_uring; do
+  flag=
+  [ "$backend" = io_uring ] && flag=-u
+  "$build/TankBustersServer" -w "$workers" $flag "$port" 2>"$log" &
+  server=$!
+  sleep 1
+  echo "== $backend"
+  # The server falls back to epoll without kernel support, say so
+  grep "Server is running" "$log" || true
+  "$build/bench/connectionBench" 127.0.0.1 "$port" "$seconds"
+  "$build/bench/acceptBench" 127.0.0.1 "$port" "$seconds"
+  kill "$server"
+  wait "$server" || true
+done
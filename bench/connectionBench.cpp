@@ -0,0 +1,141 @@
+// Round trips of N concurrent clients asking for the room list, for every N
+// given. Shows how the reactor workers keep up as connections are added.
+//
+//   connectionBench HOST PORT [SECONDS] [CONNECTIONS...]
+#include "benchClient.hpp"
+#include "networkEvents.hpp"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace std::chrono;
+
+struct Connection {
+  int fd = -1;
+  std::vector<uint8_t> in;
+  steady_clock::time_point sent;
+};
+
+static bool send_event(int fd, uint32_t event) {
+  uint32_t net = htonl(event);
+  return write(fd, &net, sizeof(net)) == sizeof(net);
+}
+
+static uint32_t peek_uint32(const std::vector<uint8_t> &in, size_t at) {
+  uint32_t net;
+  memcpy(&net, in.data() + at, sizeof(net));
+  return ntohl(net);
+}
+
+// Handles the complete events in c.in, false on an unexpected one
+static bool handle_events(Connection &c, std::vector<double> &latencies) {
+  size_t used = 0;
+  while (c.in.size() - used >= 4) {
+    uint32_t event = peek_uint32(c.in, used);
+    if (event == NetworkEvents::CheckConnection) {
+      used += 4;
+      if (!send_event(c.fd, NetworkEvents::CheckConnection))
+        return false;
+      continue;
+    }
+    if (event != NetworkEvents::GetRoomList)
+      return false;
+    // Length prefixed JSON follows
+    if (c.in.size() - used < 8 ||
+        c.in.size() - used < 8 + peek_uint32(c.in, used + 4))
+      break;
+    used += 8 + peek_uint32(c.in, used + 4);
+
+    auto now = steady_clock::now();
+    latencies.push_back(duration<double, std::milli>(now - c.sent).count());
+    c.sent = now;
+    if (!send_event(c.fd, NetworkEvents::GetRoomList))
+      return false;
+  }
+  c.in.erase(c.in.begin(), c.in.begin() + used);
+  return true;
+}
+
+static void run(const char *host, const char *port, size_t count,
+                duration<double> length) {
+  std::vector<Connection> connections(count);
+  int epfd = epoll_create1(0);
+  for (size_t i = 0; i < count; i++) {
+    auto &c = connections[i];
+    uint32_t client_id;
+    c.fd = bench_connect(host, port);
+    if (c.fd == -1 || !bench_handshake(c.fd, client_id)) {
+      fprintf(stderr, "Connection %zu of %zu failed\n", i + 1, count);
+      exit(1);
+    }
+    fcntl(c.fd, F_SETFL, fcntl(c.fd, F_GETFL) | O_NONBLOCK);
+    epoll_event ee{};
+    ee.events = EPOLLIN;
+    ee.data.u64 = i;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, c.fd, &ee);
+  }
+
+  std::vector<double> latencies;
+  size_t failed = 0;
+  auto start = steady_clock::now();
+  for (auto &c : connections) {
+    c.sent = steady_clock::now();
+    send_event(c.fd, NetworkEvents::GetRoomList);
+  }
+  std::vector<epoll_event> events(256);
+  uint8_t buffer[65536];
+  while (steady_clock::now() - start < length) {
+    int n = epoll_wait(epfd, events.data(), events.size(), 100);
+    for (int e = 0; e < n; e++) {
+      auto &c = connections[events[e].data.u64];
+      ssize_t readb = read(c.fd, buffer, sizeof(buffer));
+      if (readb > 0)
+        c.in.insert(c.in.end(), buffer, buffer + readb);
+      if (readb == 0 || !handle_events(c, latencies)) {
+        epoll_ctl(epfd, EPOLL_CTL_DEL, c.fd, nullptr);
+        failed++;
+      }
+    }
+  }
+  double seconds = duration<double>(steady_clock::now() - start).count();
+
+  for (auto &c : connections)
+    close(c.fd);
+  close(epfd);
+
+  double p50 = 0, p99 = 0;
+  if (!latencies.empty()) {
+    std::sort(latencies.begin(), latencies.end());
+    p50 = latencies[latencies.size() / 2];
+    p99 = latencies[(size_t)(latencies.size() * 0.99)];
+  }
+  printf("%6zu connections: %9.0f round trips/s, p50 %7.3f ms, "
+         "p99 %7.3f ms, %zu dropped\n",
+         count, latencies.size() / seconds, p50, p99, failed);
+}
+
+int main(int argc, char **argv) {
+  if (argc < 3) {
+    fprintf(stderr, "Usage: %s HOST PORT [SECONDS] [CONNECTIONS...]\n",
+            argv[0]);
+    return 1;
+  }
+  duration<double> length(argc > 3 ? atof(argv[3]) : 3.0);
+  std::vector<size_t> counts;
+  for (int i = 4; i < argc; i++)
+    counts.push_back(strtoul(argv[i], nullptr, 10));
+  if (counts.empty())
+    counts = {1, 10, 100, 1000};
+
+  raise_fd_limit();
+  for (size_t count : counts)
+    run(argv[1], argv[2], count, length);
+  return 0;
+}
@@ -0,0 +1,166 @@
+// Single core throughput of a physics step in the old array of Asteroid
+// and Bullet structs, updated one by one, against the field arrays and
+// integration kernels that replaced it. Every measurement runs a second
+// of ticks from the same start in both layouts and checks that they end
+// in the same state.
+//
+//   layoutBench [SECONDS_PER_MEASUREMENT] [SLOTS...]
+#include "asteroid.hpp"
+#include "bullet.hpp"
+#include "integration.hpp"
+#include "spaceJunkCollector.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <raymath.h>
+
+using namespace std::chrono;
+
+static const size_t TICKS = 60;
+static const duration<double> TICK(1.0 / TICKS);
+
+// The per-struct updates of the old layout
+static void UpdateAsteroid(Asteroid &asteroid, duration<double> frametime) {
+  if (!asteroid.active)
+    return;
+
+  if (SpaceJunkCollector(asteroid.position)) {
+    asteroid.active = false;
+    return;
+  }
+
+  asteroid.position = Vector2Add(
+      asteroid.position, Vector2Scale(asteroid.velocity, frametime.count()));
+  asteroid.rotation += asteroid.rotation_speed * frametime.count();
+}
+
+static void UpdateBullet(Bullet &bullet, duration<double> frametime) {
+  if (!bullet.active)
+    return;
+
+  if (SpaceJunkCollector(bullet.position)) {
+    bullet.active = false;
+    return;
+  }
+
+  bullet.position.x += Constants::BULLET_SPEED * frametime.count() *
+                       cos(bullet.rotation * DEG2RAD);
+  bullet.position.y += Constants::BULLET_SPEED * frametime.count() *
+                       sin(bullet.rotation * DEG2RAD);
+}
+
+// Runs rounds of TICKS ticks, each from a fresh copy of start, until length
+// has passed. Returns ns per slot per tick, the last round's end in out.
+template <typename T, typename F>
+static double ns_per_slot(const T &start, size_t slots,
+                          duration<double> length, T &out, F tick) {
+  duration<double> spent{0};
+  size_t rounds = 0;
+  do {
+    out = start;
+    auto begin = steady_clock::now();
+    for (size_t t = 0; t < TICKS; t++)
+      tick(out);
+    spent += steady_clock::now() - begin;
+    rounds++;
+  } while (spent < length);
+  return spent.count() * 1e9 / (rounds * TICKS * slots);
+}
+
+int main(int argc, char **argv) {
+  duration<double> length(argc > 1 ? atof(argv[1]) : 0.5);
+  std::vector<size_t> counts;
+  for (int i = 2; i < argc; i++)
+    counts.push_back(strtoul(argv[i], nullptr, 10));
+  if (counts.empty())
+    counts = {64, 1024, 10000};
+
+  printf("Kernels: %s\n", IntegrationKernels());
+  printf("    slots  asteroid ns/slot  (structs)  bullet ns/slot  "
+         "(structs)  asteroid M slots/s\n");
+  for (size_t count : counts) {
+    // On the playfield, some leave it during the second
+    std::mt19937 rng(1);
+    auto uniform = [&](float min, float max) {
+      return std::uniform_real_distribution<float>(min, max)(rng);
+    };
+    std::vector<Asteroid> asteroid_structs(count);
+    std::vector<Bullet> bullet_structs(count);
+    for (size_t i = 0; i < count; i++) {
+      Vector2 position{uniform(0, Constants::screenWidth),
+                       uniform(0, Constants::screenHeight)};
+      asteroid_structs[i] = Asteroid{true,
+                                     position,
+                                     {uniform(-200, 200), uniform(-200, 200)},
+                                     uniform(0, 360),
+                                     uniform(-90, 90),
+                                     32,
+                                     5};
+      bullet_structs[i] = Bullet{true, position, uniform(0, 360)};
+    }
+    AsteroidArrays asteroid_arrays(count);
+    asteroid_arrays.assign(asteroid_structs);
+    BulletArrays bullet_arrays(count);
+    bullet_arrays.assign(bullet_structs);
+
+    std::vector<Asteroid> asteroids_out;
+    std::vector<Bullet> bullets_out;
+    AsteroidArrays asteroid_arrays_out;
+    BulletArrays bullet_arrays_out;
+    double asteroid_structs_ns =
+        ns_per_slot(asteroid_structs, count, length, asteroids_out,
+                    [](std::vector<Asteroid> &asteroids) {
+                      for (auto &asteroid : asteroids)
+                        UpdateAsteroid(asteroid, TICK);
+                    });
+    double bullet_structs_ns = ns_per_slot(
+        bullet_structs, count, length, bullets_out,
+        [](std::vector<Bullet> &bullets) {
+          for (auto &bullet : bullets)
+            UpdateBullet(bullet, TICK);
+        });
+    double asteroid_ns = ns_per_slot(
+        asteroid_arrays, count, length, asteroid_arrays_out,
+        [](AsteroidArrays &a) {
+          IntegrateAndCollect(a.x.data(), a.y.data(), a.vx.data(),
+                              a.vy.data(), a.active, a.x.size(),
+                              TICK.count());
+          IntegrateAngles(a.rotation.data(), a.rotation_speed.data(),
+                          a.active, a.x.size(), TICK.count());
+        });
+    double bullet_ns = ns_per_slot(
+        bullet_arrays, count, length, bullet_arrays_out,
+        [](BulletArrays &b) {
+          IntegrateAndCollect(b.x.data(), b.y.data(), b.vx.data(),
+                              b.vy.data(), b.active, b.x.size(),
+                              TICK.count());
+        });
+
+    // Positions are bit for bit the same. The old layout turned angles in
+    // double and bullets by cos/sin every tick, so those only come close.
+    for (size_t i = 0; i < count; i++) {
+      Asteroid old_a = asteroids_out[i], new_a = asteroid_arrays_out.at(i);
+      Bullet old_b = bullets_out[i], new_b = bullet_arrays_out.at(i);
+      bool same = old_a.active == new_a.active &&
+                  (!old_a.active || (old_a.position.x == new_a.position.x &&
+                                     old_a.position.y == new_a.position.y &&
+                                     fabsf(old_a.rotation - new_a.rotation) <
+                                         1e-2f)) &&
+                  old_b.active == new_b.active &&
+                  (!old_b.active ||
+                   Vector2Distance(old_b.position, new_b.position) < 1e-2f);
+      if (!same) {
+        fprintf(stderr, "%zu slots: slot %zu differs between the layouts\n",
+                count, i);
+        return 1;
+      }
+    }
+
+    printf("%9zu  %16.2f  %9.2f  %14.2f  %9.2f  %18.1f\n", count, asteroid_ns,
+           asteroid_structs_ns, bullet_ns, bullet_structs_ns,
+           1e3 / asteroid_ns);
+  }
+  return 0;
+}
@@ -0,0 +1,107 @@
+// Items per second through the workers' MpscQueue and the mutex based
+// LockingQueue, with 1, 4 and 16 producers (or the counts given) and one
+// consumer waiting on the eventfd like a worker does. Checks that every
+// producer's items arrive in order.
+//
+//   queueBench [ITEMS_PER_PRODUCER] [PRODUCERS...]
+#include "lockingQueue.hpp"
+#include "mpscQueue.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <poll.h>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono;
+
+// Producer in the high half, its sequence number in the low half
+static uint64_t item(uint64_t producer, uint64_t sequence) {
+  return producer << 32 | sequence;
+}
+
+struct OrderCheck {
+  std::vector<uint64_t> next;
+  bool ordered = true;
+  explicit OrderCheck(size_t producers) : next(producers) {}
+  void operator()(uint64_t value) {
+    uint64_t &expected = next[value >> 32];
+    ordered = ordered && (value & 0xffffffff) == expected;
+    expected++;
+  }
+};
+
+template <typename Push>
+static std::vector<std::thread> start_producers(size_t producers,
+                                                size_t items, Push push) {
+  std::vector<std::thread> threads;
+  for (size_t p = 0; p < producers; p++) {
+    threads.emplace_back([=]() {
+      for (size_t i = 0; i < items; i++)
+        push(item(p, i));
+    });
+  }
+  return threads;
+}
+
+static double bench_mpsc(size_t producers, size_t items, bool &ordered) {
+  MpscQueue<uint64_t> queue;
+  OrderCheck check(producers);
+  size_t total = producers * items, consumed = 0;
+  auto start = steady_clock::now();
+  auto threads = start_producers(
+      producers, items, [&](uint64_t value) { queue.push(value); });
+  pollfd pfd{queue.get_event_fd(), POLLIN, 0};
+  while (consumed < total) {
+    poll(&pfd, 1, 100);
+    consumed += queue.drain([&](uint64_t &value) {
+      check(value);
+      return true;
+    });
+  }
+  auto elapsed = steady_clock::now() - start;
+  for (auto &thread : threads)
+    thread.join();
+  ordered = check.ordered;
+  return total / duration<double>(elapsed).count();
+}
+
+static double bench_locking(size_t producers, size_t items, bool &ordered) {
+  LockingQueue<uint64_t> queue;
+  OrderCheck check(producers);
+  size_t total = producers * items;
+  auto start = steady_clock::now();
+  auto threads = start_producers(
+      producers, items, [&](uint64_t value) { queue.push(value); });
+  // pop blocks on the eventfd, one read per item
+  for (size_t consumed = 0; consumed < total; consumed++)
+    check(queue.pop());
+  auto elapsed = steady_clock::now() - start;
+  for (auto &thread : threads)
+    thread.join();
+  ordered = check.ordered;
+  return total / duration<double>(elapsed).count();
+}
+
+int main(int argc, char **argv) {
+  size_t items = argc > 1 ? strtoul(argv[1], nullptr, 10) : 200000;
+  std::vector<size_t> counts;
+  for (int i = 2; i < argc; i++)
+    counts.push_back(strtoul(argv[i], nullptr, 10));
+  if (counts.empty())
+    counts = {1, 4, 16};
+
+  SetTraceLogLevel(LOG_WARNING);
+  printf("producers  MpscQueue      LockingQueue\n");
+  for (size_t producers : counts) {
+    bool mpsc_ordered, locking_ordered;
+    double mpsc = bench_mpsc(producers, items, mpsc_ordered);
+    double locking = bench_locking(producers, items, locking_ordered);
+    printf("%9zu  %7.2f M/s%s  %7.2f M/s%s\n", producers, mpsc / 1e6,
+           mpsc_ordered ? "  " : " !", locking / 1e6,
+           locking_ordered ? "" : " !");
+    if (!mpsc_ordered || !locking_ordered)
+      return 1;
+  }
+  return 0;
+}
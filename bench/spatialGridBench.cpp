@@ -0,0 +1,161 @@
+// Collision candidates of an arena round (4 players, 20 bullets) with the
+// asteroid count swept from 64 to 10k: every asteroid tested against all
+// bullets and players, like before the grid, against the SpatialGrid
+// narrowing them first, like ManageCollisions. Both must find the same
+// hits.
+//
+//   spatialGridBench [TICKS] [ASTEROIDS...]
+#include "asteroid.hpp"
+#include "bullet.hpp"
+#include "collision.hpp"
+#include "spatialGrid.hpp"
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <raymath.h>
+
+using namespace std::chrono;
+
+static const size_t PLAYERS = Constants::PLAYERS_MAX;
+static const size_t BULLETS = PLAYERS * 5;
+
+struct Scene {
+  AsteroidArrays asteroids;
+  BulletArrays bullets{BULLETS};
+  std::array<float, PaddedSlots(PLAYERS)> player_x{}, player_y{};
+  std::mt19937 rng{1};
+
+  float uniform(float min, float max) {
+    return std::uniform_real_distribution<float>(min, max)(rng);
+  }
+  Vector2 anywhere() {
+    return {uniform(0, Constants::screenWidth),
+            uniform(0, Constants::screenHeight)};
+  }
+
+  explicit Scene(size_t count) : asteroids(count) {
+    for (size_t i = 0; i < count; i++)
+      asteroids.set(i, Asteroid{true, anywhere(),
+                                {uniform(-100, 100), uniform(-100, 100)},
+                                0, 0,
+                                (int)uniform(Constants::ASTEROID_SIZE_MIN,
+                                             Constants::ASTEROID_SIZE_MAX),
+                                5});
+    for (size_t j = 0; j < PLAYERS; j++) {
+      Vector2 p = anywhere();
+      player_x[j] = p.x;
+      player_y[j] = p.y;
+    }
+  }
+
+  // Asteroids drift and wrap, the bullets are somewhere else every tick
+  void step() {
+    for (size_t i = 0; i < asteroids.count(); i++) {
+      asteroids.x[i] = fmodf(asteroids.x[i] + asteroids.vx[i] / 60 +
+                                 Constants::screenWidth,
+                             Constants::screenWidth);
+      asteroids.y[i] = fmodf(asteroids.y[i] + asteroids.vy[i] / 60 +
+                                 Constants::screenHeight,
+                             Constants::screenHeight);
+    }
+    for (size_t k = 0; k < BULLETS; k++)
+      bullets.set(k, Bullet{true, anywhere(), 0});
+  }
+
+  // The tests of one asteroid in CollideAsteroid: both kernels, then a
+  // walk over the active bullets and the players
+  size_t hits_of(size_t i) const {
+    uint64_t bullet_hits =
+        CircleHits(asteroids.position(i), asteroids.size[i], bullets.x.data(),
+                   bullets.y.data(), Constants::BULLET_SIZE, BULLETS);
+    uint64_t player_hits =
+        CircleHits(asteroids.position(i), asteroids.size[i], player_x.data(),
+                   player_y.data(), Constants::PLAYER_SIZE / 3.0f, PLAYERS);
+    size_t hits = 0;
+    for (size_t k = 0; k < BULLETS; k++) {
+      if (bullets.is_active(k))
+        hits += bullet_hits >> k & 1;
+    }
+    for (size_t j = 0; j < PLAYERS; j++)
+      hits += player_hits >> j & 1;
+    return hits;
+  }
+};
+
+static size_t brute_force(const Scene &s) {
+  size_t hits = 0;
+  for (size_t i = 0; i < s.asteroids.count(); i++) {
+    if (s.asteroids.is_active(i))
+      hits += s.hits_of(i);
+  }
+  return hits;
+}
+
+// The narrowing of ManageCollisions
+static size_t with_grid(const Scene &s, SpatialGrid &grid,
+                        std::vector<bool> &near, size_t &candidates) {
+  grid.build(s.asteroids);
+  near.assign(s.asteroids.count(), false);
+  auto mark_near = [&](Vector2 position, float radius) {
+    grid.query(position, radius + Constants::ASTEROID_SIZE_MAX + 1,
+               [&](uint32_t i) {
+                 float reach = radius + s.asteroids.size[i] + 1;
+                 if (Vector2DistanceSqr(position, s.asteroids.position(i)) <=
+                     reach * reach)
+                   near[i] = true;
+               });
+  };
+  for (size_t k = 0; k < BULLETS; k++)
+    mark_near(s.bullets.position(k), Constants::BULLET_SIZE);
+  for (size_t j = 0; j < PLAYERS; j++)
+    mark_near({s.player_x[j], s.player_y[j]}, Constants::PLAYER_SIZE / 3.0f);
+
+  size_t hits = 0;
+  for (size_t i = 0; i < s.asteroids.count(); i++) {
+    if (s.asteroids.is_active(i) && near[i]) {
+      hits += s.hits_of(i);
+      candidates++;
+    }
+  }
+  return hits;
+}
+
+int main(int argc, char **argv) {
+  size_t ticks = argc > 1 ? strtoul(argv[1], nullptr, 10) : 600;
+  std::vector<size_t> counts;
+  for (int i = 2; i < argc; i++)
+    counts.push_back(strtoul(argv[i], nullptr, 10));
+  if (counts.empty())
+    counts = {64, 128, 256, 512, 1024, 2048, 4096, 10000};
+
+  printf("asteroids  brute us/tick  grid us/tick  speedup  candidates\n");
+  for (size_t count : counts) {
+    Scene scene(count);
+    SpatialGrid grid;
+    std::vector<bool> near;
+    duration<double> brute_time{0}, grid_time{0};
+    size_t candidates = 0;
+    for (size_t t = 0; t < ticks; t++) {
+      scene.step();
+      auto start = steady_clock::now();
+      size_t brute_hits = brute_force(scene);
+      auto middle = steady_clock::now();
+      size_t grid_hits = with_grid(scene, grid, near, candidates);
+      auto end = steady_clock::now();
+      brute_time += middle - start;
+      grid_time += end - middle;
+      if (brute_hits != grid_hits) {
+        fprintf(stderr, "%zu asteroids, tick %zu: grid found %zu of %zu hits\n",
+                count, t, grid_hits, brute_hits);
+        return 1;
+      }
+    }
+    double brute_us = brute_time.count() * 1e6 / ticks;
+    double grid_us = grid_time.count() * 1e6 / ticks;
+    printf("%9zu  %13.2f  %12.2f  %6.1fx  %10.1f\n", count, brute_us, grid_us,
+           brute_us / grid_us, (double)candidates / ticks);
+  }
+  return 0;
+}
@@ -8,6 +8,7 @@
 #include "gameManager.hpp"
 #include "gameStatus.hpp"
 #include "graphicsManager.hpp"
+#include "inputPrediction.hpp"
 #include "networking.hpp"
 #include "player.hpp"
 #include "room.hpp"
@@ -46,7 +47,14 @@ struct Game {
   time_point<steady_clock> frame_start_time = std::chrono::steady_clock::now();
   duration<double> frametime = game_start_time - steady_clock::now();
 
-  time_point<steady_clock> last_position_time_sent = steady_clock::now();
+  // What is drawn in a round: the simulation with remote players and
+  // asteroids moved back to their interpolated states. The simulation
+  // itself goes on from the received states.
+  GameManager drawn;
+
+  // Moves the local player ahead of the server
+  InputPrediction prediction;
+  time_point<steady_clock> last_input_time_sent = steady_clock::now();
 
   inline uint8_t get_networks_idx(std::atomic_uint8_t &draw_idx) {
     return !draw_idx.load();
@@ -145,10 +153,11 @@ struct Game {
 
       } break;
       case GameStatus::GAME:
-        graphicsManager.DrawAsteroids(gameManager().asteroids);
-        graphicsManager.DrawPlayers(gameManager().players);
-        graphicsManager.DrawBullets(gameManager().bullets);
-        graphicsManager.DrawBulletsGUI(gameManager().bullets, player_id.load());
+        graphicsManager.DrawAsteroids(drawn.asteroids);
+        graphicsManager.DrawPlayers(drawn.players);
+        graphicsManager.DrawBullets(drawn.bullets);
+        graphicsManager.DrawBulletsGUI(gameManager().bullets, player_id.load(),
+                                       gameManager().BulletsPerPlayer());
         break;
       case GameStatus::NO_STATUS:
         break;
@@ -159,27 +168,42 @@ struct Game {
 
   void UpdateGame() {
 
-    auto &players = gameManager().players;
-    auto &player = players.at(player_id.load());
-    CheckMovementUpdatePlayer(player, frametime);
-    for (auto &p : gameManager().players) {
-      CalculateUpdatePlayerMovement(p, frametime);
+    auto &game = gameManager();
+    auto &player = game.players.at(player_id.load());
+    if (networkManager.take_round_start()) {
+      prediction = InputPrediction{};
+      last_input_time_sent = steady_clock::now();
     }
-
-    if (steady_clock::now() - last_position_time_sent > 0.1s) {
-      last_position_time_sent = steady_clock::now();
-      networkManager.todo.push([&]() {
-        networkManager.send_movement(player.position, player.velocity,
-                                     player.rotation);
+    Movement acknowledged;
+    if (networkManager.take_local_movement(acknowledged))
+      prediction.reconcile(player, acknowledged, game.tick_rate,
+                           game.fixed_tick_rate);
+    size_t ticks = prediction.advance(player, ReadInputButtons(), frametime,
+                                      game.tick_rate, game.fixed_tick_rate);
+    // Deterministic rounds step the rest of the world once per tick
+    size_t steps = game.fixed_tick_rate ? ticks : 1;
+    for (size_t i = 0; i < steps; i++)
+      game.UpdatePlayers(frametime, player_id.load());
+
+    // Changes go out right away, the current state also at the interval so
+    // the server keeps in step with the ticks
+    if (prediction.changed || steady_clock::now() - last_input_time_sent >
+                                  Constants::INPUT_SEND_INTERVAL) {
+      prediction.changed = false;
+      last_input_time_sent = steady_clock::now();
+      networkManager.todo.push([&, inputs = prediction.recent()]() {
+        networkManager.send_inputs(inputs);
       });
     }
 
-    if (Shoot() && gameManager().players.at(player_id.load()).active) {
-      networkManager.todo.push([&]() { networkManager.send_shoot_bullet(); });
+    for (size_t i = 0; i < steps; i++) {
+      gameManager().UpdateBullets(frametime);
+      gameManager().UpdateAsteroids(frametime);
     }
-
-    gameManager().UpdateBullets(frametime);
-    gameManager().UpdateAsteroids(frametime);
+    drawn.players = gameManager().players;
+    drawn.asteroids = gameManager().asteroids;
+    drawn.bullets = gameManager().bullets;
+    networkManager.interpolate(drawn);
   }
 
   void setSelectedRoom() {
@@ -2,6 +2,7 @@
 #include "player.hpp"
 #include "resource_dir.hpp"
 #include "room.hpp"
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <raylib.h>
@@ -57,7 +58,7 @@ void GraphicsManager::DrawTitle(const Room &r) {
   const char *text =
       TextFormat("%s[%d/%d]", r.name.c_str(),
                  r.players.size() - get_X_players(r.players, PlayerInfo::NONE),
-                 Constants::PLAYERS_MAX);
+                 r.players.size());
   Vector2 origin = MeasureTextEx(font, text, Constants::TEXT_WIN_SIZE,
                                  Constants::TEXT_SPACING);
   DrawTextPro(font, text,
@@ -67,7 +68,7 @@ void GraphicsManager::DrawTitle(const Room &r) {
 }
 
 void GraphicsManager::DrawLobbyPlayers(const Room &r) {
-  for (int i = 0; i < Constants::PLAYERS_MAX; i++) {
+  for (int i = 0; i < (int)r.players.size(); i++) {
     float margin = (i - 2) * 2 * Constants::TEXT_OFFSET;
     const char *text =
         TextFormat("%s PLAYER", Constants::PLAYER_NAMES[i].c_str());
@@ -108,11 +109,11 @@ void GraphicsManager::DrawExitLobbyMessage() {
               Constants::TEXT_SPACING, RAYWHITE);
 }
 
-void GraphicsManager::DrawAsteroids(const std::vector<Asteroid> &asteroids) {
-  for (auto &asteroid : asteroids) {
-    if (!asteroid.active)
+void GraphicsManager::DrawAsteroids(const AsteroidArrays &asteroids) {
+  for (size_t i = 0; i < asteroids.count(); i++) {
+    if (!asteroids.is_active(i))
       continue;
-    DrawAsteroid(asteroid);
+    DrawAsteroid(asteroids.at(i));
   }
 }
 
@@ -122,21 +123,23 @@ void GraphicsManager::DrawPlayers(const std::vector<Player> &players) {
   }
 }
 
-void GraphicsManager::DrawBullets(const std::vector<Bullet> &bullets) {
-  for (auto &bullet : bullets) {
-    if (!bullet.active)
+void GraphicsManager::DrawBullets(const BulletArrays &bullets) {
+  for (size_t i = 0; i < bullets.count(); i++) {
+    if (!bullets.is_active(i))
       continue;
-    DrawBullet(bullet);
+    DrawBullet(bullets.at(i));
   }
 }
 
-void GraphicsManager::DrawBulletsGUI(const std::vector<Bullet> &bullets,
-                                     const uint32_t player_id) {
+void GraphicsManager::DrawBulletsGUI(const BulletArrays &bullets,
+                                     const uint32_t player_id,
+                                     size_t bullets_per_player) {
   int avaliable_bullets = 0;
-  for (size_t i = player_id * Constants::BULLETS_PER_PLAYER;
-       i < (player_id + 1) * Constants::BULLETS_PER_PLAYER; i++) {
+  for (size_t i = player_id * bullets_per_player;
+       i < std::min((player_id + 1) * bullets_per_player, bullets.count());
+       i++) {
 
-    if (!bullets[i].active)
+    if (!bullets.is_active(i))
       avaliable_bullets++;
   }
   std::string bullets_text =
@@ -228,9 +231,10 @@ void GraphicsManager::DrawRooms(const std::vector<Room> &rooms,
     }
     float margin = i * 2 * Constants::TEXT_OFFSET;
     const char *text = TextFormat(
-        "%c %s[%d/%d] - %s", active, rooms.at(i).name.c_str(),
+        "%c %s[%d/%d] %s - %s", active, rooms.at(i).name.c_str(),
         room.players.size() - get_X_players(room.players, PlayerInfo::NONE),
-        Constants::PLAYERS_MAX, room_status.c_str());
+        room.players.size(), TextToUpper(room_type_name(room.type)),
+        room_status.c_str());
     Vector2 origin =
         MeasureTextEx(font, text, text_size, Constants::TEXT_SPACING);
 
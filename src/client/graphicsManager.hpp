@@ -30,11 +30,11 @@ struct GraphicsManager {
   void DrawWinnerText(const uint32_t winner_player_id);
 
   // Draw Game
-  void DrawAsteroids(const std::vector<Asteroid> &asteroids);
+  void DrawAsteroids(const AsteroidArrays &asteroids);
   void DrawPlayers(const std::vector<Player> &players);
-  void DrawBullets(const std::vector<Bullet> &bullets);
-  void DrawBulletsGUI(const std::vector<Bullet> &bullets,
-                      const uint32_t player_id);
+  void DrawBullets(const BulletArrays &bullets);
+  void DrawBulletsGUI(const BulletArrays &bullets, const uint32_t player_id,
+                      size_t bullets_per_player);
   void DrawPlayer(const Player &player);
   void DrawAsteroid(const Asteroid &asteroid);
   void DrawBullet(const Bullet &bullet);
@@ -0,0 +1,67 @@
+#include "inputPrediction.hpp"
+#include "constants.hpp"
+#include "datagram.hpp"
+#include <algorithm>
+
+size_t InputPrediction::advance(Player &player, uint32_t held,
+                                duration<double> frametime,
+                                uint32_t tick_rate,
+                                uint32_t fixed_tick_rate) {
+  // Fire only lasts a tick, the frame that pressed it may not have one
+  fire = fire || (held & InputFire);
+  held &= ~InputFire;
+
+  // A stalled frame doesn't turn into a burst of ticks, the server resyncs
+  // with the newer ones instead
+  duration<double> step(1.0 / tick_rate);
+  time_debt = std::min<duration<double>>(time_debt + frametime,
+                                         Constants::INPUT_TICK_SLACK);
+  size_t count = 0;
+  while (time_debt >= step) {
+    time_debt -= step;
+    tick++;
+    uint32_t current = held;
+    if (fire)
+      current |= InputFire;
+    fire = false;
+    if (current != buttons) {
+      buttons = current;
+      changed = true;
+      changes.push_back(InputState{tick, buttons});
+      if (changes.size() > Constants::INPUT_REPEATED_CHANGES)
+        changes.pop_front();
+    }
+    history.push_back(InputState{tick, buttons});
+    if (history.size() > Constants::INPUT_HISTORY)
+      history.pop_front();
+    ApplyInputButtons(player, buttons, step, fixed_tick_rate);
+    count++;
+  }
+  return count;
+}
+
+void InputPrediction::reconcile(Player &player, const Movement &acknowledged,
+                                uint32_t tick_rate,
+                                uint32_t fixed_tick_rate) {
+  // The server hasn't stepped any of our input yet
+  if (acknowledged.input_tick == 0)
+    return;
+  while (!history.empty() &&
+         !sequence_newer(history.front().tick, acknowledged.input_tick))
+    history.pop_front();
+
+  player.position = acknowledged.position;
+  player.velocity = acknowledged.velocity;
+  player.rotation = acknowledged.rotation;
+  player.active = acknowledged.active;
+  duration<double> step(1.0 / tick_rate);
+  for (const auto &state : history)
+    ApplyInputButtons(player, state.buttons, step, fixed_tick_rate);
+}
+
+std::vector<InputState> InputPrediction::recent() const {
+  std::vector<InputState> states(changes.begin(), changes.end());
+  if (states.empty() || states.back().tick != tick)
+    states.push_back(InputState{tick, buttons});
+  return states;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "player.hpp"
+
+using namespace std::chrono;
+
+// Input of the local player, stepped once per server tick. The steps move it
+// right away and are kept until the server acknowledges them, its state then
+// only lacks the newer ones, which are replayed on top of it. Only changes of
+// the buttons are sent.
+struct InputPrediction {
+  // Last tick stepped and its buttons
+  uint32_t tick = 0;
+  uint32_t buttons = InputNone;
+  // Fire pressed since the last tick
+  bool fire = false;
+  // Set when the buttons changed since it was last cleared
+  bool changed = false;
+  // Every tick not acknowledged yet, and the latest changes
+  std::deque<InputState> history;
+  std::deque<InputState> changes;
+  // Frame time not covered by a tick yet
+  duration<double> time_debt{0};
+
+  // Steps the held buttons over frametime, returns how many ticks there were
+  size_t advance(Player &player, uint32_t held, duration<double> frametime,
+                 uint32_t tick_rate, uint32_t fixed_tick_rate);
+  void reconcile(Player &player, const Movement &acknowledged,
+                 uint32_t tick_rate, uint32_t fixed_tick_rate);
+  // Latest changes followed by the current state, oldest first
+  std::vector<InputState> recent() const;
+};
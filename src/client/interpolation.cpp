@@ -0,0 +1,159 @@
+#include "interpolation.hpp"
+#include <algorithm>
+#include <cmath>
+#include <raymath.h>
+
+void EntityHistory::push(const InterpolationSample &sample) {
+  if (count == samples.size()) {
+    head = (head + 1) % samples.size();
+    count--;
+  }
+  samples[(head + count) % samples.size()] = sample;
+  count++;
+}
+
+// Shortest way from a to b on a range that wraps around
+static float wrapped_delta(float a, float b, float range) {
+  float d = b - a;
+  if (d > range / 2)
+    d -= range;
+  else if (d < -range / 2)
+    d += range;
+  return d;
+}
+
+static float wrap(float v, float range) {
+  if (v < 0)
+    v += range;
+  else if (v >= range)
+    v -= range;
+  return v;
+}
+
+void EntityHistory::sample(time_point<steady_clock> time, bool wraps,
+                           Vector2 &position, float &rotation) const {
+  size_t i = 0;
+  while (i + 1 < count && at(i + 1).time <= time)
+    i++;
+  const InterpolationSample &a = at(i);
+  if (i + 1 == count || time <= a.time) {
+    position = a.position;
+    rotation = a.rotation;
+    return;
+  }
+  const InterpolationSample &b = at(i + 1);
+  float t = duration<float>(time - a.time) / duration<float>(b.time - a.time);
+  if (wraps) {
+    float w = Constants::screenWidth, h = Constants::screenHeight;
+    position.x = wrap(
+        a.position.x + wrapped_delta(a.position.x, b.position.x, w) * t, w);
+    position.y = wrap(
+        a.position.y + wrapped_delta(a.position.y, b.position.y, h) * t, h);
+  } else {
+    position = Vector2Lerp(a.position, b.position, t);
+  }
+  rotation = a.rotation + wrapped_delta(a.rotation, b.rotation, 360) * t;
+}
+
+duration<double> InterpolationBuffer::delay() const {
+  return std::min<duration<double>>(interval + std::max(3 * jitter, min_margin),
+                                    Constants::INTERPOLATION_DELAY_MAX);
+}
+
+// Samples are placed on a timeline paced by the smoothed interval and
+// pulled 1/8 of the way towards their arrival, so the jitter of the
+// arrivals doesn't show as uneven movement. Its deviation is smoothed by
+// 1/16, like the jitter of RFC 3550.
+void InterpolationBuffer::observe(EntityHistory &history,
+                                  InterpolationSample sample) {
+  const auto arrival = sample.time;
+  if (history.count > 0) {
+    duration<double> d = arrival - history.last_arrival;
+    if (history.interval == 0s) {
+      history.interval = d;
+    } else {
+      auto expected = history.newest().time +
+                      duration_cast<steady_clock::duration>(history.interval);
+      sample.time = std::max(expected + (arrival - expected) / 8,
+                             history.newest().time + 1ms);
+      jitter += (abs(arrival - expected) - jitter) / 16;
+      history.interval += (d - history.interval) / 16;
+    }
+    interval = interval == 0s ? history.interval
+                              : interval + (history.interval - interval) / 16;
+  }
+  history.last_arrival = arrival;
+  history.push(sample);
+}
+
+void InterpolationBuffer::record_player(size_t i, const Player &player,
+                                        time_point<steady_clock> now) {
+  if (players.size() <= i)
+    players.resize(i + 1);
+  if (!player.active) {
+    players[i].clear();
+    return;
+  }
+  observe(players[i], {now, player.position, player.rotation});
+}
+
+void InterpolationBuffer::record(const GameManager &gm,
+                                 uint32_t local_player_id,
+                                 time_point<steady_clock> now) {
+  for (size_t i = 0; i < gm.players.size(); i++) {
+    if (i != local_player_id)
+      record_player(i, gm.players[i], now);
+  }
+
+  const AsteroidArrays &a = gm.asteroids;
+  asteroids.resize(a.count());
+  for (size_t i = 0; i < a.count(); i++) {
+    EntityHistory &history = asteroids[i];
+    if (!a.is_active(i)) {
+      history.clear();
+      continue;
+    }
+    // Snapped to, not slid to, when the slot was taken over
+    if (history.count > 0 && history.newest().spawn != a.spawns[i])
+      history.clear();
+    observe(history, {now, a.position(i), a.rotation[i], a.spawns[i]});
+  }
+}
+
+void InterpolationBuffer::apply(GameManager &gm, uint32_t local_player_id,
+                                time_point<steady_clock> now) {
+  auto render_time = now - duration_cast<steady_clock::duration>(delay());
+  // A stream that stopped (e.g. snapshots are disabled) hands the entity
+  // back to extrapolation
+  auto usable = [&](const EntityHistory &history) {
+    if (history.count < 2 || render_time - history.newest().time >
+                                 Constants::INTERPOLATION_DELAY_MAX)
+      return false;
+    if (render_time > history.newest().time)
+      underruns++;
+    return true;
+  };
+
+  for (size_t i = 0; i < std::min(gm.players.size(), players.size()); i++) {
+    Player &p = gm.players[i];
+    if (i == local_player_id || !p.active || !usable(players[i]))
+      continue;
+    players[i].sample(render_time, true, p.position, p.rotation);
+  }
+
+  AsteroidArrays &a = gm.asteroids;
+  for (size_t i = 0; i < std::min(a.count(), asteroids.size()); i++) {
+    if (!a.is_active(i) || !usable(asteroids[i]))
+      continue;
+    Vector2 position;
+    asteroids[i].sample(render_time, false, position, a.rotation[i]);
+    a.x[i] = position.x;
+    a.y[i] = position.y;
+  }
+}
+
+void InterpolationBuffer::clear() {
+  players.clear();
+  asteroids.clear();
+  underruns = 0;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <raylib.h>
+#include <vector>
+
+#include "constants.hpp"
+#include "gameManager.hpp"
+
+using namespace std::chrono;
+
+// State of an entity as it arrived
+struct InterpolationSample {
+  time_point<steady_clock> time;
+  Vector2 position;
+  float rotation;
+  // Spawns of an asteroid's slot, a different one took the slot when it
+  // changes
+  uint32_t spawn = 0;
+};
+
+// Latest samples of one entity in a ring, oldest first
+struct EntityHistory {
+  std::array<InterpolationSample, Constants::INTERPOLATION_SAMPLES> samples;
+  size_t head = 0;
+  size_t count = 0;
+  // Smoothed interval between the arrivals
+  time_point<steady_clock> last_arrival;
+  duration<double> interval{0};
+
+  const InterpolationSample &at(size_t i) const {
+    return samples[(head + i) % samples.size()];
+  }
+  const InterpolationSample &newest() const { return at(count - 1); }
+  void push(const InterpolationSample &sample);
+  void clear() { count = 0; }
+  // Between the samples around time, across the screen edges when the
+  // entity wraps around them like players do. Asteroids don't, they fly in
+  // from outside and are removed past the margin. Holds the newest sample
+  // when time is past it.
+  void sample(time_point<steady_clock> time, bool wraps, Vector2 &position,
+              float &rotation) const;
+};
+
+// Remote players and asteroids are drawn a delay in the past, between the
+// two states received around that time, so updates landing early or late
+// don't show. The delay covers the smoothed interval between updates of
+// an entity plus a margin of a few times their jitter.
+struct InterpolationBuffer {
+  std::vector<EntityHistory> players, asteroids;
+  duration<double> interval{0}, jitter{0};
+  duration<double> min_margin = Constants::INTERPOLATION_MARGIN_MIN;
+  // Draws of an entity whose newest state was already in the past
+  uint64_t underruns = 0;
+
+  duration<double> delay() const;
+  void record_player(size_t i, const Player &player,
+                     time_point<steady_clock> now);
+  // Every remote player and asteroid of gm, after a snapshot
+  void record(const GameManager &gm, uint32_t local_player_id,
+              time_point<steady_clock> now);
+  // Entities without two recent states keep their extrapolated positions
+  void apply(GameManager &gm, uint32_t local_player_id,
+             time_point<steady_clock> now);
+  void clear();
+
+private:
+  void observe(EntityHistory &history, InterpolationSample sample);
+};
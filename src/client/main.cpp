@@ -6,7 +6,8 @@
 #include <thread>
 
 void read_config_file(const std::string path_relative, std::string &host,
-                      std::string &port) {
+                      std::string &port,
+                      milliseconds &interpolation_margin) {
   std::ifstream config(path_relative);
   if (!config.is_open()) {
     TraceLog(LOG_ERROR, "CONFIG: Couldn't open server.json file");
@@ -19,6 +20,10 @@ void read_config_file(const std::string path_relative, std::string &host,
   try {
     host = config_json.at("host");
     port = config_json.at("port");
+    // Optional, the least margin over the interval of updates remote
+    // entities are drawn with
+    interpolation_margin = milliseconds(config_json.value(
+        "interpolation_margin_ms", interpolation_margin.count()));
   } catch (json::exception &ex) {
     TraceLog(LOG_ERROR,
              "CONFIG: Expected field not found in server.json file: %s",
@@ -33,8 +38,10 @@ int main() {
              Constants::windowTitle.c_str());
 
   std::string host, port;
-  read_config_file("resources/server.json", host, port);
+  milliseconds interpolation_margin = Constants::INTERPOLATION_MARGIN_MIN;
+  read_config_file("resources/server.json", host, port, interpolation_margin);
   Game game = Game(host.c_str(), port.c_str());
+  game.networkManager.set_interpolation_margin(interpolation_margin);
 
   // Main game loop
   while (!WindowShouldClose()) // Detect window close button or ESC key
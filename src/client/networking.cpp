@@ -1,5 +1,6 @@
 #include "networking.hpp"
 
+#include <cerrno>
 #include <chrono>
 #include <sys/epoll.h>
 #include <sys/socket.h>
@@ -16,6 +17,7 @@
 #include "asteroid.hpp"
 #include "bullet.hpp"
 #include "constants.hpp"
+#include "datagram.hpp"
 #include "gameManager.hpp"
 #include "gameStatus.hpp"
 #include "jsonutils.hpp"
@@ -61,6 +63,8 @@ ClientNetworkManager::~ClientNetworkManager() {
   }
   shutdown(mainfd, SHUT_RDWR);
   close(mainfd);
+  if (udpfd != -1)
+    close(udpfd);
 }
 
 void ClientNetworkManager::flip_game_manager() {
@@ -82,7 +86,7 @@ void ClientNetworkManager::flip_joined_room() {
 }
 
 void ClientNetworkManager::perform_network_actions() {
-  const size_t MAX_EVENTS = 2;
+  const size_t MAX_EVENTS = 3;
   epoll_event ee, events[MAX_EVENTS];
   this->epollfd = epoll_create1(0);
   if (epollfd == -1) {
@@ -112,6 +116,17 @@ void ClientNetworkManager::perform_network_actions() {
     return;
   }
 
+  if (udpfd != -1) {
+    ee.events = EPOLLIN;
+    ee.data.fd = udpfd;
+    if (epoll_ctl(epollfd, EPOLL_CTL_ADD, udpfd, &ee) == -1) {
+      // Input commands fall back to TCP
+      TraceLog(LOG_WARNING, "NET: Couldn't add UDP socket to epoll");
+      close(udpfd);
+      udpfd = -1;
+    }
+  }
+
   while (!this->_stop) {
     int nfds = epoll_wait(epollfd, events, MAX_EVENTS,
                           3 * Constants::CONNECTION_TIMEOUT_MILISECONDS);
@@ -128,6 +143,8 @@ void ClientNetworkManager::perform_network_actions() {
     for (int n = 0; n < nfds; n++) {
       if (events[n].data.fd == todo.get_event_fd()) {
         todo.pop()();
+      } else if (events[n].data.fd == udpfd) {
+        receive_datagrams();
       } else if (events[n].data.fd == mainfd) {
         uint32_t network_event;
         bool status = read_uint32(mainfd, network_event);
@@ -149,25 +166,21 @@ void ClientNetworkManager::perform_network_actions() {
 }
 
 void ClientNetworkManager::handle_update_game_state() {
-  json game_state_json;
-  bool status = read_json(mainfd, game_state_json, -1);
+  GameManager game_state;
+  bool status = read_value(mainfd, game_state, format, -1);
   if (!status) {
-    TraceLog(LOG_ERROR, "NET: Couldn't receive json of game state");
+    TraceLog(LOG_ERROR, "NET: Couldn't receive game state");
     return;
   }
 
-  try {
-    TraceLog(LOG_DEBUG, "NET: received json of game state");
-    gameManager() = game_state_json.template get<GameManager>();
-    auto &draw_gm_mgr = gameManagersPair.at(game_manager_draw_idx);
-    gameManager().players = draw_gm_mgr.players;
-    gameManager().asteroids = draw_gm_mgr.asteroids;
-    gameManager().bullets = draw_gm_mgr.bullets;
-    flip_game_manager();
-    gameManager() = gameManagersPair.at(game_manager_draw_idx);
-  } catch (json::exception &ex) {
-    TraceLog(LOG_ERROR, "JSON: Couldn't deserialize json into GameManager");
-  }
+  TraceLog(LOG_DEBUG, "NET: received game state");
+  gameManager() = game_state;
+  auto &draw_gm_mgr = gameManagersPair.at(game_manager_draw_idx);
+  gameManager().players = draw_gm_mgr.players;
+  gameManager().asteroids = draw_gm_mgr.asteroids;
+  gameManager().bullets = draw_gm_mgr.bullets;
+  flip_game_manager();
+  gameManager() = gameManagersPair.at(game_manager_draw_idx);
 }
 
 void ClientNetworkManager::handle_new_game_soon() {
@@ -178,6 +191,13 @@ void ClientNetworkManager::handle_new_game_soon() {
     return;
   }
   auto when = std::chrono::system_clock::time_point(std::chrono::seconds(val));
+  {
+    std::lock_guard<std::mutex> lg(interpolation_mutex);
+    TraceLog(LOG_INFO,
+             "NET: Remote entities were drawn %.0f ms in the past, %lu "
+             "draws ran past their newest state",
+             interpolation.delay().count() * 1000, interpolation.underruns);
+  }
   gameManager().game_start_time = when;
   flip_game_manager();
   gameManager().game_start_time = when;
@@ -201,17 +221,9 @@ void ClientNetworkManager::handle_return_to_lobby() {
 
 void ClientNetworkManager::handle_vote_ready() {
   std::vector<PlayerIdState> players;
-  json player_short_infos_json;
-  bool status = read_json(mainfd, player_short_infos_json, -1);
+  bool status = read_value(mainfd, players, format, -1);
   if (!status) {
-    TraceLog(LOG_ERROR, "NET: Couldn't receive json of players");
-    return;
-  }
-  try {
-    players =
-        player_short_infos_json.template get<std::vector<PlayerIdState>>();
-  } catch (json::exception &ex) {
-    TraceLog(LOG_ERROR, "JSON: Couldn't deserialize json into vector<Player>");
+    TraceLog(LOG_ERROR, "NET: Couldn't receive players");
     return;
   }
   if (status) {
@@ -229,33 +241,42 @@ void ClientNetworkManager::handle_player_movement() {
     return;
   }
 
-  json movement;
-  Vector2 position, velocity;
-  float rotation;
-  bool active;
-  try {
-    if (!read_json(mainfd, movement, -1)) {
-      TraceLog(LOG_ERROR,
-               "NET: cannot read player movement json for player_id=%lu",
-               updated_player_id);
-      return;
-    }
-    position = movement.at("position");
-    velocity = movement.at("velocity");
-    rotation = movement.at("rotation");
-    active = movement.at("active");
-  } catch (json::exception &ex) {
-    TraceLog(LOG_ERROR, "JSON: Couldn't serialize movement into json");
+  Movement movement;
+  if (!read_value(mainfd, movement, format, -1)) {
+    TraceLog(LOG_ERROR, "NET: cannot read player movement for player_id=%lu",
+             updated_player_id);
     return;
   }
+  update_player_movement(updated_player_id, movement);
+}
 
+// Movement received over TCP or UDP. The local player is predicted by the
+// game thread, its movement only acknowledges the input states.
+void ClientNetworkManager::update_player_movement(uint32_t updated_player_id,
+                                                  Movement movement) {
+  gameManager().SnapToGrid(movement);
+  if (updated_player_id == player_id.load()) {
+    std::lock_guard<std::mutex> lg(local_movement_mutex);
+    // The fallback to TCP may overtake datagrams
+    if (local_movement_pending &&
+        sequence_newer(local_movement.input_tick, movement.input_tick))
+      return;
+    local_movement = movement;
+    local_movement_pending = true;
+    return;
+  }
   try {
     gameManager() = gameManagersPair.at(game_manager_draw_idx);
     auto &player = gameManager().players.at(updated_player_id);
-    player.position = position;
-    player.velocity = velocity;
-    player.rotation = rotation;
-    player.active = active;
+    player.position = movement.position;
+    player.velocity = movement.velocity;
+    player.rotation = movement.rotation;
+    player.active = movement.active;
+    {
+      std::lock_guard<std::mutex> lg(interpolation_mutex);
+      interpolation.record_player(updated_player_id, player,
+                                  steady_clock::now());
+    }
     flip_game_manager();
     gameManager() = gameManagersPair.at(game_manager_draw_idx);
   } catch (const std::out_of_range &ex) {
@@ -265,41 +286,56 @@ void ClientNetworkManager::handle_player_movement() {
   }
 }
 
+void ClientNetworkManager::interpolate(GameManager &gm) {
+  std::lock_guard<std::mutex> lg(interpolation_mutex);
+  interpolation.apply(gm, player_id.load(), steady_clock::now());
+}
+
+void ClientNetworkManager::set_interpolation_margin(milliseconds min_margin) {
+  std::lock_guard<std::mutex> lg(interpolation_mutex);
+  interpolation.min_margin = min_margin;
+}
+
+bool ClientNetworkManager::take_local_movement(Movement &movement) {
+  std::lock_guard<std::mutex> lg(local_movement_mutex);
+  if (!local_movement_pending)
+    return false;
+  movement = local_movement;
+  local_movement_pending = false;
+  return true;
+}
+
+bool ClientNetworkManager::take_round_start() {
+  std::lock_guard<std::mutex> lg(local_movement_mutex);
+  bool started = round_started;
+  round_started = false;
+  return started;
+}
+
 void ClientNetworkManager::handle_update_bullets() {
-  json bullets_json;
-  bool status = read_json(mainfd, bullets_json, -1);
+  BulletArrays bullets;
+  bool status = read_value(mainfd, bullets, format, -1);
   if (!status) {
-    TraceLog(LOG_ERROR, "NET: Couldn't receive json of players");
-    return;
-  }
-  try {
-    auto bullets = bullets_json.template get<std::vector<Bullet>>();
-    gameManager() = gameManagersPair.at(game_manager_draw_idx);
-    gameManager().bullets = bullets;
-    flip_game_manager();
-  } catch (json::exception &ex) {
-    TraceLog(LOG_ERROR, "JSON: Couldn't deserialize json into vector<Bullet>");
+    TraceLog(LOG_ERROR, "NET: Couldn't receive bullets");
     return;
   }
+  gameManager() = gameManagersPair.at(game_manager_draw_idx);
+  gameManager().bullets = bullets;
+  gameManager().SnapToGrid();
+  flip_game_manager();
 }
 
 void ClientNetworkManager::handle_update_room_state() {
-  json room_state_json;
-  bool status = read_json(mainfd, room_state_json, -1);
+  Room room;
+  bool status = read_value(mainfd, room, format, -1);
   if (!status) {
-    TraceLog(LOG_ERROR, "NET: Couldn't receive json of room state");
+    TraceLog(LOG_ERROR, "NET: Couldn't receive room state");
     return;
   }
-  try {
-    TraceLog(LOG_DEBUG, "NET: received json of room state");
-    auto room = room_state_json.template get<Room>();
-    joinedRoom() = room;
-    flip_joined_room();
-    joinedRoom() = room;
-  } catch (json::exception &ex) {
-    TraceLog(LOG_ERROR, "JSON: Couldn't deserialize json into vector<Player>");
-  } catch (const std::out_of_range &ex) {
-  }
+  TraceLog(LOG_DEBUG, "NET: received room state");
+  joinedRoom() = room;
+  flip_joined_room();
+  joinedRoom() = room;
 }
 
 void ClientNetworkManager::handle_leave_room() {
@@ -350,6 +386,10 @@ void ClientNetworkManager::handle_join_room() {
 
     TraceLog(LOG_DEBUG, "GAME: Joined room_id=%lu, player_id=%lu",
              joined_room_id, _player_id);
+    // The server starts over from keyframes
+    for (auto &snapshot : snapshots)
+      snapshot.id = 0;
+    snapshot_id = 0;
     uint32_t expected_player_id = -1;
     while (!this->player_id.compare_exchange_strong(expected_player_id,
                                                     _player_id)) {
@@ -365,15 +405,15 @@ void ClientNetworkManager::handle_join_room() {
 }
 
 void ClientNetworkManager::handle_shoot_bullets() {
-  uint32_t value;
-  bool status = read_uint32(mainfd, value);
+  uint32_t value, bullet;
+  bool status = read_uint32(mainfd, value) && read_uint32(mainfd, bullet);
   if (!status) {
     TraceLog(LOG_ERROR, "NET: Couldn't receive who shot the bullet");
     return;
   }
   try {
     gameManager() = gameManagersPair.at(game_manager_draw_idx);
-    gameManager().AddBullet(gameManager().players.at(value));
+    gameManager().SetBullet(bullet, gameManager().players.at(value));
     flip_game_manager();
     gameManager().bullets = gameManager().bullets;
   } catch (const std::out_of_range &ex) {
@@ -381,27 +421,42 @@ void ClientNetworkManager::handle_shoot_bullets() {
 }
 
 void ClientNetworkManager::handle_get_room_list() {
-  json rooms_json;
-  bool status = read_json(mainfd, rooms_json, -1);
+  std::map<uint32_t, Room> rs;
+  bool status = read_value(mainfd, rs, format, -1);
   if (!status) {
-    TraceLog(LOG_ERROR, "NET: Couldn't receive json of rooms");
-    return;
-  }
-  try {
-    auto rs = rooms_json.template get<std::map<uint32_t, Room>>();
-    rooms() = rs;
-    flip_rooms();
-    rooms() = rs;
-    return;
-  } catch (json::exception &ex) {
-    TraceLog(LOG_ERROR, "JSON: Couldn't deserialize json into vector<Room>");
+    TraceLog(LOG_ERROR, "NET: Couldn't receive rooms");
     return;
   }
+  rooms() = rs;
+  flip_rooms();
+  rooms() = rs;
 }
 
 void ClientNetworkManager::handle_start_round() {
+  {
+    std::lock_guard<std::mutex> lg(interpolation_mutex);
+    interpolation.clear();
+  }
+  {
+    // The server's input queues start over, so do the ticks
+    std::lock_guard<std::mutex> lg(local_movement_mutex);
+    local_movement_pending = false;
+    round_started = true;
+  }
+  input_sent_tick = 0;
+  input_sent_buttons = InputNone;
+  gameManager().type = joinedRoom().type;
+  gameManager().tick_rate = joinedRoom().tick_rate;
+  gameManager().fixed_tick_rate =
+      joinedRoom().deterministic ? joinedRoom().tick_rate : 0;
+  gameManager().seed = joinedRoom().seed;
   gameManager().NewGame(joinedRoom().players);
   flip_game_manager();
+  gameManager().type = joinedRoom().type;
+  gameManager().tick_rate = joinedRoom().tick_rate;
+  gameManager().fixed_tick_rate =
+      joinedRoom().deterministic ? joinedRoom().tick_rate : 0;
+  gameManager().seed = joinedRoom().seed;
   gameManager().NewGame(joinedRoom().players);
   joinedRoom().status = GameStatus::GAME;
   flip_joined_room();
@@ -426,6 +481,8 @@ void ClientNetworkManager::handle_network_event(uint32_t event) {
                network_event_to_string(event).c_str());
       return;
     }
+    // Repeated in case the previous one was lost, or a NAT mapping expired
+    send_udp_hello();
     break;
   }
   case NetworkEvents::EndRound:
@@ -490,6 +547,9 @@ void ClientNetworkManager::handle_network_event(uint32_t event) {
   case NetworkEvents::BulletDestroyed:
     handle_bullet_destroyed();
     break;
+  case NetworkEvents::WorldSnapshot:
+    handle_world_snapshot();
+    break;
   default:
     TraceLog(LOG_WARNING, "Unknown NetworkEvent %ld received", event);
     break;
@@ -506,10 +566,12 @@ bool ClientNetworkManager::get_new_client_id(uint32_t &client_id) {
     return false;
   }
 
-  // Get new id by sending id=0
-  status = write_uint32(mainfd, client_id);
+  // Get new id, asking for the UDP side channel, snapshots and quantized
+  // binary payloads
+  status = write_uint32(mainfd, CapabilityUdp | CapabilitySnapshots |
+                                    CapabilityBinary | CapabilityQuantized);
   if (!status) {
-    TraceLog(LOG_ERROR, "NET: Cannot send client_id");
+    TraceLog(LOG_ERROR, "NET: Cannot send client capabilities");
     return false;
   }
 
@@ -528,6 +590,34 @@ bool ClientNetworkManager::get_new_client_id(uint32_t &client_id) {
     TraceLog(LOG_ERROR, "GAME: Received client id is 0");
     return false;
   }
+  client_id = new_client_id;
+
+  status = read_uint32(mainfd, capabilities);
+  if (!status) {
+    TraceLog(LOG_ERROR, "NET: Didn't receive accepted capabilities");
+    return false;
+  }
+  if (capabilities & CapabilityQuantized)
+    format = WireFormat::Quantized;
+  else if (capabilities & CapabilityBinary)
+    format = WireFormat::Binary;
+  if (capabilities & CapabilityUdp) {
+    uint32_t udp_port;
+    if (!read_uint32(mainfd, udp_token) || !read_uint32(mainfd, udp_port)) {
+      TraceLog(LOG_ERROR, "NET: Didn't receive UDP channel parameters");
+      return false;
+    }
+    udpfd = connect_udp(connected_to_host, udp_port);
+    if (udpfd != -1)
+      send_udp_hello();
+  }
+  TraceLog(LOG_INFO,
+           "NET: Inputs are sent over %s, world snapshots %s, %s payloads",
+           udpfd != -1 ? "UDP" : "TCP",
+           capabilities & CapabilitySnapshots ? "enabled" : "disabled",
+           format == WireFormat::Quantized ? "quantized"
+           : format == WireFormat::Binary  ? "binary"
+                                           : "json");
 
   return true;
 }
@@ -640,61 +730,67 @@ bool ClientNetworkManager::leave_room() {
   return status;
 }
 
-bool ClientNetworkManager::send_movement(Vector2 position, Vector2 velocity,
-                                         float rotation) {
-  TraceLog(LOG_DEBUG, "NET: starting to send player movement");
-  json movement;
-  try {
-    movement = {
-        {"position", position}, {"velocity", velocity}, {"rotation", rotation}};
-  } catch (json::exception &ex) {
-    TraceLog(LOG_ERROR, "JSON: Couldn't serialize movement into json");
-    return false;
-  }
-
-  bool status = setEvent(mainfd, NetworkEvents::PlayerMovement);
+// States are the latest changes of the buttons followed by the current one.
+// A datagram carries all of them, so any one that arrives makes up for the
+// lost ones and keeps the server in step, while the stream gets each change
+// once.
+bool ClientNetworkManager::send_inputs(const std::vector<InputState> &states) {
+  TraceLog(LOG_DEBUG, "NET: starting to send %zu input states",
+           states.size());
+  if (udpfd != -1) {
+    std::vector<uint8_t> datagram;
+    write_datagram_header(datagram,
+                          {client_id, udp_token, ++udp_out_sequence});
+    write_uint32(datagram, NetworkEvents::PlayerInput);
+    if (write_value(datagram, states, format) && send_datagram(datagram))
+      return true;
+    // Too large or the socket failed, TCP still works
+  }
+
+  std::vector<InputState> unsent;
+  for (const auto &state : states) {
+    if (sequence_newer(state.tick, input_sent_tick) &&
+        (unsent.empty() ? state.buttons != input_sent_buttons
+                        : state.buttons != unsent.back().buttons))
+      unsent.push_back(state);
+  }
+  if (unsent.empty())
+    return true;
+
+  bool status = setEvent(mainfd, NetworkEvents::PlayerInput);
   if (!status) {
     return false;
   }
 
-  status = write_json(mainfd, movement);
+  status = write_value(mainfd, unsent, format);
   if (!status) {
-    TraceLog(LOG_ERROR, "NET: Couldn't send json of movement");
+    TraceLog(LOG_ERROR, "NET: Couldn't send input states");
     return false;
   }
+  input_sent_tick = unsent.back().tick;
+  input_sent_buttons = unsent.back().buttons;
 
   return true;
 }
 
 void ClientNetworkManager::handle_update_asteroids() {
-  std::vector<Asteroid> asteroids;
-  json asteroids_json;
-  bool status = read_json(mainfd, asteroids_json, -1);
+  AsteroidArrays asteroids;
+  bool status = read_value(mainfd, asteroids, format, -1);
   if (!status) {
-    TraceLog(LOG_ERROR, "NET: Couldn't receive json of vector<Asteroid>");
-    return;
-  }
-
-  try {
-    asteroids = asteroids_json.template get<std::vector<Asteroid>>();
-  } catch (json::exception &ex) {
-    TraceLog(LOG_ERROR,
-             "JSON: Couldn't deserialize json into vector<Asteroid>");
+    TraceLog(LOG_ERROR, "NET: Couldn't receive asteroids");
     return;
   }
 
   try {
     gameManager().asteroids = asteroids;
+    gameManager().SnapToGrid();
   } catch (const std::out_of_range &ex) {
     return;
   }
 
   flip_game_manager();
-  gameManager().asteroids = asteroids;
-}
-
-bool ClientNetworkManager::send_shoot_bullet() {
-  return setEvent(mainfd, NetworkEvents::ShootBullets);
+  gameManager().asteroids =
+      gameManagersPair.at(game_manager_draw_idx).asteroids;
 }
 
 bool ClientNetworkManager::send_vote_ready() {
@@ -721,6 +817,13 @@ void ClientNetworkManager::handle_end_round() {
     return;
   }
   auto when = std::chrono::system_clock::time_point(std::chrono::seconds(val));
+  {
+    std::lock_guard<std::mutex> lg(interpolation_mutex);
+    TraceLog(LOG_INFO,
+             "NET: Remote entities were drawn %.0f ms in the past, %lu "
+             "draws ran past their newest state",
+             interpolation.delay().count() * 1000, interpolation.underruns);
+  }
   gameManager().game_start_time = when;
   gameManager().winner_player_id = winner_player_id;
   flip_game_manager();
@@ -732,22 +835,17 @@ void ClientNetworkManager::handle_end_round() {
 }
 
 void ClientNetworkManager::handle_update_players() {
-  json players_json;
-  bool status = read_json(mainfd, players_json, -1);
+  std::vector<Player> players;
+  bool status = read_value(mainfd, players, format, -1);
   if (!status) {
-    TraceLog(LOG_ERROR, "NET: Couldn't receive json of players");
-    return;
-  }
-  try {
-    auto players = players_json.template get<std::vector<Player>>();
-    gameManager() = gameManagersPair.at(game_manager_draw_idx);
-    gameManager().players = players;
-    flip_game_manager();
-    gameManager().players = players;
-  } catch (json::exception &ex) {
-    TraceLog(LOG_ERROR, "JSON: Couldn't deserialize json into vector<Player>");
+    TraceLog(LOG_ERROR, "NET: Couldn't receive players");
     return;
   }
+  gameManager() = gameManagersPair.at(game_manager_draw_idx);
+  gameManager().players = players;
+  gameManager().SnapToGrid();
+  flip_game_manager();
+  gameManager().players = gameManagersPair.at(game_manager_draw_idx).players;
 }
 
 void ClientNetworkManager::handle_bullet_destroyed() {
@@ -759,9 +857,9 @@ void ClientNetworkManager::handle_bullet_destroyed() {
   }
   try {
     gameManager() = gameManagersPair.at(game_manager_draw_idx);
-    gameManager().bullets.at(bullet_id).active = false;
+    gameManager().bullets.deactivate(bullet_id);
     flip_game_manager();
-    gameManager().bullets.at(bullet_id).active = false;
+    gameManager().bullets.deactivate(bullet_id);
   } catch (const std::out_of_range &ex) {
     TraceLog(LOG_ERROR, "NET: bullet does not exist");
     return;
@@ -795,27 +893,19 @@ void ClientNetworkManager::handle_spawn_asteroid() {
     return;
   }
 
-  json j;
-  status = read_json(mainfd, j, -1);
-  if (!status) {
-    TraceLog(LOG_ERROR, "NET: Couldn't receive spawned Asteroid json");
-    return;
-  }
-
   Asteroid a;
-
-  try {
-    a = j;
-  } catch (json::exception &ex) {
-    TraceLog(LOG_ERROR, "JSON: Couldn't deserialize json into asteroid");
+  status = read_value(mainfd, a, format, -1);
+  if (!status) {
+    TraceLog(LOG_ERROR, "NET: Couldn't receive spawned Asteroid");
     return;
   }
+  gameManager().SnapToGrid(a);
 
   try {
     gameManager() = gameManagersPair.at(game_manager_draw_idx);
-    gameManager().asteroids.at(id) = a;
+    gameManager().asteroids.set(id, a);
     flip_game_manager();
-    gameManager().asteroids.at(id) = a;
+    gameManager().asteroids.set(id, a);
   } catch (const std::out_of_range &ex) {
     TraceLog(LOG_ERROR, "NET: Asteroid does not exist");
     return;
@@ -833,11 +923,202 @@ void ClientNetworkManager::handle_asteroid_destroyed() {
 
   try {
     gameManager() = gameManagersPair.at(game_manager_draw_idx);
-    gameManager().asteroids.at(id).active = false;
+    gameManager().asteroids.deactivate(id);
     flip_game_manager();
-    gameManager().asteroids.at(id).active = false;
+    gameManager().asteroids.deactivate(id);
   } catch (const std::out_of_range &ex) {
     TraceLog(LOG_ERROR, "NET: Asteroid does not exist");
     return;
   }
 }
+
+// Connected UDP socket, only datagrams from the server are received
+int ClientNetworkManager::connect_udp(const char *host, uint32_t port) {
+  struct addrinfo hints{};
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_DGRAM;
+  hints.ai_protocol = IPPROTO_UDP;
+  struct addrinfo *p_addr = nullptr;
+  std::string service = std::to_string(port);
+  if (getaddrinfo(host, service.c_str(), &hints, &p_addr) != 0 ||
+      p_addr == nullptr) {
+    TraceLog(LOG_WARNING, "Couldn't resolve UDP address of %s:%u", host, port);
+    return -1;
+  }
+  int fd = socket(p_addr->ai_family, p_addr->ai_socktype | SOCK_NONBLOCK,
+                  p_addr->ai_protocol);
+  if (fd != -1 && connect(fd, p_addr->ai_addr, p_addr->ai_addrlen) == -1) {
+    close(fd);
+    fd = -1;
+  }
+  freeaddrinfo(p_addr);
+  if (fd == -1)
+    TraceLog(LOG_WARNING, "Couldn't connect UDP socket to %s:%u", host, port);
+  return fd;
+}
+
+bool ClientNetworkManager::send_datagram(const std::vector<uint8_t> &datagram) {
+  if (datagram.size() > DATAGRAM_MAX_SIZE)
+    return false;
+  // Lost datagrams aren't errors, a refused one (nothing listening) is
+  ssize_t sent = send(udpfd, datagram.data(), datagram.size(), 0);
+  return sent == (ssize_t)datagram.size() || errno == EAGAIN ||
+         errno == EWOULDBLOCK;
+}
+
+// Tells the server where to send datagrams to
+bool ClientNetworkManager::send_udp_hello() {
+  if (udpfd == -1)
+    return false;
+  std::vector<uint8_t> datagram;
+  write_datagram_header(datagram, {client_id, udp_token, ++udp_out_sequence});
+  write_uint32(datagram, NetworkEvents::NoEvent);
+  return send_datagram(datagram);
+}
+
+// Datagrams older than the last accepted one are discarded, their updates
+// have already been replaced
+void ClientNetworkManager::receive_datagrams() {
+  uint8_t buffer[DATAGRAM_MAX_SIZE];
+  while (true) {
+    ssize_t size = recv(udpfd, buffer, sizeof(buffer), 0);
+    if (size <= 0)
+      return;
+
+    InputBuffer in;
+    in.append(buffer, size);
+    InputCursor cursor(in);
+    DatagramHeader header;
+    if (read_datagram_header(cursor, header) != ReadStatus::Ok ||
+        header.token != udp_token) {
+      continue;
+    }
+    if (udp_received && !sequence_newer(header.sequence, udp_in_sequence)) {
+      TraceLog(LOG_DEBUG, "NET: Discarded out of order datagram %lu",
+               header.sequence);
+      continue;
+    }
+    udp_received = true;
+    udp_in_sequence = header.sequence;
+
+    uint32_t event, updated_player_id;
+    Movement movement;
+    if (cursor.read_uint32(event) != ReadStatus::Ok) {
+      TraceLog(LOG_WARNING, "NET: Couldn't decode datagram");
+      continue;
+    }
+    if (event == NetworkEvents::WorldSnapshot) {
+      apply_world_snapshot(cursor);
+      continue;
+    }
+    if (event != NetworkEvents::PlayerMovement ||
+        cursor.read_uint32(updated_player_id) != ReadStatus::Ok ||
+        read_value(cursor, movement, format, DATAGRAM_MAX_SIZE) !=
+            ReadStatus::Ok) {
+      TraceLog(LOG_WARNING, "NET: Couldn't decode datagram");
+      continue;
+    }
+    update_player_movement(updated_player_id, movement);
+  }
+}
+
+// Snapshots that didn't fit in a datagram come over TCP
+void ClientNetworkManager::handle_world_snapshot() {
+  uint32_t size;
+  if (!read_uint32(mainfd, size)) {
+    TraceLog(LOG_ERROR, "NET: Couldn't read snapshot size");
+    return;
+  }
+  const size_t max_size = Snapshot::max_delta_size(joinedRoom().type);
+  if (size > max_size) {
+    TraceLog(LOG_ERROR, "NET: Snapshot size %lu exceeds maximum %lu", size,
+             max_size);
+    return;
+  }
+  std::vector<uint8_t> body;
+  write_uint32(body, size);
+  body.resize(sizeof(uint32_t) + size);
+  ssize_t readb = recv(mainfd, body.data() + sizeof(uint32_t), size,
+                       MSG_WAITALL);
+  if (readb != (ssize_t)size) {
+    TraceLog(LOG_ERROR, "NET: Couldn't read full snapshot, received %ld/%lu",
+             readb, size);
+    return;
+  }
+  InputBuffer in;
+  in.append(body.data(), body.size());
+  InputCursor cursor(in);
+  apply_world_snapshot(cursor);
+}
+
+// Only a snapshot newer than the last applied one whose baseline is still
+// known can be decoded, the server resends against the last acknowledged
+void ClientNetworkManager::apply_world_snapshot(InputCursor &cursor) {
+  uint32_t id, baseline_id;
+  if (read_snapshot_header(cursor, id, baseline_id) != ReadStatus::Ok ||
+      id == 0) {
+    TraceLog(LOG_WARNING, "NET: Couldn't decode snapshot");
+    return;
+  }
+  if (snapshot_id != 0 && !sequence_newer(id, snapshot_id)) {
+    TraceLog(LOG_DEBUG, "NET: Discarded old snapshot %lu", id);
+    return;
+  }
+  // Laid out like the server's, for the joined room's type
+  RoomType type = joinedRoom().type;
+  if (snapshots.front().type != type)
+    snapshots.assign(Constants::SNAPSHOT_HISTORY, Snapshot(type));
+  const Snapshot &baseline =
+      baseline_id == 0
+          ? Snapshot::empty(type)
+          : snapshots.at(baseline_id % Constants::SNAPSHOT_HISTORY);
+  if (baseline.id != baseline_id) {
+    TraceLog(LOG_DEBUG, "NET: Snapshot %lu has unknown baseline %lu", id,
+             baseline_id);
+    return;
+  }
+
+  Snapshot &snapshot = snapshots.at(id % Constants::SNAPSHOT_HISTORY);
+  if (&snapshot == &baseline ||
+      read_snapshot_changes(cursor, baseline, snapshot) != ReadStatus::Ok) {
+    snapshot.id = 0;
+    TraceLog(LOG_WARNING, "NET: Couldn't decode snapshot %lu", id);
+    return;
+  }
+  snapshot.id = id;
+  snapshot_id = id;
+  send_snapshot_ack(id);
+
+  gameManager() = gameManagersPair.at(game_manager_draw_idx);
+  snapshot.apply(gameManager(), player_id.load());
+  gameManager().SnapToGrid();
+  {
+    std::lock_guard<std::mutex> lg(interpolation_mutex);
+    interpolation.record(gameManager(), player_id.load(), steady_clock::now());
+  }
+  flip_game_manager();
+  gameManager() = gameManagersPair.at(game_manager_draw_idx);
+}
+
+// The delay tells the server's lag compensation how far behind the others
+// are drawn
+bool ClientNetworkManager::send_snapshot_ack(uint32_t acked_snapshot_id) {
+  uint32_t delay_us;
+  {
+    std::lock_guard<std::mutex> lg(interpolation_mutex);
+    delay_us = duration_cast<microseconds>(interpolation.delay()).count();
+  }
+  if (udpfd != -1) {
+    std::vector<uint8_t> datagram;
+    write_datagram_header(datagram,
+                          {client_id, udp_token, ++udp_out_sequence});
+    write_uint32(datagram, NetworkEvents::SnapshotAck);
+    write_uint32(datagram, acked_snapshot_id);
+    write_uint32(datagram, delay_us);
+    if (send_datagram(datagram))
+      return true;
+  }
+  return setEvent(mainfd, NetworkEvents::SnapshotAck) &&
+         write_uint32(mainfd, acked_snapshot_id) &&
+         write_uint32(mainfd, delay_us);
+}
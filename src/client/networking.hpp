@@ -1,11 +1,16 @@
 #pragma once
+#include "binaryCodec.hpp"
+#include "datagram.hpp"
 #include "gameManager.hpp"
+#include "interpolation.hpp"
 #include "lockingQueue.hpp"
 #include "networkEvents.hpp"
 #include "room.hpp"
+#include "snapshot.hpp"
 #include <atomic>
 #include <cstdint>
 #include <fcntl.h>
+#include <mutex>
 #include <netdb.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
@@ -18,6 +23,36 @@ private:
   int epollfd;
   uint32_t client_id = 0;
 
+  // UDP side channel for movement, -1 if the server didn't accept it
+  int udpfd = -1;
+  uint32_t udp_token = 0;
+  uint32_t udp_out_sequence = 0;
+  uint32_t udp_in_sequence = 0; // Last accepted
+  bool udp_received = false;
+
+  uint32_t capabilities = 0; // Accepted by the server
+  WireFormat format = WireFormat::Json;
+  // Received snapshots by id % SNAPSHOT_HISTORY, baselines of the next ones
+  std::vector<Snapshot> snapshots =
+      std::vector<Snapshot>(Constants::SNAPSHOT_HISTORY);
+  uint32_t snapshot_id = 0; // Last applied
+
+  // Movement of the local player acknowledging its input states, taken by
+  // the game thread to reconcile the prediction
+  std::mutex local_movement_mutex;
+  Movement local_movement;
+  bool local_movement_pending = false;
+  // Set by a round start until the game thread restarts the prediction
+  bool round_started = false;
+  // Last input state sent over TCP
+  uint32_t input_sent_tick = 0;
+  uint32_t input_sent_buttons = InputNone;
+
+  // States of remote players and asteroids, drawn in between by the game
+  // thread
+  std::mutex interpolation_mutex;
+  InterpolationBuffer interpolation;
+
   inline uint8_t get_networks_idx(std::atomic_uint8_t &draw_idx) {
     return !draw_idx.load();
   }
@@ -52,6 +87,12 @@ private:
   // Main thread
   void perform_network_actions();
   void handle_network_event(uint32_t network_event);
+  void receive_datagrams();
+  bool send_datagram(const std::vector<uint8_t> &datagram);
+  bool send_udp_hello();
+  int connect_udp(const char *host, uint32_t port);
+  void apply_world_snapshot(InputCursor &cursor);
+  bool send_snapshot_ack(uint32_t acked_snapshot_id);
 
   // NetworkEvents handlers
   void handle_update_game_state();
@@ -66,6 +107,7 @@ private:
   void handle_return_to_lobby();
   void handle_vote_ready();
   void handle_player_movement();
+  void update_player_movement(uint32_t updated_player_id, Movement movement);
   void handle_update_bullets();
   void handle_update_room_state();
   void handle_leave_room();
@@ -73,6 +115,7 @@ private:
   void handle_shoot_bullets();
   void handle_get_room_list();
   void handle_start_round();
+  void handle_world_snapshot();
 
 public:
   LockingQueue<std::function<void(void)>> todo;
@@ -84,8 +127,15 @@ public:
   // Player
   bool get_new_client_id(uint32_t &new_client_id);
   bool send_vote_ready();
-  bool send_movement(Vector2 position, Vector2 velocity, float rotation);
-  bool send_shoot_bullet();
+  bool send_inputs(const std::vector<InputState> &states);
+  // false when no movement of the local player arrived since the last call
+  bool take_local_movement(Movement &movement);
+  // true once after each round start, the prediction then starts over
+  bool take_round_start();
+  // Moves the remote players and asteroids of gm to where they were the
+  // interpolation delay ago, gm is only drawn
+  void interpolate(GameManager &gm);
+  void set_interpolation_margin(milliseconds min_margin);
 
   // Room
   bool get_rooms();
@@ -1,60 +1,119 @@
 #include "asteroid.hpp"
-#include "spaceJunkCollector.hpp"
+#include "fixedPoint.hpp"
 #include <raymath.h>
 #include <vec2json.hpp>
 
-Asteroid CreateAsteroid(Vector2 position, Vector2 velocity, int size) {
-  velocity =
-      Vector2Length(velocity) == 0 ? GetRandomVelocity(position) : velocity;
+Asteroid CreateAsteroid(RoomRandom &random, Vector2 position, Vector2 velocity,
+                        int size) {
   Asteroid asteroid;
   asteroid.active = true;
   asteroid.position = position;
   asteroid.velocity = velocity;
-  asteroid.rotation = (float)GetRandomValue(0, 360);
+  asteroid.rotation = (float)random.value(0, 360);
   asteroid.rotation_speed =
-      (float)GetRandomValue(-Constants::ASTEROID_ROTATION_SPEED_MAX,
-                            Constants::ASTEROID_ROTATION_SPEED_MAX);
+      (float)random.value(-Constants::ASTEROID_ROTATION_SPEED_MAX,
+                          Constants::ASTEROID_ROTATION_SPEED_MAX);
   asteroid.size = size;
-  asteroid.polygon = GetRandomValue(Constants::ASTEROID_POLYGON_MIN,
-                                    Constants::ASTEROID_POLYGON_MAX);
+  asteroid.polygon = random.value(Constants::ASTEROID_POLYGON_MIN,
+                                  Constants::ASTEROID_POLYGON_MAX);
   return asteroid;
 }
 
-void UpdateAsteroid(Asteroid &asteroid, duration<double> frametime) {
-  if (!asteroid.active)
-    return;
+void AsteroidArrays::resize(size_t count) {
+  size_t padded = PaddedSlots(count);
+  for (auto *v : {&x, &y, &vx, &vy, &rotation, &rotation_speed})
+    v->resize(padded);
+  size.resize(padded);
+  polygon.resize(padded);
+  spawns.resize(padded);
+  active.resize(count, padded);
+  slots = count;
+}
+
+Asteroid AsteroidArrays::at(size_t i) const {
+  if (i >= slots)
+    throw std::out_of_range("asteroid slot");
+  return Asteroid{is_active(i), position(i), velocity(i), rotation[i],
+                  rotation_speed[i], size[i], polygon[i]};
+}
+
+void AsteroidArrays::set(size_t i, const Asteroid &a) {
+  if (i >= slots)
+    throw std::out_of_range("asteroid slot");
+  active.set(i, a.active);
+  x[i] = a.position.x;
+  y[i] = a.position.y;
+  vx[i] = a.velocity.x;
+  vy[i] = a.velocity.y;
+  rotation[i] = a.rotation;
+  rotation_speed[i] = a.rotation_speed;
+  size[i] = a.size;
+  polygon[i] = a.polygon;
+}
+
+void AsteroidArrays::spawn(size_t i, const Asteroid &a) {
+  set(i, a);
+  spawns[i]++;
+}
 
-  if (SpaceJunkCollector(asteroid.position)) {
-    asteroid.active = false;
-    return;
-  }
+void AsteroidArrays::deactivate(size_t i) {
+  if (i >= slots)
+    throw std::out_of_range("asteroid slot");
+  active.set(i, false);
+}
 
-  asteroid.position = Vector2Add(
-      asteroid.position, Vector2Scale(asteroid.velocity, frametime.count()));
-  asteroid.rotation += asteroid.rotation_speed * frametime.count();
+void AsteroidArrays::assign(const std::vector<Asteroid> &asteroids) {
+  resize(0);
+  resize(asteroids.size());
+  for (size_t i = 0; i < asteroids.size(); i++)
+    set(i, asteroids[i]);
 }
 
-Vector2 GetRandomPosition() {
-  int side = GetRandomValue(-1, 2);
+Vector2 GetRandomPosition(RoomRandom &random) {
+  int side = random.value(-1, 2);
   if (side % 2)
     return Vector2{float(side) * Constants::ASTEROID_SIZE_MAX +
                        float(side + 1) / 2.0f * Constants::screenWidth,
-                   (float)GetRandomValue(0, Constants::screenHeight)};
-  return Vector2{(float)GetRandomValue(0, Constants::screenWidth),
+                   (float)random.value(0, Constants::screenHeight)};
+  return Vector2{(float)random.value(0, Constants::screenWidth),
                  float(side - 1) * Constants::ASTEROID_SIZE_MAX +
                      float(side) / 2.0f * Constants::screenHeight};
 }
 
-Vector2 GetRandomVelocity(Vector2 position) {
+Vector2 GetRandomVelocity(Vector2 position, RoomRandom &random) {
   Vector2 velocity = Vector2Subtract(
       {(float)Constants::screenWidth / 2, (float)Constants::screenHeight / 2},
       position);
   velocity = Vector2Scale(Vector2Normalize(velocity),
-                          GetRandomValue(Constants::ASTEROID_SPEED_MIN,
-                                         Constants::ASTEROID_SPEED_MAX));
+                          random.value(Constants::ASTEROID_SPEED_MIN,
+                                       Constants::ASTEROID_SPEED_MAX));
   return Vector2Rotate(velocity,
-                       GetRandomValue(-Constants::ASTEROID_PATH_RANDOM_ANGLE,
-                                      Constants::ASTEROID_PATH_RANDOM_ANGLE));
+                       random.value(-Constants::ASTEROID_PATH_RANDOM_ANGLE,
+                                    Constants::ASTEROID_PATH_RANDOM_ANGLE));
+}
+
+Vector2 GetFixedRandomVelocity(Vector2 position, RoomRandom &random) {
+  FixedVector2 from = ToFixed(position);
+  FixedVector2 to = {Constants::screenWidth * FIXED_ONE / 2,
+                     Constants::screenHeight * FIXED_ONE / 2};
+  FixedVector2 velocity = FixedScaleTo(
+      {to.x - from.x, to.y - from.y},
+      random.value(Constants::ASTEROID_SPEED_MIN,
+                   Constants::ASTEROID_SPEED_MAX) *
+          FIXED_ONE);
+  return FromFixed(FixedRotate(
+      velocity, random.value(-Constants::ASTEROID_PATH_RANDOM_ANGLE,
+                             Constants::ASTEROID_PATH_RANDOM_ANGLE) *
+                    FIXED_DEGREES_PER_RADIAN));
+}
+
+size_t AsteroidArrays::heap_bytes() const {
+  size_t bytes = active.words.capacity() * sizeof(uint64_t);
+  for (auto *v : {&x, &y, &vx, &vy, &rotation, &rotation_speed})
+    bytes += v->capacity() * sizeof(float);
+  bytes += (size.capacity() + polygon.capacity()) * sizeof(int);
+  bytes += spawns.capacity() * sizeof(uint32_t);
+  return bytes;
 }
 
 void to_json(json &j, const Asteroid &a) {
@@ -75,3 +134,13 @@ void from_json(const json &j, Asteroid &a) {
   j.at("size").get_to(a.size);
   j.at("polygon").get_to(a.polygon);
 }
+
+void to_json(json &j, const AsteroidArrays &a) {
+  j = json::array();
+  for (size_t i = 0; i < a.count(); i++)
+    j.push_back(a.at(i));
+}
+
+void from_json(const json &j, AsteroidArrays &a) {
+  a.assign(j.get<std::vector<Asteroid>>());
+}
@@ -1,5 +1,7 @@
 #pragma once
 #include "constants.hpp"
+#include "integration.hpp"
+#include "roomRandom.hpp"
 #include <nlohmann/json.hpp>
 #include <raylib.h>
 
@@ -15,17 +17,49 @@ struct Asteroid {
   int polygon;
 };
 
-Vector2 GetRandomPosition();
+// Asteroid slots stored field by field for the integration kernels.
+// Asteroid stays the form they are created, sent and drawn in.
+struct AsteroidArrays {
+  size_t slots = 0;
+  std::vector<float> x, y, vx, vy, rotation, rotation_speed;
+  std::vector<int> size, polygon;
+  // Asteroids put into each slot so far, tells apart the ones that took
+  // over a slot. Only counted by spawn() and carried by snapshots.
+  std::vector<uint32_t> spawns;
+  ActiveMask active;
 
-Vector2 GetRandomVelocity(Vector2 position);
+  AsteroidArrays() = default;
+  explicit AsteroidArrays(size_t count) { resize(count); }
 
-Asteroid
-CreateAsteroid(Vector2 position = GetRandomPosition(),
-               Vector2 velocity = {0, 0},
-               int size = GetRandomValue(Constants::ASTEROID_SIZE_MIN,
-                                         Constants::ASTEROID_SIZE_MAX));
+  // New slots are inactive
+  void resize(size_t count);
+  size_t count() const { return slots; }
+  bool is_active(size_t i) const { return active.test(i); }
+  Vector2 position(size_t i) const { return {x[i], y[i]}; }
+  Vector2 velocity(size_t i) const { return {vx[i], vy[i]}; }
 
-void UpdateAsteroid(Asteroid &asteroid, duration<double> frametime);
+  // Bounds checked like std::vector::at
+  Asteroid at(size_t i) const;
+  void set(size_t i, const Asteroid &a);
+  // set() of a new asteroid
+  void spawn(size_t i, const Asteroid &a);
+  void deactivate(size_t i);
+  void assign(const std::vector<Asteroid> &asteroids);
+  // Allocated by the arrays
+  size_t heap_bytes() const;
+};
+
+Vector2 GetRandomPosition(RoomRandom &random);
+
+Vector2 GetRandomVelocity(Vector2 position, RoomRandom &random);
+// Of an asteroid in a deterministic round, on the fixed-point grid
+Vector2 GetFixedRandomVelocity(Vector2 position, RoomRandom &random);
+
+// Random rotation, rotation speed and polygon
+Asteroid CreateAsteroid(RoomRandom &random, Vector2 position, Vector2 velocity,
+                        int size);
 
 void to_json(json &j, const Asteroid &a);
 void from_json(const json &j, Asteroid &a);
+void to_json(json &j, const AsteroidArrays &a);
+void from_json(const json &j, AsteroidArrays &a);
@@ -0,0 +1,465 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "bitstream.hpp"
+#include "gameManager.hpp"
+#include "inputBuffer.hpp"
+#include "jsonutils.hpp"
+#include "outputBuffer.hpp"
+#include "player.hpp"
+#include "room.hpp"
+
+// Encoding of structured payloads (rooms, players, game state...), chosen
+// per connection in the handshake. All are prefixed with their size like
+// any other frame word; BSON-wrapped json stays available for debugging.
+enum class WireFormat : uint8_t { Json, Binary, Quantized };
+const static size_t WIRE_FORMATS = 3;
+
+// Binary layout generated from the field lists below: fields in the listed
+// order, no padding, little-endian. bool and uint8_t take 1 byte, other
+// integers, enums and floats 4. Strings, vectors and maps are a uint32
+// count followed by their elements. Slot arrays are sent like a vector of
+// their structs.
+//
+// The quantized layout is the same bitstream, except that fields listed
+// with a quantization take only its bits and bools take 1 bit. Only the
+// end of the whole payload is padded to a byte.
+namespace codec {
+
+struct NotQuantized {};
+// Unsigned integer in fewer bits
+struct Bits {
+  unsigned bits;
+};
+struct Quantization2 {
+  Quantization x;
+  Quantization y;
+};
+
+// Ranges and precision of quantized fields, Quantization::max_error() is
+// the worst case reconstruction error
+constexpr Quantization2 POSITION = {
+    {-Constants::ASTEROID_SIZE_MAX,
+     Constants::screenWidth + Constants::ASTEROID_SIZE_MAX, 12},
+    {-Constants::ASTEROID_SIZE_MAX,
+     Constants::screenHeight + Constants::ASTEROID_SIZE_MAX, 12}};
+constexpr Quantization2 VELOCITY = {{-4096, 4096, 14}, {-4096, 4096, 14}};
+constexpr Quantization ANGLE = {0, 360, 12, true};
+constexpr Quantization ANGULAR_VELOCITY = {-512, 512, 12};
+
+template <class T, class M, class Q> struct Field {
+  const char *name;
+  M T::*member;
+  Q quantization;
+};
+
+template <class T, class M>
+constexpr Field<T, M, NotQuantized> field(const char *name, M T::*member) {
+  return {name, member, {}};
+}
+
+template <class T, class M, class Q>
+constexpr Field<T, M, Q> field(const char *name, M T::*member, Q q) {
+  return {name, member, q};
+}
+
+// Specialized for every struct that is sent in binary
+template <class T> struct Fields;
+
+template <> struct Fields<Vector2> {
+  static constexpr auto list =
+      std::make_tuple(field("x", &Vector2::x), field("y", &Vector2::y));
+};
+
+template <> struct Fields<Color> {
+  static constexpr auto list =
+      std::make_tuple(field("r", &Color::r), field("g", &Color::g),
+                      field("b", &Color::b), field("a", &Color::a));
+};
+
+template <> struct Fields<Asteroid> {
+  static constexpr auto list = std::make_tuple(
+      field("active", &Asteroid::active),
+      field("position", &Asteroid::position, POSITION),
+      field("velocity", &Asteroid::velocity, VELOCITY),
+      field("rotation", &Asteroid::rotation, ANGLE),
+      field("rotation_speed", &Asteroid::rotation_speed, ANGULAR_VELOCITY),
+      field("size", &Asteroid::size, Bits{7}),
+      field("polygon", &Asteroid::polygon, Bits{4}));
+};
+
+template <> struct Fields<Player> {
+  static constexpr auto list = std::make_tuple(
+      field("player_id", &Player::player_id, Bits{8}),
+      field("active", &Player::active),
+      field("position", &Player::position, POSITION),
+      field("velocity", &Player::velocity, VELOCITY),
+      field("rotation", &Player::rotation, ANGLE),
+      field("player_color", &Player::player_color));
+};
+
+template <> struct Fields<Bullet> {
+  static constexpr auto list = std::make_tuple(
+      field("active", &Bullet::active),
+      field("position", &Bullet::position, POSITION),
+      field("rotation", &Bullet::rotation, ANGLE));
+};
+
+template <> struct Fields<Movement> {
+  static constexpr auto list = std::make_tuple(
+      field("position", &Movement::position, POSITION),
+      field("velocity", &Movement::velocity, VELOCITY),
+      field("rotation", &Movement::rotation, ANGLE),
+      field("active", &Movement::active),
+      field("input_tick", &Movement::input_tick));
+};
+
+template <> struct Fields<InputState> {
+  static constexpr auto list =
+      std::make_tuple(field("tick", &InputState::tick),
+                      field("buttons", &InputState::buttons, Bits{4}));
+};
+
+template <> struct Fields<PlayerIdState> {
+  static constexpr auto list =
+      std::make_tuple(field("player_id", &PlayerIdState::player_id),
+                      field("state", &PlayerIdState::state));
+};
+
+template <> struct Fields<Room> {
+  static constexpr auto list = std::make_tuple(
+      field("room_id", &Room::room_id), field("players", &Room::players),
+      field("status", &Room::status), field("name", &Room::name),
+      field("type", &Room::type), field("tick_rate", &Room::tick_rate),
+      field("deterministic", &Room::deterministic),
+      field("seed", &Room::seed));
+};
+
+template <> struct Fields<GameManager> {
+  static constexpr auto list = std::make_tuple(
+      field("room_id", &GameManager::room_id),
+      field("asteroids", &GameManager::asteroids),
+      field("players", &GameManager::players),
+      field("bullets", &GameManager::bullets),
+      field("winner_player_id", &GameManager::winner_player_id));
+};
+
+template <class T> struct is_vector : std::false_type {};
+template <class T> struct is_vector<std::vector<T>> : std::true_type {};
+template <class T> struct is_map : std::false_type {};
+template <class K, class V>
+struct is_map<std::map<K, V>> : std::true_type {};
+template <class T> struct slot_element {
+  using type = void;
+};
+template <> struct slot_element<AsteroidArrays> {
+  using type = Asteroid;
+};
+template <> struct slot_element<BulletArrays> {
+  using type = Bullet;
+};
+template <class T>
+constexpr bool is_slot_array =
+    !std::is_void_v<typename slot_element<T>::type>;
+
+struct Encoder {
+  BitWriter bits;
+  bool quantized;
+};
+
+template <class T> void encode(Encoder &out, const T &v) {
+  if constexpr (std::is_same_v<T, bool>) {
+    out.bits.write(v, out.quantized ? 1 : 8);
+  } else if constexpr (std::is_same_v<T, uint8_t>) {
+    out.bits.write(v, 8);
+  } else if constexpr (std::is_enum_v<T> || std::is_integral_v<T>) {
+    static_assert(sizeof(T) == sizeof(uint32_t));
+    out.bits.write((uint32_t)v, 32);
+  } else if constexpr (std::is_same_v<T, float>) {
+    uint32_t w;
+    memcpy(&w, &v, sizeof(w));
+    out.bits.write(w, 32);
+  } else if constexpr (std::is_same_v<T, std::string>) {
+    out.bits.write(v.size(), 32);
+    for (char c : v)
+      out.bits.write((uint8_t)c, 8);
+  } else if constexpr (is_vector<T>::value) {
+    out.bits.write(v.size(), 32);
+    for (auto &e : v)
+      encode(out, e);
+  } else if constexpr (is_map<T>::value) {
+    out.bits.write(v.size(), 32);
+    for (auto &[key, value] : v) {
+      encode(out, key);
+      encode(out, value);
+    }
+  } else if constexpr (is_slot_array<T>) {
+    out.bits.write(v.count(), 32);
+    for (size_t i = 0; i < v.count(); i++)
+      encode(out, v.at(i));
+  } else {
+    std::apply(
+        [&](auto... f) {
+          (encode_field(out, v.*(f.member), f.quantization), ...);
+        },
+        Fields<T>::list);
+  }
+}
+
+template <class M>
+void encode_field(Encoder &out, const M &v, NotQuantized) {
+  encode(out, v);
+}
+
+template <class M> void encode_field(Encoder &out, const M &v, Bits q) {
+  if (out.quantized)
+    out.bits.write((uint32_t)v, q.bits);
+  else
+    encode(out, v);
+}
+
+inline void encode_field(Encoder &out, float v, const Quantization &q) {
+  if (out.quantized)
+    out.bits.write(q.quantize(v), q.bits);
+  else
+    encode(out, v);
+}
+
+inline void encode_field(Encoder &out, const Vector2 &v,
+                         const Quantization2 &q) {
+  encode_field(out, v.x, q.x);
+  encode_field(out, v.y, q.y);
+}
+
+struct Decoder {
+  BitReader bits;
+  bool quantized;
+
+  // Every element takes at least a bit, larger counts are corrupt
+  bool get_count(uint32_t &count) {
+    return bits.read(count, 32) && count <= bits.remaining_bits();
+  }
+};
+
+template <class T> bool decode(Decoder &in, T &v) {
+  uint32_t w;
+  if constexpr (std::is_same_v<T, bool>) {
+    if (!in.bits.read(w, in.quantized ? 1 : 8))
+      return false;
+    v = w;
+    return true;
+  } else if constexpr (std::is_same_v<T, uint8_t>) {
+    if (!in.bits.read(w, 8))
+      return false;
+    v = w;
+    return true;
+  } else if constexpr (std::is_enum_v<T> || std::is_integral_v<T>) {
+    if (!in.bits.read(w, 32))
+      return false;
+    v = (T)w;
+    return true;
+  } else if constexpr (std::is_same_v<T, float>) {
+    if (!in.bits.read(w, 32))
+      return false;
+    memcpy(&v, &w, sizeof(v));
+    return true;
+  } else if constexpr (std::is_same_v<T, std::string>) {
+    uint32_t size;
+    if (!in.get_count(size))
+      return false;
+    v.resize(size);
+    for (auto &c : v) {
+      if (!in.bits.read(w, 8))
+        return false;
+      c = (char)w;
+    }
+    return true;
+  } else if constexpr (is_vector<T>::value) {
+    uint32_t count;
+    if (!in.get_count(count))
+      return false;
+    v.resize(count);
+    for (auto &e : v) {
+      if (!decode(in, e))
+        return false;
+    }
+    return true;
+  } else if constexpr (is_map<T>::value) {
+    uint32_t count;
+    if (!in.get_count(count))
+      return false;
+    v.clear();
+    for (uint32_t i = 0; i < count; i++) {
+      typename T::key_type key;
+      if (!decode(in, key) || !decode(in, v[key]))
+        return false;
+    }
+    return true;
+  } else if constexpr (is_slot_array<T>) {
+    uint32_t count;
+    if (!in.get_count(count))
+      return false;
+    v.resize(0);
+    v.resize(count);
+    for (uint32_t i = 0; i < count; i++) {
+      typename slot_element<T>::type e;
+      if (!decode(in, e))
+        return false;
+      v.set(i, e);
+    }
+    return true;
+  } else {
+    return std::apply(
+        [&](auto... f) {
+          return (decode_field(in, v.*(f.member), f.quantization) && ...);
+        },
+        Fields<T>::list);
+  }
+}
+
+template <class M> bool decode_field(Decoder &in, M &v, NotQuantized) {
+  return decode(in, v);
+}
+
+template <class M> bool decode_field(Decoder &in, M &v, Bits q) {
+  if (!in.quantized)
+    return decode(in, v);
+  uint32_t w;
+  if (!in.bits.read(w, q.bits))
+    return false;
+  v = (M)w;
+  return true;
+}
+
+inline bool decode_field(Decoder &in, float &v, const Quantization &q) {
+  if (!in.quantized)
+    return decode(in, v);
+  uint32_t w;
+  if (!in.bits.read(w, q.bits))
+    return false;
+  v = q.dequantize(w);
+  return true;
+}
+
+inline bool decode_field(Decoder &in, Vector2 &v, const Quantization2 &q) {
+  return decode_field(in, v.x, q.x) && decode_field(in, v.y, q.y);
+}
+
+// Whole payload, trailing bytes or bits make it invalid
+template <class T>
+bool decode_payload(const uint8_t *first, const uint8_t *last, T &value,
+                    WireFormat format) {
+  Decoder in{BitReader(first, last), format == WireFormat::Quantized};
+  return decode(in, value) && in.bits.finished();
+}
+
+} // namespace codec
+
+// Length prefixed payload in the given format, returns true if ok
+template <class T>
+bool write_value(std::vector<uint8_t> &out, const T &value,
+                 WireFormat format) {
+  if (format == WireFormat::Json)
+    return write_json(out, json(value));
+  size_t size_pos = out.size();
+  write_uint32(out, 0);
+  codec::Encoder encoder{BitWriter(out), format == WireFormat::Quantized};
+  codec::encode(encoder, value);
+  encoder.bits.flush();
+  uint32_t size = htonl(out.size() - size_pos - sizeof(uint32_t));
+  memcpy(out.data() + size_pos, &size, sizeof(size));
+  return true;
+}
+
+template <class T>
+bool write_value(OutputBuffer &out, const T &value, WireFormat format) {
+  std::vector<uint8_t> bytes;
+  if (!write_value(bytes, value, format))
+    return false;
+  out.append(bytes.data(), bytes.size());
+  return true;
+}
+
+template <class T> bool write_value(int fd, const T &value, WireFormat format) {
+  if (format == WireFormat::Json)
+    return write_json(fd, json(value));
+  std::vector<uint8_t> bytes;
+  write_value(bytes, value, format);
+  ssize_t written = write(fd, bytes.data(), bytes.size());
+  return written == (ssize_t)bytes.size();
+}
+
+// maxsize is optional, disable this check by passing -1
+template <class T>
+ReadStatus read_value(InputCursor &cursor, T &value, WireFormat format,
+                      size_t maxsize) {
+  if (format == WireFormat::Json) {
+    json j;
+    ReadStatus status = cursor.read_json(j, maxsize);
+    if (status != ReadStatus::Ok)
+      return status;
+    try {
+      j.get_to(value);
+    } catch (json::exception &ex) {
+      return ReadStatus::Invalid;
+    }
+    return ReadStatus::Ok;
+  }
+  uint32_t size;
+  ReadStatus status = cursor.read_uint32(size);
+  if (status != ReadStatus::Ok)
+    return status;
+  if (size > maxsize)
+    return ReadStatus::Invalid;
+  if (cursor.in.data.size() - cursor.pos < size)
+    return ReadStatus::Incomplete;
+  const uint8_t *first = cursor.in.data.data() + cursor.pos;
+  cursor.pos += size;
+  return codec::decode_payload(first, first + size, value, format)
+             ? ReadStatus::Ok
+             : ReadStatus::Invalid;
+}
+
+// Blocking read from a socket, returns true if ok
+template <class T>
+bool read_value(int fd, T &value, WireFormat format, size_t maxsize) {
+  if (format == WireFormat::Json) {
+    json j;
+    if (!read_json(fd, j, maxsize))
+      return false;
+    try {
+      j.get_to(value);
+    } catch (json::exception &ex) {
+      TraceLog(LOG_ERROR, "JSON: Couldn't deserialize json");
+      return false;
+    }
+    return true;
+  }
+  uint32_t size;
+  if (!read_uint32(fd, size) || size > maxsize) {
+    TraceLog(LOG_ERROR, "NET: Couldn't read payload size");
+    return false;
+  }
+  std::vector<uint8_t> bytes(size);
+  ssize_t readb = recv(fd, bytes.data(), size, MSG_WAITALL);
+  if (readb != (ssize_t)size) {
+    TraceLog(LOG_ERROR, "NET: Couldn't read full payload, received %ld/%lu",
+             readb, size);
+    return false;
+  }
+  if (!codec::decode_payload(bytes.data(), bytes.data() + bytes.size(), value,
+                             format)) {
+    TraceLog(LOG_ERROR, "NET: Couldn't decode binary payload");
+    return false;
+  }
+  return true;
+}
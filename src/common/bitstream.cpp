@@ -0,0 +1,78 @@
+#include "bitstream.hpp"
+#include <algorithm>
+#include <cmath>
+
+// Steps between min and max. Both ends of a clamped range are codes, a
+// wrapping one reaches max back at code 0.
+static float intervals(const Quantization &q) {
+  const uint32_t steps = 1u << q.bits;
+  return q.wrap ? steps : steps - 1;
+}
+
+uint32_t Quantization::quantize(float value) const {
+  const uint32_t steps = 1u << bits;
+  float t = (value - min) / (max - min);
+  if (!std::isfinite(t))
+    return 0;
+  if (wrap)
+    t -= std::floor(t);
+  else
+    t = std::clamp(t, 0.0f, 1.0f);
+  uint32_t q = (uint32_t)std::lround(t * intervals(*this));
+  return q >= steps ? 0 : q;
+}
+
+float Quantization::dequantize(uint32_t q) const {
+  return min + (max - min) * q / intervals(*this);
+}
+
+float Quantization::max_error() const {
+  return (max - min) / intervals(*this) / 2;
+}
+
+void BitWriter::write(uint32_t value, unsigned bits) {
+  // Byte aligned words, all of the unquantized layout
+  if (pending_bits == 0 && bits == 32) {
+    uint8_t bytes[4] = {(uint8_t)value, (uint8_t)(value >> 8),
+                        (uint8_t)(value >> 16), (uint8_t)(value >> 24)};
+    out.insert(out.end(), bytes, bytes + sizeof(bytes));
+    return;
+  }
+  if (bits < 32)
+    value &= (1u << bits) - 1;
+  pending |= (uint64_t)value << pending_bits;
+  pending_bits += bits;
+  while (pending_bits >= 8) {
+    out.push_back((uint8_t)pending);
+    pending >>= 8;
+    pending_bits -= 8;
+  }
+}
+
+void BitWriter::flush() {
+  if (pending_bits > 0)
+    out.push_back((uint8_t)pending);
+  pending = 0;
+  pending_bits = 0;
+}
+
+bool BitReader::read(uint32_t &value, unsigned bits) {
+  if (pending_bits == 0 && bits == 32) {
+    if (end - pos < 4)
+      return false;
+    value = pos[0] | pos[1] << 8 | pos[2] << 16 | (uint32_t)pos[3] << 24;
+    pos += 4;
+    return true;
+  }
+  while (pending_bits < bits) {
+    if (pos == end)
+      return false;
+    pending |= (uint64_t)*pos++ << pending_bits;
+    pending_bits += 8;
+  }
+  value = bits < 32 ? (uint32_t)pending & ((1u << bits) - 1)
+                    : (uint32_t)pending;
+  pending >>= bits;
+  pending_bits -= bits;
+  return true;
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Fixed point representation of a float in [min, max] with the given number
+// of bits, the codes spread evenly from min to max. Values outside are
+// clamped, or wrapped for angles, where max is min again.
+struct Quantization {
+  float min;
+  float max;
+  unsigned bits;
+  bool wrap = false;
+
+  uint32_t quantize(float value) const;
+  float dequantize(uint32_t q) const;
+  // Largest difference between a value in range and its reconstruction
+  float max_error() const;
+};
+
+// Bits appended least significant first, so whole bytes written at byte
+// boundaries read back as little-endian
+struct BitWriter {
+  std::vector<uint8_t> &out;
+  uint64_t pending = 0;
+  unsigned pending_bits = 0;
+
+  explicit BitWriter(std::vector<uint8_t> &out) : out(out) {}
+
+  void write(uint32_t value, unsigned bits);
+  // Pads the last byte with zero bits
+  void flush();
+};
+
+struct BitReader {
+  const uint8_t *pos;
+  const uint8_t *end;
+  uint64_t pending = 0;
+  unsigned pending_bits = 0;
+
+  BitReader(const uint8_t *pos, const uint8_t *end) : pos(pos), end(end) {}
+
+  bool read(uint32_t &value, unsigned bits);
+  size_t remaining_bits() const { return (end - pos) * 8 + pending_bits; }
+  // True once only the zero padding of the last byte is left
+  bool finished() const { return pos == end && pending_bits < 8 && !pending; }
+};
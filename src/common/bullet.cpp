@@ -1,6 +1,5 @@
 #include "bullet.hpp"
 #include "constants.hpp"
-#include "spaceJunkCollector.hpp"
 #include "vec2json.hpp"
 #include <raymath.h>
 
@@ -12,19 +11,49 @@ Bullet CreateBullet(Vector2 position, float rotation) {
   return bullet;
 }
 
-void UpdateBullet(Bullet &bullet, duration<double> frametime) {
-  if (!bullet.active)
-    return;
+void BulletArrays::resize(size_t count) {
+  size_t padded = PaddedSlots(count);
+  for (auto *v : {&x, &y, &vx, &vy, &rotation})
+    v->resize(padded);
+  active.resize(count, padded);
+  slots = count;
+}
+
+Bullet BulletArrays::at(size_t i) const {
+  if (i >= slots)
+    throw std::out_of_range("bullet slot");
+  return Bullet{is_active(i), position(i), rotation[i]};
+}
+
+void BulletArrays::set(size_t i, const Bullet &b) {
+  if (i >= slots)
+    throw std::out_of_range("bullet slot");
+  active.set(i, b.active);
+  x[i] = b.position.x;
+  y[i] = b.position.y;
+  rotation[i] = b.rotation;
+  vx[i] = Constants::BULLET_SPEED * cosf(b.rotation * DEG2RAD);
+  vy[i] = Constants::BULLET_SPEED * sinf(b.rotation * DEG2RAD);
+}
+
+void BulletArrays::deactivate(size_t i) {
+  if (i >= slots)
+    throw std::out_of_range("bullet slot");
+  active.set(i, false);
+}
 
-  if (SpaceJunkCollector(bullet.position)) {
-    bullet.active = false;
-    return;
-  }
+void BulletArrays::assign(const std::vector<Bullet> &bullets) {
+  resize(0);
+  resize(bullets.size());
+  for (size_t i = 0; i < bullets.size(); i++)
+    set(i, bullets[i]);
+}
 
-  bullet.position.x += Constants::BULLET_SPEED * frametime.count() *
-                       cos(bullet.rotation * DEG2RAD);
-  bullet.position.y += Constants::BULLET_SPEED * frametime.count() *
-                       sin(bullet.rotation * DEG2RAD);
+size_t BulletArrays::heap_bytes() const {
+  size_t bytes = active.words.capacity() * sizeof(uint64_t);
+  for (auto *v : {&x, &y, &vx, &vy, &rotation})
+    bytes += v->capacity() * sizeof(float);
+  return bytes;
 }
 
 void to_json(json &j, const Bullet &b) {
@@ -36,3 +65,13 @@ void from_json(const json &j, Bullet &b) {
   j.at("position").get_to(b.position);
   j.at("rotation").get_to(b.rotation);
 }
+
+void to_json(json &j, const BulletArrays &b) {
+  j = json::array();
+  for (size_t i = 0; i < b.count(); i++)
+    j.push_back(b.at(i));
+}
+
+void from_json(const json &j, BulletArrays &b) {
+  b.assign(j.get<std::vector<Bullet>>());
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include "integration.hpp"
 #include "raylib.h"
 #include <chrono>
 #include <nlohmann/json.hpp>
@@ -12,9 +13,34 @@ struct Bullet {
   float rotation;
 };
 
-Bullet CreateBullet(Vector2 position, float rotation);
+// Bullet slots stored field by field. The velocity follows from the
+// rotation and is computed once when a bullet is set.
+struct BulletArrays {
+  size_t slots = 0;
+  std::vector<float> x, y, vx, vy, rotation;
+  ActiveMask active;
+
+  BulletArrays() = default;
+  explicit BulletArrays(size_t count) { resize(count); }
+
+  // New slots are inactive
+  void resize(size_t count);
+  size_t count() const { return slots; }
+  bool is_active(size_t i) const { return active.test(i); }
+  Vector2 position(size_t i) const { return {x[i], y[i]}; }
 
-void UpdateBullet(Bullet &bullet, duration<double> frametime);
+  // Bounds checked like std::vector::at
+  Bullet at(size_t i) const;
+  void set(size_t i, const Bullet &b);
+  void deactivate(size_t i);
+  void assign(const std::vector<Bullet> &bullets);
+  // Allocated by the arrays
+  size_t heap_bytes() const;
+};
+
+Bullet CreateBullet(Vector2 position, float rotation);
 
 void to_json(json &j, const Bullet &b);
 void from_json(const json &j, Bullet &b);
+void to_json(json &j, const BulletArrays &b);
+void from_json(const json &j, BulletArrays &b);
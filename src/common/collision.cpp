@@ -0,0 +1,104 @@
+#include "collision.hpp"
+#include "fixedPoint.hpp"
+#include <cassert>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// Bits of the first count lanes
+static uint64_t first_bits(uint64_t bits, size_t count) {
+  return count < 64 ? bits & ((uint64_t(1) << count) - 1) : bits;
+}
+
+#if defined(__AVX2__)
+
+uint64_t CircleHits(Vector2 center, float radius, const float *x,
+                    const float *y, float block_radius, size_t count) {
+  assert(count <= 64);
+  const float sum = radius + block_radius;
+  const __m256 cx = _mm256_set1_ps(center.x), cy = _mm256_set1_ps(center.y);
+  const __m256 reach = _mm256_set1_ps(sum * sum);
+  uint64_t hits = 0;
+  for (size_t i = 0; i < count; i += 8) {
+    __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(x + i), cx);
+    __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(y + i), cy);
+    __m256 distance =
+        _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+    hits |= uint64_t(_mm256_movemask_ps(
+                _mm256_cmp_ps(distance, reach, _CMP_LE_OQ)))
+            << i;
+  }
+  return first_bits(hits, count);
+}
+
+const char *CollisionKernels() { return "AVX2"; }
+
+#elif defined(__SSE2__)
+
+uint64_t CircleHits(Vector2 center, float radius, const float *x,
+                    const float *y, float block_radius, size_t count) {
+  assert(count <= 64);
+  const float sum = radius + block_radius;
+  const __m128 cx = _mm_set1_ps(center.x), cy = _mm_set1_ps(center.y);
+  const __m128 reach = _mm_set1_ps(sum * sum);
+  uint64_t hits = 0;
+  for (size_t i = 0; i < count; i += 4) {
+    __m128 dx = _mm_sub_ps(_mm_loadu_ps(x + i), cx);
+    __m128 dy = _mm_sub_ps(_mm_loadu_ps(y + i), cy);
+    __m128 distance = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+    hits |= uint64_t(_mm_movemask_ps(_mm_cmple_ps(distance, reach))) << i;
+  }
+  return first_bits(hits, count);
+}
+
+const char *CollisionKernels() { return "SSE2"; }
+
+#else
+
+uint64_t CircleHits(Vector2 center, float radius, const float *x,
+                    const float *y, float block_radius, size_t count) {
+  assert(count <= 64);
+  uint64_t hits = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (CheckCollisionCircles(center, radius, Vector2{x[i], y[i]},
+                              block_radius))
+      hits |= uint64_t(1) << i;
+  }
+  return first_bits(hits, count);
+}
+
+const char *CollisionKernels() { return "scalar"; }
+
+#endif
+
+void CircleBlockHits(const float *x1, const float *y1, float radius1,
+                     size_t count1, const float *x2, const float *y2,
+                     float radius2, size_t count2, uint64_t *hits) {
+  for (size_t i = 0; i < count1; i++)
+    hits[i] = CircleHits(Vector2{x1[i], y1[i]}, radius1, x2, y2, radius2,
+                         count2);
+}
+
+uint64_t FixedCircleHits(Vector2 center, float radius, const float *x,
+                         const float *y, float block_radius, size_t count) {
+  assert(count <= 64);
+  FixedVector2 c = ToFixed(center);
+  int64_t reach = int64_t(ToFixed(radius)) + ToFixed(block_radius);
+  uint64_t hits = 0;
+  for (size_t i = 0; i < count; i++) {
+    int64_t dx = int64_t(ToFixed(x[i])) - c.x;
+    int64_t dy = int64_t(ToFixed(y[i])) - c.y;
+    if (dx * dx + dy * dy <= reach * reach)
+      hits |= uint64_t(1) << i;
+  }
+  return hits;
+}
+
+void FixedCircleBlockHits(const float *x1, const float *y1, float radius1,
+                          size_t count1, const float *x2, const float *y2,
+                          float radius2, size_t count2, uint64_t *hits) {
+  for (size_t i = 0; i < count1; i++)
+    hits[i] = FixedCircleHits(Vector2{x1[i], y1[i]}, radius1, x2, y2, radius2,
+                              count2);
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <raylib.h>
+
+// Batched CheckCollisionCircles. Bit i of the result is set when the circle
+// at (x[i], y[i]) with the block's radius touches the given one. The
+// arithmetic is raylib's, so the bits are exactly what the scalar calls
+// return. count is at most 64 and the arrays must be readable up to
+// PaddedSlots(count), like the slot arrays.
+uint64_t CircleHits(Vector2 center, float radius, const float *x,
+                    const float *y, float block_radius, size_t count);
+
+// hits[i] = CircleHits of circle i of the first block against the second
+void CircleBlockHits(const float *x1, const float *y1, float radius1,
+                     size_t count1, const float *x2, const float *y2,
+                     float radius2, size_t count2, uint64_t *hits);
+
+// The same tests for deterministic rounds, exact in integers on the
+// fixed-point grid (fixedPoint.hpp)
+uint64_t FixedCircleHits(Vector2 center, float radius, const float *x,
+                         const float *y, float block_radius, size_t count);
+void FixedCircleBlockHits(const float *x1, const float *y1, float radius1,
+                          size_t count1, const float *x2, const float *y2,
+                          float radius2, size_t count2, uint64_t *hits);
+
+// Instruction set the kernels were built for
+const char *CollisionKernels();
@@ -19,10 +19,11 @@ const static int ASTEROID_SIZE_MAX = 64;
 const static int ASTEROID_POLYGON_MIN = 5;
 const static int ASTEROID_POLYGON_MAX = 8;
 const static int ASTEROID_PATH_RANDOM_ANGLE = 45 * DEG2RAD;
+// Slots of a classic room, other room types are in roomConfig.hpp
 const static int ASTEROIDS_MAX = 64;
-const static auto ASTEROID_SPAWN_DELAY = 1s;
 const static float ASTEROID_SPLIT_LOSS = 1.5f;
 
+// Also bounds the players of every room type, there are 4 colors and spawns
 const static int PLAYERS_MAX = 4;
 const static float PLAYER_ROTATION_SPEED = 150.0f;
 const static float PLAYER_ACCELERATION = 650.0f;
@@ -58,5 +59,31 @@ const static auto LOBBY_READY_TIME = 5s;
 const static unsigned int ROUNDS_PER_GAME = 3;
 
 const static unsigned int CONNECTION_TIMEOUT_MILISECONDS = 5000;
+const static unsigned int CONNECTION_CHECK_INTERVAL_MILISECONDS = 1000;
+const static int ACCEPT_BATCH = 64;
+const static auto NETWORK_STATS_INTERVAL = 10s;
+const static size_t CLIENT_FRAME_MAX_SIZE = 64 * 1024;
 const static std::chrono::milliseconds ROOM_FETCH_INTERVAL{5000};
+// Snapshots kept as possible delta baselines, and how often every client
+// gets a keyframe regardless of its acknowledgements
+const static uint32_t SNAPSHOT_HISTORY = 32;
+const static uint32_t SNAPSHOT_KEYFRAME_INTERVAL = 64;
+// Input states are sent when the buttons change, datagrams repeat the
+// last few changes and are also resent at the interval. The server relays
+// movement at the same interval, keeps a bounded queue of changes per
+// player and restarts from a client's newest tick when the two drift more
+// than the slack apart.
+const static std::chrono::milliseconds INPUT_SEND_INTERVAL{33};
+const static size_t INPUT_REPEATED_CHANGES = 4;
+const static size_t INPUT_QUEUE_MAX = 64;
+const static std::chrono::milliseconds INPUT_TICK_SLACK{250};
+// Input ticks the client keeps to replay over acknowledged movement
+const static size_t INPUT_HISTORY = 128;
+// States kept per remote entity, the least margin over the interval of
+// their updates they are drawn with and the longest delay
+const static size_t INTERPOLATION_SAMPLES = 16;
+const static std::chrono::milliseconds INTERPOLATION_MARGIN_MIN{15};
+const static std::chrono::milliseconds INTERPOLATION_DELAY_MAX{250};
+// Bullets hit players where their shooter saw them at most this long ago
+const static std::chrono::milliseconds LAG_COMPENSATION_MAX{250};
 } // namespace Constants
@@ -0,0 +1,19 @@
+#include "datagram.hpp"
+#include "jsonutils.hpp"
+
+void write_datagram_header(std::vector<uint8_t> &out,
+                           const DatagramHeader &header) {
+  write_uint32(out, header.client_id);
+  write_uint32(out, header.token);
+  write_uint32(out, header.sequence);
+}
+
+ReadStatus read_datagram_header(InputCursor &cursor, DatagramHeader &header) {
+  ReadStatus status = cursor.read_uint32(header.client_id);
+  if (status == ReadStatus::Ok)
+    status = cursor.read_uint32(header.token);
+  if (status == ReadStatus::Ok)
+    status = cursor.read_uint32(header.sequence);
+  // A datagram is never continued by another one
+  return status == ReadStatus::Incomplete ? ReadStatus::Invalid : status;
+}
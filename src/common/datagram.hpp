@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "inputBuffer.hpp"
+
+// Optional features a client asks for with the value of its GetClientId
+// request (0 for clients without any). The server replies with the accepted
+// ones after the client id, followed by their parameters.
+enum Capabilities : uint32_t {
+  CapabilityNone = 0,
+  // Unreliable channel for latest-wins updates, parameters: token, UDP port
+  CapabilityUdp = 1 << 0,
+  // WorldSnapshot deltas while in a round, no parameters
+  CapabilitySnapshots = 1 << 1,
+  // Payloads in the binary codec instead of BSON, no parameters
+  CapabilityBinary = 1 << 2,
+  // Quantized positions, velocities and angles in binary payloads, only
+  // together with CapabilityBinary, no parameters
+  CapabilityQuantized = 1 << 3,
+};
+
+// Larger datagrams would risk IP fragmentation
+const static size_t DATAGRAM_MAX_SIZE = 1200;
+
+// Every datagram starts with this header, followed by one event encoded the
+// same way as over TCP. A receiver only accepts sequences newer than the last
+// one it accepted, late and duplicated datagrams are discarded.
+struct DatagramHeader {
+  uint32_t client_id = 0; // 0 when sent by the server
+  uint32_t token = 0;     // From the handshake, proves who sent the datagram
+  uint32_t sequence = 0;
+
+  static const size_t SIZE = 3 * sizeof(uint32_t);
+};
+
+void write_datagram_header(std::vector<uint8_t> &out,
+                           const DatagramHeader &header);
+ReadStatus read_datagram_header(InputCursor &cursor, DatagramHeader &header);
+
+// Sequence numbers wrap around
+inline bool sequence_newer(uint32_t sequence, uint32_t last) {
+  return (int32_t)(sequence - last) > 0;
+}
@@ -0,0 +1,103 @@
+#include "fixedPoint.hpp"
+#include <array>
+#include <cmath>
+
+// Keeps squared distances of saturated values within int64_t
+const static int32_t FIXED_LIMIT = 1 << 29;
+const static int32_t QUARTER_TURN = 90 * FIXED_ONE;
+// Steps of the sine table, a quarter of a degree
+const static int32_t SINE_STEP = FIXED_ONE / 4;
+
+// sin of every quarter of a degree in [0, 90.25], scaled by FIXED_UNIT.
+// Taylor series in integers scaled by 2^30, evaluated by the compiler.
+static constexpr std::array<int32_t, 90 * 4 + 2> SINES = []() {
+  constexpr int64_t ONE = int64_t(1) << 30;
+  constexpr int64_t HALF_TURN = 3373259426; // pi * 2^30
+  std::array<int32_t, 90 * 4 + 2> sines{};
+  for (size_t i = 0; i < sines.size(); i++) {
+    int64_t x = int64_t(i) * HALF_TURN / 720;
+    int64_t term = x, sum = x;
+    for (int64_t n = 1; n <= 7; n++) {
+      term = -(term * x / ONE) * x / ONE / ((2 * n) * (2 * n + 1));
+      sum += term;
+    }
+    sines[i] = int32_t((sum + (ONE / FIXED_UNIT / 2)) / (ONE / FIXED_UNIT));
+  }
+  return sines;
+}();
+
+int32_t ToFixed(float value) {
+  float scaled = value * FIXED_ONE;
+  if (!(scaled > -FIXED_LIMIT)) // Also NaN
+    return -FIXED_LIMIT;
+  if (scaled > FIXED_LIMIT)
+    return FIXED_LIMIT;
+  return int32_t(std::lrint(scaled));
+}
+
+FixedVector2 ToFixed(Vector2 v) { return {ToFixed(v.x), ToFixed(v.y)}; }
+
+float FromFixed(int32_t value) { return float(value) / FIXED_ONE; }
+
+Vector2 FromFixed(FixedVector2 v) { return {FromFixed(v.x), FromFixed(v.y)}; }
+
+float ToGrid(float value) { return FromFixed(ToFixed(value)); }
+
+Vector2 ToGrid(Vector2 v) { return FromFixed(ToFixed(v)); }
+
+int32_t FixedSin(int32_t degrees) {
+  int32_t angle = FixedWrapAngle(degrees);
+  int32_t quadrant = angle / QUARTER_TURN, offset = angle % QUARTER_TURN;
+  if (quadrant % 2)
+    offset = QUARTER_TURN - offset;
+  int32_t i = offset / SINE_STEP, fraction = offset % SINE_STEP;
+  int32_t sine = SINES[i] + (SINES[i + 1] - SINES[i]) * fraction / SINE_STEP;
+  return quadrant >= 2 ? -sine : sine;
+}
+
+int32_t FixedCos(int32_t degrees) {
+  return FixedSin(FixedWrapAngle(degrees) + QUARTER_TURN);
+}
+
+int32_t FixedWrapAngle(int32_t degrees) {
+  int32_t angle = degrees % (4 * QUARTER_TURN);
+  return angle < 0 ? angle + 4 * QUARTER_TURN : angle;
+}
+
+int32_t FixedScale(int32_t value, int32_t unit) {
+  return int32_t(int64_t(value) * unit / FIXED_UNIT);
+}
+
+FixedVector2 FixedRotate(FixedVector2 v, int32_t degrees) {
+  int32_t cos = FixedCos(degrees), sin = FixedSin(degrees);
+  return {int32_t((int64_t(v.x) * cos - int64_t(v.y) * sin) / FIXED_UNIT),
+          int32_t((int64_t(v.x) * sin + int64_t(v.y) * cos) / FIXED_UNIT)};
+}
+
+static uint64_t isqrt(uint64_t n) {
+  uint64_t root = 0, bit = uint64_t(1) << 62;
+  while (bit > n)
+    bit >>= 2;
+  for (; bit; bit >>= 2) {
+    if (n >= root + bit) {
+      n -= root + bit;
+      root = (root >> 1) + bit;
+    } else {
+      root >>= 1;
+    }
+  }
+  return root;
+}
+
+FixedVector2 FixedScaleTo(FixedVector2 v, int32_t length) {
+  int64_t current =
+      isqrt(uint64_t(int64_t(v.x) * v.x) + uint64_t(int64_t(v.y) * v.y));
+  if (current == 0)
+    return {0, 0};
+  return {int32_t(int64_t(v.x) * length / current),
+          int32_t(int64_t(v.y) * length / current)};
+}
+
+int32_t FixedPerTick(int32_t per_second, uint32_t tick_rate) {
+  return int32_t(per_second / int64_t(tick_rate));
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+#include <raylib.h>
+
+// Fixed-point numbers with 8 fractional bits, the arithmetic of
+// deterministic rounds. Their state stays in the float slot arrays: every
+// value on this grid below 2^15 is exactly a float, so the codecs and
+// drawing don't change, while every step is computed in integers and gives
+// the same bits on every machine and build.
+const static int32_t FIXED_ONE = 1 << 8;
+// Scale of sines and cosines
+const static int32_t FIXED_UNIT = 1 << 16;
+// Fixed-point degrees in a radian, rounded
+const static int32_t FIXED_DEGREES_PER_RADIAN = 14667;
+
+struct FixedVector2 {
+  int32_t x, y;
+};
+
+// Nearest point of the grid, saturated far outside of the playfield
+int32_t ToFixed(float value);
+FixedVector2 ToFixed(Vector2 v);
+// Exact for the grid
+float FromFixed(int32_t value);
+Vector2 FromFixed(FixedVector2 v);
+// Nearest value of the grid, for state that arrives from elsewhere
+float ToGrid(float value);
+Vector2 ToGrid(Vector2 v);
+
+// Angles are fixed-point degrees, results are scaled by FIXED_UNIT
+int32_t FixedSin(int32_t degrees);
+int32_t FixedCos(int32_t degrees);
+// In [0, 360) degrees
+int32_t FixedWrapAngle(int32_t degrees);
+// value * unit / FIXED_UNIT, rounded towards zero
+int32_t FixedScale(int32_t value, int32_t unit);
+// Like Vector2Rotate
+FixedVector2 FixedRotate(FixedVector2 v, int32_t degrees);
+// v with the given length, {0, 0} stays
+FixedVector2 FixedScaleTo(FixedVector2 v, int32_t length);
+// Change in one step of a rate per second
+int32_t FixedPerTick(int32_t per_second, uint32_t tick_rate);
@@ -1,11 +1,18 @@
 #include "gameManager.hpp"
+#include "collision.hpp"
 #include "constants.hpp"
+#include "fixedPoint.hpp"
 #include "player.hpp"
 #include "raylib.h"
+#include <cassert>
 #include <chrono>
 
 using namespace std::chrono;
 
+// Fewer asteroid slots are faster to test one by one than to narrow with
+// the grid first (bench/spatialGridBench)
+const static size_t GRID_ASTEROIDS_MIN = 512;
+
 GameManager::GameManager() {
   NewGame(std::vector<PlayerIdState>(Constants::PLAYERS_MAX));
 }
@@ -13,113 +20,280 @@ GameManager::GameManager() {
 GameManager::~GameManager() {}
 
 void GameManager::NewGame(std::vector<PlayerIdState> playerInfos) {
-  asteroids = std::vector<Asteroid>(Constants::ASTEROIDS_MAX, Asteroid());
+  WithRoomConfig(type, [&](auto config) {
+    NewGame<decltype(config)>(playerInfos);
+  });
+}
+
+template <typename Config>
+void GameManager::NewGame(const std::vector<PlayerIdState> &playerInfos) {
+  random = RoomRandom(seed);
+  asteroids = AsteroidArrays(Config::ASTEROIDS);
+  asteroid_pool = SlotPool(0, Config::ASTEROIDS);
   players.clear();
-  players.reserve(Constants::PLAYERS_MAX);
-  for (int i = 0; i < Constants::PLAYERS_MAX; i++) {
-    players.push_back(AddPlayer(i));
-    players.at(i).active = playerInfos.at(i).state == PlayerInfo::READY;
-    players.at(i).player_id = i;
-  }
-  bullets = std::vector<Bullet>(
-      Constants::BULLETS_PER_PLAYER * Constants::PLAYERS_MAX, Bullet());
+  players.reserve(Config::PLAYERS);
+  for (size_t i = 0; i < Config::PLAYERS; i++) {
+    players.push_back(AddPlayer(i, random));
+    players[i].active = playerInfos.at(i).state == PlayerInfo::READY;
+    players[i].player_id = i;
+  }
+  bullets = BulletArrays(Config::PLAYERS * Config::BULLETS_PER_PLAYER);
+  bullet_pools.clear();
+  for (size_t i = 0; i < Config::PLAYERS; i++)
+    bullet_pools.emplace_back(i * Config::BULLETS_PER_PLAYER,
+                              Config::BULLETS_PER_PLAYER);
   asteroid_spawner_time = time_point<steady_clock>(0s);
+  asteroid_spawner_ticks = 0;
 }
 
-void GameManager::UpdateBullets(duration<double> frametime) {
-  for (int i = 0; i < Constants::PLAYERS_MAX * Constants::BULLETS_PER_PLAYER;
-       i++) {
-    UpdateBullet(bullets[i], frametime);
+void GameManager::UpdatePlayers(duration<double> frametime,
+                                uint32_t local_player_id) {
+  for (auto &player : players) {
+    if (player.player_id == local_player_id)
+      continue;
+    if (fixed_tick_rate)
+      CalculateUpdatePlayerMovementFixed(player, fixed_tick_rate);
+    else
+      CalculateUpdatePlayerMovement(player, frametime);
   }
 }
 
+void GameManager::UpdateBullets(duration<double> frametime) {
+  if (fixed_tick_rate)
+    IntegrateAndCollectFixed(bullets.x.data(), bullets.y.data(),
+                             bullets.vx.data(), bullets.vy.data(),
+                             bullets.active, bullets.x.size(),
+                             fixed_tick_rate);
+  else
+    IntegrateAndCollect(bullets.x.data(), bullets.y.data(),
+                        bullets.vx.data(), bullets.vy.data(), bullets.active,
+                        bullets.x.size(), frametime.count());
+  for (auto &pool : bullet_pools)
+    pool.reclaim(bullets.active);
+}
+
 void GameManager::UpdateAsteroids(duration<double> frametime) {
-  for (int i = 0; i < Constants::ASTEROIDS_MAX; i++) {
-    UpdateAsteroid(asteroids[i], frametime);
+  if (fixed_tick_rate) {
+    IntegrateAndCollectFixed(asteroids.x.data(), asteroids.y.data(),
+                             asteroids.vx.data(), asteroids.vy.data(),
+                             asteroids.active, asteroids.x.size(),
+                             fixed_tick_rate);
+    IntegrateAnglesFixed(asteroids.rotation.data(),
+                         asteroids.rotation_speed.data(), asteroids.active,
+                         asteroids.x.size(), fixed_tick_rate);
+  } else {
+    IntegrateAndCollect(asteroids.x.data(), asteroids.y.data(),
+                        asteroids.vx.data(), asteroids.vy.data(),
+                        asteroids.active, asteroids.x.size(),
+                        frametime.count());
+    IntegrateAngles(asteroids.rotation.data(), asteroids.rotation_speed.data(),
+                    asteroids.active, asteroids.x.size(), frametime.count());
   }
+  asteroid_pool.reclaim(asteroids.active);
 }
 
 void GameManager::AsteroidSpawner(std::vector<uint32_t> &spawned_asteroids) {
-  auto now = std::chrono::steady_clock::now();
-  if (now > asteroid_spawner_time + Constants::ASTEROID_SPAWN_DELAY) {
+  auto delay = WithRoomConfig(type, [](auto config) {
+    return decltype(config)::ASTEROID_SPAWN_DELAY;
+  });
+  if (fixed_tick_rate) {
+    if (++asteroid_spawner_ticks <= delay.count() * fixed_tick_rate / 1000)
+      return;
+    asteroid_spawner_ticks = 0;
+  } else {
+    auto now = std::chrono::steady_clock::now();
+    if (now <= asteroid_spawner_time + delay)
+      return;
     asteroid_spawner_time = now;
-    auto r = AddAsteroid();
-    if (r != UINT32_MAX) {
-      spawned_asteroids.push_back(r);
-    }
   }
+  auto r = AddAsteroid();
+  if (r != UINT32_MAX) {
+    spawned_asteroids.push_back(r);
+  }
+}
+
+void GameManager::ManageCollisions(std::vector<uint32_t> &destroyed_asteroids,
+                                   std::vector<uint32_t> &spawned_asteroids,
+                                   std::vector<uint32_t> &destroyed_players,
+                                   std::vector<uint32_t> &destroyed_bullets) {
+  WithRoomConfig(type, [&](auto config) {
+    ManageCollisions<decltype(config)>(destroyed_asteroids, spawned_asteroids,
+                                       destroyed_players, destroyed_bullets);
+  });
 }
 
+// Only asteroids close to an active bullet or player can collide, in large
+// rooms the grid finds them. Small rooms keep the plain loop over all
+// asteroids, and the grid keeps everything else of it, including its order:
+// bullets are tested against players while visiting the first asteroid, or
+// a later one when a hit of their owner's bullet broke out before them.
+// Only the asteroids active when the pass starts are visited. Those split
+// off in it are first tested in the next pass, and a destroyed asteroid's
+// slot is only reused after this one, so nothing is hit twice.
+template <typename Config>
 void GameManager::ManageCollisions(std::vector<uint32_t> &destroyed_asteroids,
                                    std::vector<uint32_t> &spawned_asteroids,
                                    std::vector<uint32_t> &destroyed_players,
                                    std::vector<uint32_t> &destroyed_bullets) {
-  for (int i = 0; i < Constants::ASTEROIDS_MAX; i++) {
-    if (!asteroids[i].active)
+  constexpr size_t BULLETS = Config::PLAYERS * Config::BULLETS_PER_PLAYER;
+  static_assert(BULLETS <= 64 && Config::PLAYERS <= Constants::PLAYERS_MAX,
+                "bullets fit a 64-bit hit mask, players the player arrays");
+  assert(asteroids.count() == Config::ASTEROIDS &&
+         bullets.count() == BULLETS && players.size() == Config::PLAYERS);
+
+  constexpr bool USE_GRID = Config::ASTEROIDS >= GRID_ASTEROIDS_MIN;
+  pass_asteroids = asteroids.active;
+  if constexpr (USE_GRID) {
+    asteroid_grid.build(asteroids);
+    near_asteroids.assign(asteroids.count(), false);
+    // With a margin for the rounding of CheckCollisionCircles
+    auto mark_near = [this](Vector2 position, float radius) {
+      asteroid_grid.query(position, radius + Constants::ASTEROID_SIZE_MAX + 1,
+                          [&](uint32_t i) {
+                            float reach = radius + asteroids.size[i] + 1;
+                            if (Vector2DistanceSqr(position,
+                                                   asteroids.position(i)) <=
+                                reach * reach)
+                              near_asteroids[i] = true;
+                          });
+    };
+    for (size_t k = 0; k < BULLETS; k++) {
+      if (bullets.is_active(k))
+        mark_near(bullets.position(k), Constants::BULLET_SIZE);
+    }
+    for (size_t j = 0; j < Config::PLAYERS; j++) {
+      if (players[j].active)
+        mark_near(players[j].position, Constants::PLAYER_SIZE / 3.0f);
+    }
+  }
+
+  // Nothing moves during the pass, bullets and players are tested against
+  // each other once
+  for (size_t j = 0; j < Config::PLAYERS; j++) {
+    player_x[j] = players[j].position.x;
+    player_y[j] = players[j].position.y;
+  }
+  // The grid only narrows the candidates with a margin, the exact tests
+  // decide and are done in integers in deterministic rounds
+  auto circle_block_hits =
+      fixed_tick_rate ? FixedCircleBlockHits : CircleBlockHits;
+  circle_block_hits(bullets.x.data(), bullets.y.data(), Constants::BULLET_SIZE,
+                    BULLETS, player_x.data(), player_y.data(),
+                    Constants::PLAYER_SIZE / 3.0f, Config::PLAYERS,
+                    bullet_player_hits.data());
+  for (size_t j = 0; j < Config::PLAYERS; j++) {
+    if (!(rewound_views >> j & 1))
       continue;
+    size_t first = j * Config::BULLETS_PER_PLAYER;
+    circle_block_hits(bullets.x.data() + first, bullets.y.data() + first,
+                      Constants::BULLET_SIZE, Config::BULLETS_PER_PLAYER,
+                      rewound_x[j].data(), rewound_y[j].data(),
+                      Constants::PLAYER_SIZE / 3.0f, Config::PLAYERS,
+                      bullet_player_hits.data() + first);
+  }
 
-    for (int j = 0; j < Constants::PLAYERS_MAX; j++) {
-      for (int k = j * Constants::BULLETS_PER_PLAYER;
-           k < (j + 1) * Constants::BULLETS_PER_PLAYER; k++) {
-        if (!bullets[k].active)
-          continue;
+  checked_bullets = 0;
+  bool bullets_checked = false;
+  for (size_t i = 0; i < Config::ASTEROIDS; i++) {
+    if (!pass_asteroids.test(i))
+      continue;
+    if constexpr (USE_GRID) {
+      if (!near_asteroids[i] && bullets_checked)
+        continue;
+    }
 
-        if (CheckCollisionCircles(bullets[k].position, Constants::BULLET_SIZE,
-                                  asteroids[i].position, asteroids[i].size)) {
-          destroyed_bullets.push_back(k);
-          destroyed_asteroids.push_back(i);
-          bullets[k].active = false;
-          asteroids[i].active = false;
-          SplitAsteroid(asteroids[i].position, asteroids[i].velocity,
-                        float(asteroids[i].size) /
-                            Constants::ASTEROID_SPLIT_LOSS,
-                        spawned_asteroids);
-          break;
-        }
+    CollideAsteroid<Config>(i, destroyed_asteroids, spawned_asteroids,
+                            destroyed_players, destroyed_bullets);
 
-        for (int l = 0; l < Constants::PLAYERS_MAX; l++) {
-          if (j == l || !players[l].active)
-            continue;
-
-          if (CheckCollisionCircles(bullets[k].position, Constants::BULLET_SIZE,
-                                    players[l].position,
-                                    Constants::PLAYER_SIZE / 3.0f)) {
-            destroyed_players.push_back(l);
-            destroyed_bullets.push_back(k);
-            players[l].active = false;
-            bullets[k].active = false;
-            break;
-          }
-        }
-      }
+    // All bullets fit in the first word of the mask
+    if (!bullets_checked)
+      bullets_checked = (bullets.active.words[0] & ~checked_bullets) == 0;
+  }
+  asteroid_pool.release_retired();
+}
 
-      if (!players[j].active)
+template <typename Config>
+void GameManager::CollideAsteroid(int i,
+                                  std::vector<uint32_t> &destroyed_asteroids,
+                                  std::vector<uint32_t> &spawned_asteroids,
+                                  std::vector<uint32_t> &destroyed_players,
+                                  std::vector<uint32_t> &destroyed_bullets) {
+  // Cleared once the asteroid is destroyed
+  auto circle_hits = fixed_tick_rate ? FixedCircleHits : CircleHits;
+  uint64_t bullet_hits = circle_hits(
+      asteroids.position(i), asteroids.size[i], bullets.x.data(),
+      bullets.y.data(), Constants::BULLET_SIZE,
+      Config::PLAYERS * Config::BULLETS_PER_PLAYER);
+  uint64_t player_hits = circle_hits(
+      asteroids.position(i), asteroids.size[i], player_x.data(),
+      player_y.data(), Constants::PLAYER_SIZE / 3.0f, Config::PLAYERS);
+
+  for (size_t j = 0; j < Config::PLAYERS; j++) {
+    for (size_t k = j * Config::BULLETS_PER_PLAYER;
+         k < (j + 1) * Config::BULLETS_PER_PLAYER; k++) {
+      if (!bullets.is_active(k))
         continue;
+      checked_bullets |= uint64_t(1) << k;
 
-      if (CheckCollisionCircles(players[j].position,
-                                Constants::PLAYER_SIZE / 3.0f,
-                                asteroids[i].position, asteroids[i].size)) {
-        destroyed_players.push_back(j);
+      if (bullet_hits >> k & 1) {
+        destroyed_bullets.push_back(k);
         destroyed_asteroids.push_back(i);
-        players[j].active = false;
-        asteroids[i].active = false;
-        SplitAsteroid(asteroids[i].position, asteroids[i].velocity,
-                      float(asteroids[i].size) / Constants::ASTEROID_SPLIT_LOSS,
+        RemoveBullet(k);
+        RemoveAsteroid(i);
+        SplitAsteroid(asteroids.position(i), asteroids.velocity(i),
+                      float(asteroids.size[i]) / Constants::ASTEROID_SPLIT_LOSS,
                       spawned_asteroids);
+        bullet_hits = player_hits = 0;
+        break;
+      }
+
+      for (size_t l = 0; l < Config::PLAYERS; l++) {
+        if (j == l || !players[l].active)
+          continue;
+
+        if (bullet_player_hits[k] >> l & 1) {
+          destroyed_players.push_back(l);
+          destroyed_bullets.push_back(k);
+          players[l].active = false;
+          RemoveBullet(k);
+          break;
+        }
       }
     }
+
+    if (!players[j].active)
+      continue;
+
+    if (player_hits >> j & 1) {
+      destroyed_players.push_back(j);
+      destroyed_asteroids.push_back(i);
+      players[j].active = false;
+      RemoveAsteroid(i);
+      SplitAsteroid(asteroids.position(i), asteroids.velocity(i),
+                    float(asteroids.size[i]) / Constants::ASTEROID_SPLIT_LOSS,
+                    spawned_asteroids);
+      bullet_hits = player_hits = 0;
+    }
   }
 }
 
 uint32_t GameManager::AddAsteroid() {
-  for (int i = 0; i < Constants::ASTEROIDS_MAX; i++) {
-    if (asteroids[i].active)
-      continue;
-    asteroids[i] = CreateAsteroid();
-    return i;
+  uint32_t i = asteroid_pool.allocate(asteroids.active);
+  if (i == SlotPool::NONE) {
+    TraceLog(LOG_DEBUG, "Failed to create an asteroid - no empty slots left");
+    return UINT32_MAX;
   }
-  TraceLog(LOG_ERROR, "Failed to create an asteroid - no empty slots left");
-  return UINT32_MAX;
+  Vector2 position = GetRandomPosition(random);
+  Vector2 velocity = RandomVelocity(position);
+  int size =
+      random.value(Constants::ASTEROID_SIZE_MIN, Constants::ASTEROID_SIZE_MAX);
+  asteroids.spawn(i, CreateAsteroid(random, position, velocity, size));
+  return i;
+}
+
+Vector2 GameManager::RandomVelocity(Vector2 position) {
+  return fixed_tick_rate ? GetFixedRandomVelocity(position, random)
+                         : GetRandomVelocity(position, random);
 }
 
 void GameManager::SplitAsteroid(Vector2 position, Vector2 velocity, int size,
@@ -127,43 +301,110 @@ void GameManager::SplitAsteroid(Vector2 position, Vector2 velocity, int size,
   if (size < Constants::ASTEROID_SIZE_MIN)
     return;
 
-  int toSpawn = 2;
-  for (int i = 0; i < Constants::ASTEROIDS_MAX; i++) {
-    if (!toSpawn)
+  for (int toSpawn = 2; toSpawn > 0; toSpawn--) {
+    uint32_t i = asteroid_pool.allocate(asteroids.active);
+    if (i == SlotPool::NONE) {
+      TraceLog(LOG_DEBUG, "Failed to split an asteroid - no empty slots left");
       return;
-    if (asteroids[i].active)
-      continue;
+    }
 
+    int angle = toSpawn % 2 ? random.value(60, 120) : random.value(-120, -60);
     Vector2 new_velocity =
-        Vector2Rotate(velocity, toSpawn % 2 ? GetRandomValue(60, 120)
-                                            : GetRandomValue(-120, -60));
-    asteroids[i] = CreateAsteroid(position, new_velocity, size);
+        fixed_tick_rate
+            ? FromFixed(FixedRotate(ToFixed(velocity),
+                                    angle * FIXED_DEGREES_PER_RADIAN))
+            : Vector2Rotate(velocity, angle);
+    if (Vector2Length(new_velocity) == 0)
+      new_velocity = RandomVelocity(position);
+    asteroids.spawn(i, CreateAsteroid(random, position, new_velocity, size));
     changed.push_back(i);
-    toSpawn--;
   }
+}
 
-  TraceLog(LOG_ERROR, "Failed to split an asteroid - no empty slots left");
+void GameManager::RemoveAsteroid(uint32_t i) {
+  asteroids.active.set(i, false);
+  asteroid_pool.retire(i);
 }
 
-bool GameManager::AddBullet(const Player &player) {
+uint32_t GameManager::AddBullet(const Player &player) {
   if (!player.active)
-    return false;
+    return UINT32_MAX;
 
-  for (size_t i = player.player_id * Constants::BULLETS_PER_PLAYER;
-       i < (player.player_id + 1) * Constants::BULLETS_PER_PLAYER; i++) {
-    if (bullets.at(i).active)
-      continue;
+  uint32_t k = bullet_pools.at(player.player_id).allocate(bullets.active);
+  if (k == SlotPool::NONE) {
+    TraceLog(LOG_DEBUG,
+             "Failed to shoot a bullet - player[%d]: no bullets left",
+             player.player_id);
+    return UINT32_MAX;
+  }
+  SetBullet(k, player);
+  return k;
+}
 
-    Vector2 offset = Vector2Rotate(Vector2{Constants::PLAYER_SIZE / 2.0f, 0.0f},
-                                   player.rotation * DEG2RAD);
-    bullets[i] =
-        CreateBullet(Vector2Add(player.position, offset), player.rotation);
-    return true;
+void GameManager::SetBullet(uint32_t k, const Player &player) {
+  if (fixed_tick_rate) {
+    int32_t rotation = ToFixed(player.rotation);
+    int32_t cos = FixedCos(rotation), sin = FixedSin(rotation);
+    const int32_t offset = Constants::PLAYER_SIZE * FIXED_ONE / 2;
+    const int32_t speed = ToFixed(Constants::BULLET_SPEED);
+    FixedVector2 position = ToFixed(player.position);
+    position.x += FixedScale(offset, cos);
+    position.y += FixedScale(offset, sin);
+    bullets.set(k, CreateBullet(FromFixed(position), FromFixed(rotation)));
+    // Instead of the float velocity set() computes
+    bullets.vx[k] = FromFixed(FixedScale(speed, cos));
+    bullets.vy[k] = FromFixed(FixedScale(speed, sin));
+    return;
   }
+  Vector2 offset = Vector2Rotate(Vector2{Constants::PLAYER_SIZE / 2.0f, 0.0f},
+                                 player.rotation * DEG2RAD);
+  bullets.set(k, CreateBullet(Vector2Add(player.position, offset),
+                              player.rotation));
+}
+
+void GameManager::RemoveBullet(uint32_t k) {
+  bullets.active.set(k, false);
+  bullet_pools[k / BulletsPerPlayer()].release(k);
+}
+
+size_t GameManager::BulletsPerPlayer() const {
+  return WithRoomConfig(type, [](auto config) {
+    return decltype(config)::BULLETS_PER_PLAYER;
+  });
+}
 
-  TraceLog(LOG_DEBUG, "Failed to shoot a bullet - player[%d]: no bullets left",
-           player.player_id);
-  return false;
+void GameManager::SnapToGrid(Movement &movement) const {
+  if (!fixed_tick_rate)
+    return;
+  movement.position = ToGrid(movement.position);
+  movement.velocity = ToGrid(movement.velocity);
+  movement.rotation = ToGrid(movement.rotation);
+}
+
+void GameManager::SnapToGrid(Asteroid &asteroid) const {
+  if (!fixed_tick_rate)
+    return;
+  asteroid.position = ToGrid(asteroid.position);
+  asteroid.velocity = ToGrid(asteroid.velocity);
+  asteroid.rotation = ToGrid(asteroid.rotation);
+  asteroid.rotation_speed = ToGrid(asteroid.rotation_speed);
+}
+
+void GameManager::SnapToGrid() {
+  if (!fixed_tick_rate)
+    return;
+  for (auto *field : {&asteroids.x, &asteroids.y, &asteroids.vx, &asteroids.vy,
+                      &asteroids.rotation, &asteroids.rotation_speed,
+                      &bullets.x, &bullets.y, &bullets.vx, &bullets.vy,
+                      &bullets.rotation}) {
+    for (float &value : *field)
+      value = ToGrid(value);
+  }
+  for (auto &player : players) {
+    player.position = ToGrid(player.position);
+    player.velocity = ToGrid(player.velocity);
+    player.rotation = ToGrid(player.rotation);
+  }
 }
 
 size_t GameManager::GetReadyPlayers(
@@ -4,6 +4,11 @@
 #include "bullet.hpp"
 #include "player.hpp"
 #include "room.hpp"
+#include "roomConfig.hpp"
+#include "roomRandom.hpp"
+#include "slotPool.hpp"
+#include "spatialGrid.hpp"
+#include <array>
 #include <chrono>
 #include <cstdint>
 #include <raylib.h>
@@ -13,17 +18,47 @@
 using namespace std::chrono;
 
 struct GameManager {
-  std::vector<Asteroid> asteroids;
+  // Capacities of the room, set before NewGame
+  RoomType type = RoomType::Classic;
+  AsteroidArrays asteroids;
   std::vector<Player> players;
-  std::vector<Bullet> bullets;
+  BulletArrays bullets;
+  // Free slots of asteroids, and of each player's bullets
+  SlotPool asteroid_pool;
+  std::vector<SlotPool> bullet_pools;
+
+  // Server ticks per second, players step once per tick by their input
+  uint32_t tick_rate = 60;
+  // Deterministic rounds step by 1/fixed_tick_rate seconds in fixed point
+  // (fixedPoint.hpp), 0 keeps the float simulation. Both draw from the
+  // round's seed, which NewGame restarts the generator with.
+  uint32_t fixed_tick_rate = 0;
+  uint32_t seed = 0;
+  RoomRandom random;
 
   uint32_t winner_player_id = UINT32_MAX;
   uint32_t room_id;
 
   time_point<steady_clock> asteroid_spawner_time;
+  // Steps since the last spawn of a deterministic round
+  uint32_t asteroid_spawner_ticks = 0;
   time_point<system_clock> game_start_time;
 
-  void UpdatePlayers(duration<double> frametime);
+  // Scratch state of ManageCollisions, kept to reuse the allocations
+  SpatialGrid asteroid_grid;
+  std::vector<bool> near_asteroids;
+  ActiveMask pass_asteroids;
+  uint64_t checked_bullets = 0;
+  std::array<float, PaddedSlots(Constants::PLAYERS_MAX)> player_x{}, player_y{};
+  std::array<uint64_t, 64> bullet_player_hits{};
+  // Players as shooter j saw them, its bullets are tested against these
+  // instead when rewound_views has bit j. Set by the server's lag
+  // compensation before ManageCollisions.
+  uint64_t rewound_views = 0;
+  std::array<std::array<float, PaddedSlots(Constants::PLAYERS_MAX)>,
+             Constants::PLAYERS_MAX>
+      rewound_x{}, rewound_y{};
+
   GameManager();
   GameManager(uint32_t room_id, std::vector<PlayerIdState> playerInfos);
   ~GameManager();
@@ -34,6 +69,10 @@ struct GameManager {
   void UpdateStatus();
   void UpdateGameServer();
 
+  // In deterministic rounds every call is one step and frametime is ignored.
+  // Players drift between their movement updates, except the local one,
+  // which only moves by its own input commands.
+  void UpdatePlayers(duration<double> frametime, uint32_t local_player_id);
   void UpdateAsteroids(duration<double> frametime);
   void AsteroidSpawner(std::vector<uint32_t> &spawned_asteroids);
 
@@ -44,10 +83,44 @@ struct GameManager {
   uint32_t AddAsteroid();
   void SplitAsteroid(Vector2 position, Vector2 velocity, int size,
                      std::vector<uint32_t> &changed);
-  bool AddBullet(const Player &player);
+  // The slot is reused once the collision pass ends
+  void RemoveAsteroid(uint32_t i);
+  // The bullet's slot, UINT32_MAX when the player can't shoot
+  uint32_t AddBullet(const Player &player);
+  // Puts a bullet shot by player into slot k
+  void SetBullet(uint32_t k, const Player &player);
+  void RemoveBullet(uint32_t k);
+  size_t BulletsPerPlayer() const;
   void UpdateBullets(duration<double> frametime);
 
   size_t GetReadyPlayers(const std::vector<PlayerIdState> &player_infos) const;
+
+  // Received state of a deterministic round back on the fixed-point grid,
+  // which the quantized wire format leaves. Nothing changes in other
+  // rounds.
+  void SnapToGrid(Movement &movement) const;
+  void SnapToGrid(Asteroid &asteroid) const;
+  // Every slot and player
+  void SnapToGrid();
+
+private:
+  Vector2 RandomVelocity(Vector2 position);
+  // Instantiated for each room config in gameManager.cpp, the overloads
+  // above dispatch on type
+  template <typename Config>
+  void NewGame(const std::vector<PlayerIdState> &playerInfos);
+  template <typename Config>
+  void ManageCollisions(std::vector<uint32_t> &destroyed_asteroids,
+                        std::vector<uint32_t> &spawned_asteroids,
+                        std::vector<uint32_t> &destroyed_players,
+                        std::vector<uint32_t> &destroyed_bullets);
+  // Tests one asteroid against every bullet and player, and the bullets
+  // against the players
+  template <typename Config>
+  void CollideAsteroid(int i, std::vector<uint32_t> &destroyed_asteroids,
+                       std::vector<uint32_t> &spawned_asteroids,
+                       std::vector<uint32_t> &destroyed_players,
+                       std::vector<uint32_t> &destroyed_bullets);
 };
 
 bool ReturnToRooms();
@@ -0,0 +1,88 @@
+#include "inputBuffer.hpp"
+#include "raylib.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+void InputBuffer::consume(size_t size) {
+  start += size;
+  if (start == data.size()) {
+    data.clear();
+    start = 0;
+  }
+}
+
+void InputBuffer::append(const uint8_t *bytes, size_t size) {
+  if (start > 0) {
+    data.erase(data.begin(), data.begin() + start);
+    start = 0;
+  }
+  data.insert(data.end(), bytes, bytes + size);
+}
+
+bool InputBuffer::fill(int fd) {
+  // Drop consumed bytes before growing
+  if (start > 0) {
+    data.erase(data.begin(), data.begin() + start);
+    start = 0;
+  }
+
+  // Full, the level-triggered poll reports the rest after the frames are
+  // handled
+  while (data.size() < BUFFERED_MAX) {
+    size_t used = data.size();
+    size_t size = std::min(READ_SIZE, BUFFERED_MAX - used);
+    data.resize(used + size);
+    ssize_t readb = recv(fd, data.data() + used, size, 0);
+    syscalls++;
+    data.resize(used + std::max<ssize_t>(readb, 0));
+
+    if (readb == -1 && errno == EINTR)
+      continue;
+    if (readb == -1)
+      return errno == EAGAIN || errno == EWOULDBLOCK;
+    if (readb == 0)
+      return false;
+    if ((size_t)readb < size)
+      return true; // Socket drained, skip the EAGAIN round trip
+  }
+  return true;
+}
+
+ReadStatus InputCursor::read_uint32(uint32_t &v) {
+  if (in.data.size() - pos < sizeof(v))
+    return ReadStatus::Incomplete;
+  uint32_t val;
+  memcpy(&val, in.data.data() + pos, sizeof(val));
+  v = ntohl(val);
+  pos += sizeof(val);
+  return ReadStatus::Ok;
+}
+
+ReadStatus InputCursor::read_json(json &j, size_t maxsize) {
+  uint32_t bson_size;
+  ReadStatus status = read_uint32(bson_size);
+  if (status != ReadStatus::Ok)
+    return status;
+  if (bson_size > maxsize) {
+    TraceLog(LOG_ERROR,
+             "JSON: bson object size %lu exceeds maximum expected size %llu",
+             bson_size, maxsize);
+    return ReadStatus::Invalid;
+  }
+  if (in.data.size() - pos < bson_size)
+    return ReadStatus::Incomplete;
+
+  auto first = in.data.begin() + pos;
+  pos += bson_size;
+  try {
+    json jj = json::from_bson(first, first + bson_size);
+    j = jj.at("data");
+    return ReadStatus::Ok;
+  } catch (json::exception &ex) {
+    TraceLog(LOG_WARNING, "JSON: couldn't decode bson object: %s", ex.what());
+    return ReadStatus::Invalid;
+  }
+}
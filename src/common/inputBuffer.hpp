@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+#include <vector>
+
+using json = nlohmann::json;
+
+enum class ReadStatus { Ok, Incomplete, Invalid };
+
+// Bytes received from a non-blocking socket, consumed once a whole frame has
+// been decoded from them
+struct InputBuffer {
+  static constexpr size_t READ_SIZE = 64 * 1024;
+  // Room for the largest frame. The rest stays in the socket, whose window
+  // then slows the sender down, until the frames are handled.
+  static constexpr size_t BUFFERED_MAX = 2 * READ_SIZE;
+
+  std::vector<uint8_t> data;
+  size_t start = 0; // First unconsumed byte
+  uint64_t syscalls = 0;
+
+  size_t available() const { return data.size() - start; }
+  void consume(size_t size);
+  // Bytes received without fill() (completed io_uring receives)
+  void append(const uint8_t *bytes, size_t size);
+
+  // Reads what the socket has buffered, up to BUFFERED_MAX bytes in total,
+  // returns false on EOF or error
+  bool fill(int fd);
+};
+
+// Parsing position in an InputBuffer. Nothing is consumed until commit(), so
+// a frame split between reads is parsed again once the rest arrives.
+struct InputCursor {
+  InputBuffer &in;
+  size_t pos;
+
+  explicit InputCursor(InputBuffer &in) : in(in), pos(in.start) {}
+
+  ReadStatus read_uint32(uint32_t &v);
+  // maxsize is optional, disable this check by passing -1
+  ReadStatus read_json(json &j, size_t maxsize);
+  void commit() { in.consume(pos - in.start); }
+};
@@ -0,0 +1,189 @@
+#include "integration.hpp"
+#include "constants.hpp"
+#include "fixedPoint.hpp"
+#include "spaceJunkCollector.hpp"
+#include <cassert>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// Edges of SpaceJunkCollector
+const static float MIN_X = -Constants::ASTEROID_SIZE_MAX;
+const static float MAX_X =
+    Constants::screenWidth + Constants::ASTEROID_SIZE_MAX;
+const static float MIN_Y = -Constants::ASTEROID_SIZE_MAX;
+const static float MAX_Y =
+    Constants::screenHeight + Constants::ASTEROID_SIZE_MAX;
+
+// Active bits of the block starting at slot i, blocks never straddle words
+template <unsigned LANES>
+static uint32_t block_bits(const ActiveMask &active, size_t i) {
+  return active.words[i / 64] >> (i % 64) & ((1u << LANES) - 1);
+}
+
+template <unsigned LANES>
+static void store_block_bits(ActiveMask &active, size_t i, uint32_t bits) {
+  uint64_t &word = active.words[i / 64];
+  word &= ~(uint64_t((1u << LANES) - 1) << (i % 64));
+  word |= uint64_t(bits) << (i % 64);
+}
+
+#if defined(__AVX2__)
+
+// All ones in the lanes whose bit is set
+static __m256 lane_mask(uint32_t bits) {
+  const __m256i select = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+  __m256i set = _mm256_and_si256(_mm256_set1_epi32(bits), select);
+  return _mm256_castsi256_ps(_mm256_cmpeq_epi32(set, select));
+}
+
+void IntegrateAndCollect(float *x, float *y, const float *vx, const float *vy,
+                         ActiveMask &active, size_t slots, float dt) {
+  assert(slots % 8 == 0);
+  const __m256 min_x = _mm256_set1_ps(MIN_X), max_x = _mm256_set1_ps(MAX_X);
+  const __m256 min_y = _mm256_set1_ps(MIN_Y), max_y = _mm256_set1_ps(MAX_Y);
+  const __m256 step = _mm256_set1_ps(dt);
+  for (size_t i = 0; i < slots; i += 8) {
+    uint32_t bits = block_bits<8>(active, i);
+    if (!bits)
+      continue;
+    __m256 px = _mm256_loadu_ps(x + i), py = _mm256_loadu_ps(y + i);
+    __m256 out = _mm256_or_ps(
+        _mm256_or_ps(_mm256_cmp_ps(px, min_x, _CMP_LT_OQ),
+                     _mm256_cmp_ps(px, max_x, _CMP_GT_OQ)),
+        _mm256_or_ps(_mm256_cmp_ps(py, min_y, _CMP_LT_OQ),
+                     _mm256_cmp_ps(py, max_y, _CMP_GT_OQ)));
+    bits &= ~(uint32_t)_mm256_movemask_ps(out);
+    store_block_bits<8>(active, i, bits);
+
+    __m256 move = lane_mask(bits);
+    __m256 nx = _mm256_add_ps(px, _mm256_mul_ps(_mm256_loadu_ps(vx + i), step));
+    __m256 ny = _mm256_add_ps(py, _mm256_mul_ps(_mm256_loadu_ps(vy + i), step));
+    _mm256_storeu_ps(x + i, _mm256_blendv_ps(px, nx, move));
+    _mm256_storeu_ps(y + i, _mm256_blendv_ps(py, ny, move));
+  }
+}
+
+void IntegrateAngles(float *angle, const float *speed,
+                     const ActiveMask &active, size_t slots, float dt) {
+  assert(slots % 8 == 0);
+  const __m256 step = _mm256_set1_ps(dt);
+  for (size_t i = 0; i < slots; i += 8) {
+    uint32_t bits = block_bits<8>(active, i);
+    if (!bits)
+      continue;
+    __m256 a = _mm256_loadu_ps(angle + i);
+    __m256 na =
+        _mm256_add_ps(a, _mm256_mul_ps(_mm256_loadu_ps(speed + i), step));
+    _mm256_storeu_ps(angle + i, _mm256_blendv_ps(a, na, lane_mask(bits)));
+  }
+}
+
+const char *IntegrationKernels() { return "AVX2"; }
+
+#elif defined(__SSE2__)
+
+static __m128 lane_mask(uint32_t bits) {
+  const __m128i select = _mm_setr_epi32(1, 2, 4, 8);
+  __m128i set = _mm_and_si128(_mm_set1_epi32(bits), select);
+  return _mm_castsi128_ps(_mm_cmpeq_epi32(set, select));
+}
+
+static __m128 select(__m128 mask, __m128 a, __m128 b) {
+  return _mm_or_ps(_mm_and_ps(mask, b), _mm_andnot_ps(mask, a));
+}
+
+void IntegrateAndCollect(float *x, float *y, const float *vx, const float *vy,
+                         ActiveMask &active, size_t slots, float dt) {
+  assert(slots % 4 == 0);
+  const __m128 min_x = _mm_set1_ps(MIN_X), max_x = _mm_set1_ps(MAX_X);
+  const __m128 min_y = _mm_set1_ps(MIN_Y), max_y = _mm_set1_ps(MAX_Y);
+  const __m128 step = _mm_set1_ps(dt);
+  for (size_t i = 0; i < slots; i += 4) {
+    uint32_t bits = block_bits<4>(active, i);
+    if (!bits)
+      continue;
+    __m128 px = _mm_loadu_ps(x + i), py = _mm_loadu_ps(y + i);
+    __m128 out =
+        _mm_or_ps(_mm_or_ps(_mm_cmplt_ps(px, min_x), _mm_cmpgt_ps(px, max_x)),
+                  _mm_or_ps(_mm_cmplt_ps(py, min_y), _mm_cmpgt_ps(py, max_y)));
+    bits &= ~(uint32_t)_mm_movemask_ps(out);
+    store_block_bits<4>(active, i, bits);
+
+    __m128 move = lane_mask(bits);
+    __m128 nx = _mm_add_ps(px, _mm_mul_ps(_mm_loadu_ps(vx + i), step));
+    __m128 ny = _mm_add_ps(py, _mm_mul_ps(_mm_loadu_ps(vy + i), step));
+    _mm_storeu_ps(x + i, select(move, px, nx));
+    _mm_storeu_ps(y + i, select(move, py, ny));
+  }
+}
+
+void IntegrateAngles(float *angle, const float *speed,
+                     const ActiveMask &active, size_t slots, float dt) {
+  assert(slots % 4 == 0);
+  const __m128 step = _mm_set1_ps(dt);
+  for (size_t i = 0; i < slots; i += 4) {
+    uint32_t bits = block_bits<4>(active, i);
+    if (!bits)
+      continue;
+    __m128 a = _mm_loadu_ps(angle + i);
+    __m128 na = _mm_add_ps(a, _mm_mul_ps(_mm_loadu_ps(speed + i), step));
+    _mm_storeu_ps(angle + i, select(lane_mask(bits), a, na));
+  }
+}
+
+const char *IntegrationKernels() { return "SSE2"; }
+
+#else
+
+void IntegrateAndCollect(float *x, float *y, const float *vx, const float *vy,
+                         ActiveMask &active, size_t slots, float dt) {
+  for (size_t i = 0; i < slots; i++) {
+    if (!active.test(i))
+      continue;
+    if (SpaceJunkCollector(Vector2{x[i], y[i]})) {
+      active.set(i, false);
+      continue;
+    }
+    x[i] += vx[i] * dt;
+    y[i] += vy[i] * dt;
+  }
+}
+
+void IntegrateAngles(float *angle, const float *speed,
+                     const ActiveMask &active, size_t slots, float dt) {
+  for (size_t i = 0; i < slots; i++) {
+    if (active.test(i))
+      angle[i] += speed[i] * dt;
+  }
+}
+
+const char *IntegrationKernels() { return "scalar"; }
+
+#endif
+
+void IntegrateAndCollectFixed(float *x, float *y, const float *vx,
+                              const float *vy, ActiveMask &active,
+                              size_t slots, uint32_t tick_rate) {
+  for (size_t i = 0; i < slots; i++) {
+    if (!active.test(i))
+      continue;
+    if (SpaceJunkCollector(Vector2{x[i], y[i]})) {
+      active.set(i, false);
+      continue;
+    }
+    x[i] = FromFixed(ToFixed(x[i]) + FixedPerTick(ToFixed(vx[i]), tick_rate));
+    y[i] = FromFixed(ToFixed(y[i]) + FixedPerTick(ToFixed(vy[i]), tick_rate));
+  }
+}
+
+void IntegrateAnglesFixed(float *angle, const float *speed,
+                          const ActiveMask &active, size_t slots,
+                          uint32_t tick_rate) {
+  for (size_t i = 0; i < slots; i++) {
+    if (active.test(i))
+      angle[i] = FromFixed(FixedWrapAngle(
+          ToFixed(angle[i]) + FixedPerTick(ToFixed(speed[i]), tick_rate)));
+  }
+}
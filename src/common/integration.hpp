@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Slot arrays are padded to whole blocks of the widest kernel, so the
+// kernels never need a scalar tail. Padding slots stay inactive.
+const static size_t INTEGRATION_LANES = 8;
+
+constexpr size_t PaddedSlots(size_t slots) {
+  return (slots + INTEGRATION_LANES - 1) / INTEGRATION_LANES *
+         INTEGRATION_LANES;
+}
+
+// One bit per slot
+struct ActiveMask {
+  std::vector<uint64_t> words;
+
+  // Keeps the bits below count, covers padded slots
+  void resize(size_t count, size_t padded) {
+    words.resize((padded + 63) / 64, 0);
+    for (size_t i = count; i < words.size() * 64; i++)
+      set(i, false);
+  }
+  bool test(size_t i) const { return words[i / 64] >> (i % 64) & 1; }
+  void set(size_t i, bool value) {
+    if (value)
+      words[i / 64] |= uint64_t(1) << (i % 64);
+    else
+      words[i / 64] &= ~(uint64_t(1) << (i % 64));
+  }
+};
+
+// Moves the active slots by velocity * dt. Slots that were already outside
+// the playfield are deactivated instead (SpaceJunkCollector).
+void IntegrateAndCollect(float *x, float *y, const float *vx, const float *vy,
+                         ActiveMask &active, size_t slots, float dt);
+// angle += speed * dt for the active slots
+void IntegrateAngles(float *angle, const float *speed,
+                     const ActiveMask &active, size_t slots, float dt);
+// The same for deterministic rounds, in fixed point (fixedPoint.hpp) and
+// always scalar. Every call is one step of 1/tick_rate seconds, angles are
+// kept in [0, 360).
+void IntegrateAndCollectFixed(float *x, float *y, const float *vx,
+                              const float *vy, ActiveMask &active,
+                              size_t slots, uint32_t tick_rate);
+void IntegrateAnglesFixed(float *angle, const float *speed,
+                          const ActiveMask &active, size_t slots,
+                          uint32_t tick_rate);
+// Instruction set the kernels were built for
+const char *IntegrationKernels();
@@ -20,17 +20,25 @@ bool read_uint32(int fd, uint32_t &v) {
 }
 
 // returns true if ok
-bool write_json(int fd, const json &j) {
-  bool status;
+static bool to_bson(const json &j, std::vector<std::uint8_t> &bson) {
   json jo;
   jo["data"] = j;
-  std::vector<std::uint8_t> bson;
   try {
     bson = json::to_bson(jo);
   } catch (json::parse_error &ex) {
     TraceLog(LOG_ERROR, "JSON: Couldn't convert json object to bson");
     return false;
   }
+  return true;
+}
+
+// returns true if ok
+bool write_json(int fd, const json &j) {
+  bool status;
+  std::vector<std::uint8_t> bson;
+  if (!to_bson(j, bson)) {
+    return false;
+  }
   status = write_uint32(fd, bson.size());
   if (!status) {
     TraceLog(LOG_ERROR, "NET: Couldn't send bson object size %lu", bson.size());
@@ -110,3 +118,40 @@ bool setEvent(int fd, uint32_t event) {
   }
   return status;
 }
+
+bool write_uint32(OutputBuffer &out, uint32_t v) {
+  uint32_t val = htonl(v);
+  out.append(&val, sizeof(val));
+  return true;
+}
+
+bool write_json(OutputBuffer &out, const json &j) {
+  std::vector<std::uint8_t> bson;
+  if (!to_bson(j, bson)) {
+    return false;
+  }
+  write_uint32(out, bson.size());
+  out.append(bson.data(), bson.size());
+  return true;
+}
+
+bool setEvent(OutputBuffer &out, uint32_t event) {
+  return write_uint32(out, event);
+}
+
+bool write_uint32(std::vector<std::uint8_t> &out, uint32_t v) {
+  uint32_t val = htonl(v);
+  const std::uint8_t *bytes = (const std::uint8_t *)&val;
+  out.insert(out.end(), bytes, bytes + sizeof(val));
+  return true;
+}
+
+bool write_json(std::vector<std::uint8_t> &out, const json &j) {
+  std::vector<std::uint8_t> bson;
+  if (!to_bson(j, bson)) {
+    return false;
+  }
+  write_uint32(out, bson.size());
+  out.insert(out.end(), bson.begin(), bson.end());
+  return true;
+}
@@ -2,6 +2,8 @@
 #include <netinet/in.h>
 #include <nlohmann/json.hpp>
 #include <unistd.h>
+
+#include "outputBuffer.hpp"
 using json = nlohmann::json;
 
 bool write_uint32(int fd, uint32_t v);
@@ -15,3 +17,14 @@ bool read_json(int fd, json &j, size_t maxsize);
 bool expectEvent(int fd, uint32_t expected_event);
 
 bool setEvent(int fd, uint32_t event);
+
+// Buffered variants, bytes are sent on OutputBuffer::flush
+bool write_uint32(OutputBuffer &out, uint32_t v);
+
+bool write_json(OutputBuffer &out, const json &j);
+
+bool setEvent(OutputBuffer &out, uint32_t event);
+
+// Encode into a plain byte vector (messages shared between clients)
+bool write_uint32(std::vector<std::uint8_t> &out, uint32_t v);
+bool write_json(std::vector<std::uint8_t> &out, const json &j);
@@ -41,11 +41,9 @@ public:
 
   T pop() {
     TraceLog(LOG_DEBUG, "NET: popping element to network queue");
-    {
-      std::unique_lock<std::mutex> lock(mutex);
-    }
     uint64_t one;
     read(efd, &one, sizeof(one));
+    std::unique_lock<std::mutex> lock(mutex);
     T item = queue.front();
     queue.pop();
     return item;
@@ -0,0 +1,91 @@
+#pragma once
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+
+// Lock-free multi-producer single-consumer queue (intrusive Vyukov queue).
+// Producers only signal the eventfd when the consumer has no wakeup pending,
+// so a burst of pushes costs a single write() and the consumer drains the
+// whole backlog per epoll wakeup.
+// T has to be default constructible (used for the stub node).
+template <typename T> struct MpscQueue {
+private:
+  struct Node {
+    std::atomic<Node *> next = nullptr;
+    T item;
+  };
+
+  std::atomic<Node *> head; // Producers append here
+  Node *tail;               // Consumer only
+  Node stub;
+  std::atomic_bool signaled = false;
+  int efd;
+
+  bool pop(T &item) {
+    Node *t = tail;
+    Node *next = t->next.load(std::memory_order_acquire);
+    if (next == nullptr) {
+      // Empty, or a producer is between exchange and linking its node
+      return false;
+    }
+    item = std::move(next->item);
+    tail = next;
+    if (t != &stub)
+      delete t;
+    return true;
+  }
+
+public:
+  MpscQueue() : head(&stub), tail(&stub) {
+    efd = eventfd(0, EFD_NONBLOCK);
+    if (efd == -1) {
+      throw std::runtime_error{"Eventfd MpscQueue"};
+    }
+  }
+  ~MpscQueue() {
+    T item;
+    while (pop(item)) {
+    }
+    if (tail != &stub)
+      delete tail;
+    close(efd);
+  }
+  MpscQueue(const MpscQueue &) = delete;
+  MpscQueue &operator=(const MpscQueue &) = delete;
+
+  int get_event_fd() { return efd; }
+
+  void push(T item) {
+    Node *node = new Node;
+    node->item = std::move(item);
+    Node *prev = head.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+
+    if (!signaled.exchange(true, std::memory_order_acq_rel)) {
+      const uint64_t one = 1;
+      write(efd, &one, sizeof(one));
+    }
+  }
+
+  // Consumes everything pushed so far, consume(T &) returns false to stop
+  // early. Returns the number of consumed items.
+  template <typename F> size_t drain(F consume) {
+    uint64_t count;
+    read(efd, &count, sizeof(count));
+    // Clear before popping, pushes from now on will signal again. Acquiring
+    // the flag also makes every node linked before it was set visible.
+    signaled.exchange(false, std::memory_order_acq_rel);
+
+    size_t consumed = 0;
+    T item;
+    while (pop(item)) {
+      consumed++;
+      if (!consume(item))
+        break;
+    }
+    return consumed;
+  }
+};
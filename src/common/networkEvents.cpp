@@ -30,6 +30,8 @@ const std::string network_event_to_string(NetworkEvents networkEvent) {
     return "VoteReady";
   case NetworkEvents::PlayerMovement:
     return "PlayerMovement";
+  case NetworkEvents::PlayerInput:
+    return "PlayerInput";
   case NetworkEvents::PlayerDestroyed:
     return "PlayerDestroyed";
   case NetworkEvents::GetRoomList:
@@ -46,6 +48,10 @@ const std::string network_event_to_string(NetworkEvents networkEvent) {
     return "UpdatePlayers";
   case NetworkEvents::UpdateAsteroids:
     return "UpdateAsteroids";
+  case NetworkEvents::WorldSnapshot:
+    return "WorldSnapshot";
+  case NetworkEvents::SnapshotAck:
+    return "SnapshotAck";
   case NetworkEvents::SpawnAsteroid:
     return "SpawnAsteroid";
   case NetworkEvents::AsteroidDestroyed:
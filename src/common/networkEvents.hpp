@@ -18,7 +18,8 @@ enum NetworkEvents {
   // Player
   GetClientId = 100,
   VoteReady = 110,
-  PlayerMovement = 120,
+  PlayerMovement = 120, // Relayed by the server
+  PlayerInput = 130,    // Numbered input commands of a client
   PlayerDestroyed = 140,
 
   // Room
@@ -32,6 +33,9 @@ enum NetworkEvents {
   UpdatePlayers = 320,
   UpdateAsteroids = 330,
   UpdateBullets = 340,
+  WorldSnapshot = 350, // Delta against an acknowledged snapshot
+  // Snapshot id and the client's interpolation delay in microseconds
+  SnapshotAck = 360,
 
   // Asteroid
   SpawnAsteroid = 400,
@@ -0,0 +1,96 @@
+#include "outputBuffer.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+void OutputBuffer::append(const void *data, size_t size) {
+  const uint8_t *bytes = (const uint8_t *)data;
+  if (segments.empty() || segments.back().shared ||
+      segments.back().owned.size() + size > SEGMENT_SIZE) {
+    segments.emplace_back();
+    segments.back().owned.reserve(std::max(size, SEGMENT_SIZE));
+  }
+  auto &owned = segments.back().owned;
+  owned.insert(owned.end(), bytes, bytes + size);
+  queued += size;
+}
+
+void OutputBuffer::append(SharedBytes bytes) {
+  if (!bytes || bytes->empty())
+    return;
+  queued += bytes->size();
+  segments.push_back(Segment{{}, std::move(bytes)});
+}
+
+void OutputBuffer::clear() {
+  segments.clear();
+  sent_offset = 0;
+  queued = 0;
+}
+
+size_t OutputBuffer::gather(iovec *iov, size_t max_iov) const {
+  size_t iovcnt = 0;
+  for (auto i = segments.begin(); i != segments.end() && iovcnt < max_iov;
+       i++, iovcnt++) {
+    auto &bytes = i->bytes();
+    size_t offset = iovcnt == 0 ? sent_offset : 0;
+    iov[iovcnt].iov_base = (void *)(bytes.data() + offset);
+    iov[iovcnt].iov_len = bytes.size() - offset;
+  }
+  return iovcnt;
+}
+
+void OutputBuffer::consume(size_t written) {
+  bytes_sent += written;
+  queued -= written;
+
+  // Drop fully sent segments
+  while (written > 0) {
+    size_t segment_left = segments.front().bytes().size() - sent_offset;
+    if (written < segment_left) {
+      sent_offset += written;
+      break;
+    }
+    written -= segment_left;
+    sent_offset = 0;
+    segments.pop_front();
+  }
+}
+
+bool OutputBuffer::flush(int fd, bool cork) {
+  if (empty())
+    return true;
+
+  const int one = 1, zero = 0;
+  if (cork)
+    setsockopt(fd, IPPROTO_TCP, TCP_CORK, &one, sizeof(one));
+
+  flushes++;
+  bool status = true;
+  while (!empty()) {
+    iovec iov[IOV_MAX];
+    msghdr msg{};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = gather(iov, IOV_MAX);
+    ssize_t written = sendmsg(fd, &msg, MSG_NOSIGNAL);
+    syscalls++;
+    if (written == -1 && errno == EINTR)
+      continue;
+    if (written == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      break; // Non-blocking socket is full, the rest stays queued
+    if (written <= 0) {
+      status = false;
+      break;
+    }
+    consume(written);
+  }
+
+  if (cork)
+    setsockopt(fd, IPPROTO_TCP, TCP_CORK, &zero, sizeof(zero));
+  return status;
+}
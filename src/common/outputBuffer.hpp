@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <sys/uio.h>
+#include <vector>
+
+// Immutable encoded messages shared by many output buffers (room broadcasts)
+using SharedBytes = std::shared_ptr<const std::vector<uint8_t>>;
+
+// Bytes queued for a socket, sent with as few syscalls as possible
+struct OutputBuffer {
+  static constexpr size_t SEGMENT_SIZE = 16 * 1024;
+
+  // Either bytes owned by this buffer or a reference to a shared broadcast
+  struct Segment {
+    std::vector<uint8_t> owned;
+    SharedBytes shared;
+
+    const std::vector<uint8_t> &bytes() const {
+      return shared ? *shared : owned;
+    }
+  };
+
+  std::deque<Segment> segments;
+  size_t sent_offset = 0; // Already sent bytes of the first segment
+  size_t queued = 0;      // Bytes waiting to be sent
+
+  // Counters since creation
+  uint64_t flushes = 0;
+  uint64_t syscalls = 0;
+  uint64_t bytes_sent = 0;
+
+  bool empty() const { return queued == 0; }
+  void append(const void *data, size_t size);
+  // Queues shared bytes without copying them
+  void append(SharedBytes bytes);
+  void clear();
+
+  // Fills iov with the queued bytes, returns the number of used entries
+  size_t gather(iovec *iov, size_t max_iov) const;
+  // Drops bytes already sent
+  void consume(size_t written);
+
+  // Sends everything queued with sendmsg (one iovec per segment), on a full
+  // non-blocking socket the rest stays queued. returns true if ok
+  bool flush(int fd, bool cork = false);
+};
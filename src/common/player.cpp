@@ -1,15 +1,16 @@
 #include "player.hpp"
 #include "colorjson.hpp"
 #include "constants.hpp"
+#include "fixedPoint.hpp"
 #include "vec2json.hpp"
 
-Player AddPlayer(int i) {
+Player AddPlayer(int i, RoomRandom &random) {
   assert(i >= 0 && i <= Constants::PLAYERS_MAX);
   Player player;
   player.active = false;
   player.position = GetPlayerSpawnPosition(i);
   player.velocity = {0, 0}; // Direct initialization of the velocity vector
-  player.rotation = (float)GetRandomValue(0, 360);
+  player.rotation = (float)random.value(0, 360);
   player.player_color = Constants::PLAYER_COLORS[i];
   return player;
 }
@@ -38,19 +39,81 @@ void CalculateUpdatePlayerMovement(Player &player, duration<double> frametime) {
   player.player_color.a = player.active ? 255 : 25;
 }
 
-void CheckMovementUpdatePlayer(Player &player, duration<double> frametime) {
-  int rot = (int)(IsKeyDown(KEY_RIGHT) || IsKeyDown(KEY_D)) -
-            (int)(IsKeyDown(KEY_LEFT) || IsKeyDown(KEY_A));
-  player.rotation += rot * Constants::PLAYER_ROTATION_SPEED * frametime.count();
+void CalculateUpdatePlayerMovementFixed(Player &player, uint32_t tick_rate) {
+  const int32_t drag = ToFixed(Constants::PLAYER_DRAG);
+  const int32_t width = Constants::screenWidth * FIXED_ONE;
+  const int32_t height = Constants::screenHeight * FIXED_ONE;
+  FixedVector2 velocity = ToFixed(player.velocity);
+  FixedVector2 position = ToFixed(player.position);
 
-  if (IsKeyDown(KEY_UP) || IsKeyDown(KEY_W)) {
+  // Damping of PLAYER_DRAG per mille
+  velocity.x -= int32_t(int64_t(velocity.x) * drag / (1000 * FIXED_ONE));
+  velocity.y -= int32_t(int64_t(velocity.y) * drag / (1000 * FIXED_ONE));
+
+  position.x += FixedPerTick(velocity.x, tick_rate);
+  position.y += FixedPerTick(velocity.y, tick_rate);
+
+  if (position.x < 0)
+    position.x += width;
+  if (position.x > width)
+    position.x -= width;
+  if (position.y < 0)
+    position.y += height;
+  if (position.y > height)
+    position.y -= height;
+
+  player.velocity = FromFixed(velocity);
+  player.position = FromFixed(position);
+  player.player_color.a = player.active ? 255 : 25;
+}
+
+uint32_t ReadInputButtons() {
+  uint32_t buttons = InputNone;
+  if (IsKeyDown(KEY_LEFT) || IsKeyDown(KEY_A))
+    buttons |= InputLeft;
+  if (IsKeyDown(KEY_RIGHT) || IsKeyDown(KEY_D))
+    buttons |= InputRight;
+  if (IsKeyDown(KEY_UP) || IsKeyDown(KEY_W))
+    buttons |= InputThrust;
+  if (Shoot())
+    buttons |= InputFire;
+  return buttons;
+}
+
+void ApplyInputButtons(Player &player, uint32_t buttons,
+                       duration<double> step, uint32_t fixed_tick_rate) {
+  int rot = (int)(buttons & InputRight ? 1 : 0) -
+            (int)(buttons & InputLeft ? 1 : 0);
+  bool thrust = buttons & InputThrust;
+
+  if (fixed_tick_rate) {
+    int32_t rotation = FixedWrapAngle(
+        ToFixed(player.rotation) +
+        rot * FixedPerTick(ToFixed(Constants::PLAYER_ROTATION_SPEED),
+                           fixed_tick_rate));
+    player.rotation = FromFixed(rotation);
+    if (thrust) {
+      int32_t acceleration = FixedPerTick(
+          ToFixed(Constants::PLAYER_ACCELERATION), fixed_tick_rate);
+      FixedVector2 velocity = ToFixed(player.velocity);
+      velocity.x += FixedScale(acceleration, FixedCos(rotation));
+      velocity.y += FixedScale(acceleration, FixedSin(rotation));
+      player.velocity = FromFixed(velocity);
+    }
+    CalculateUpdatePlayerMovementFixed(player, fixed_tick_rate);
+    return;
+  }
+
+  player.rotation += rot * Constants::PLAYER_ROTATION_SPEED * step.count();
+  if (thrust) {
     Vector2 direction = {cosf(DEG2RAD * player.rotation),
                          sinf(DEG2RAD * player.rotation)};
     player.velocity =
         Vector2Add(player.velocity,
                    Vector2Scale(direction, Constants::PLAYER_ACCELERATION *
-                                               frametime.count()));
+                                               step.count()));
   }
+  CalculateUpdatePlayerMovement(player, step);
 }
 
 bool Shoot() { return IsKeyPressed(KEY_SPACE); }
@@ -74,3 +137,26 @@ void from_json(const json &j, Player &p) {
   j.at("rotation").get_to(p.rotation);
   j.at("color").get_to(p.player_color);
 }
+
+void to_json(json &j, const Movement &m) {
+  j = json{{"position", m.position},
+           {"velocity", m.velocity},
+           {"rotation", m.rotation},
+           {"active", m.active},
+           {"input_tick", m.input_tick}};
+}
+void from_json(const json &j, Movement &m) {
+  j.at("position").get_to(m.position);
+  j.at("velocity").get_to(m.velocity);
+  j.at("rotation").get_to(m.rotation);
+  j.at("active").get_to(m.active);
+  j.at("input_tick").get_to(m.input_tick);
+}
+
+void to_json(json &j, const InputState &s) {
+  j = json{{"tick", s.tick}, {"buttons", s.buttons}};
+}
+void from_json(const json &j, InputState &s) {
+  j.at("tick").get_to(s.tick);
+  j.at("buttons").get_to(s.buttons);
+}
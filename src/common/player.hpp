@@ -1,4 +1,5 @@
 #pragma once
+#include "roomRandom.hpp"
 #include <nlohmann/json.hpp>
 #include <raylib.h>
 #include <raymath.h>
@@ -21,13 +22,54 @@ struct Player {
   uint32_t player_id = 0;
 };
 
-Player AddPlayer(int i);
+// State of a player relayed by the server. Its own client also learns the
+// last of its input ticks the state includes, to replay the newer ones on
+// top.
+struct Movement {
+  Vector2 position;
+  Vector2 velocity;
+  float rotation;
+  bool active = true;
+  uint32_t input_tick = 0;
+};
+
+enum InputButtons : uint32_t {
+  InputNone = 0,
+  InputLeft = 1 << 0,
+  InputRight = 1 << 1,
+  InputThrust = 1 << 2,
+  InputFire = 1 << 3, // Only on the tick the shot was fired
+};
+
+// Buttons a client holds from its input tick on. Clients step their player
+// once per server tick and number the steps, a state is only sent when the
+// buttons change.
+struct InputState {
+  uint32_t tick = 0;
+  uint32_t buttons = InputNone;
+};
+
+Player AddPlayer(int i, RoomRandom &random);
 
 bool Shoot();
 
 Vector2 GetPlayerSpawnPosition(int i);
 void CalculateUpdatePlayerMovement(Player &player, duration<double> frametime);
-void CheckMovementUpdatePlayer(Player &player, duration<double> frametime);
+// One step of a deterministic round, in fixed point (fixedPoint.hpp)
+void CalculateUpdatePlayerMovementFixed(Player &player, uint32_t tick_rate);
+// Buttons held on the keyboard, fire when it was just pressed
+uint32_t ReadInputButtons();
+// One tick of a player holding buttons: turns and thrusts, then moves it
+// for step, or for one step of a deterministic round. Firing is up to the
+// caller.
+void ApplyInputButtons(Player &player, uint32_t buttons,
+                       duration<double> step, uint32_t fixed_tick_rate);
 
 void to_json(json &j, const Player &p);
 void from_json(const json &j, Player &p);
+
+void to_json(json &j, const Movement &m);
+void from_json(const json &j, Movement &m);
+
+void to_json(json &j, const InputState &s);
+void from_json(const json &j, InputState &s);
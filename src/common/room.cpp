@@ -5,13 +5,21 @@ void to_json(json &j, const Room &r) {
   j = json{{"room_id", r.room_id},
            {"status", r.status},
            {"players", r.players},
-           {"name", r.name}};
+           {"name", r.name},
+           {"type", r.type},
+           {"tick_rate", r.tick_rate},
+           {"deterministic", r.deterministic},
+           {"seed", r.seed}};
 }
 void from_json(const json &j, Room &r) {
   j.at("room_id").get_to(r.room_id);
   j.at("status").get_to(r.status);
   j.at("players").get_to(r.players);
   j.at("name").get_to(r.name);
+  j.at("type").get_to(r.type);
+  j.at("tick_rate").get_to(r.tick_rate);
+  j.at("deterministic").get_to(r.deterministic);
+  j.at("seed").get_to(r.seed);
 }
 
 void to_json(json &j, const PlayerIdState &p) {
@@ -1,6 +1,7 @@
 #pragma once
 #include "gameStatus.hpp"
 #include "player.hpp"
+#include "roomConfig.hpp"
 #include <nlohmann/json.hpp>
 #include <vector>
 
@@ -16,6 +17,13 @@ struct Room {
   std::vector<PlayerIdState> players;
   GameStatus status = GameStatus::LOBBY;
   std::string name;
+  RoomType type = RoomType::Classic;
+  // Server ticks per second, players are stepped once per tick. Rounds of
+  // deterministic rooms are stepped in fixed point at this rate from seed,
+  // which changes every round (GameManager::fixed_tick_rate).
+  uint32_t tick_rate = 0;
+  bool deterministic = false;
+  uint32_t seed = 0;
 };
 
 // Room &at_room_id(std::vector<Room> &rooms, uint32_t room_id);
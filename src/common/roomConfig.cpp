@@ -0,0 +1,22 @@
+#include "roomConfig.hpp"
+
+const char *room_type_name(RoomType type) {
+  switch (type) {
+  case RoomType::Duel:
+    return "duel";
+  case RoomType::Arena:
+    return "arena";
+  default:
+    return "classic";
+  }
+}
+
+bool parse_room_type(const std::string &name, RoomType &type) {
+  for (auto t : {RoomType::Classic, RoomType::Duel, RoomType::Arena}) {
+    if (name == room_type_name(t)) {
+      type = t;
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include "constants.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+using namespace std::chrono;
+
+enum class RoomType : uint32_t { Classic, Duel, Arena };
+
+// Capacities of a room type. They are compile-time constants, so the
+// simulation instantiated for a type loops over fixed bounds.
+struct ClassicRoom {
+  static constexpr RoomType TYPE = RoomType::Classic;
+  static constexpr size_t PLAYERS = Constants::PLAYERS_MAX;
+  static constexpr size_t ASTEROIDS = Constants::ASTEROIDS_MAX;
+  static constexpr size_t BULLETS_PER_PLAYER = Constants::BULLETS_PER_PLAYER;
+  static constexpr milliseconds ASTEROID_SPAWN_DELAY = 1s;
+};
+
+struct DuelRoom {
+  static constexpr RoomType TYPE = RoomType::Duel;
+  static constexpr size_t PLAYERS = 2;
+  static constexpr size_t ASTEROIDS = 32;
+  static constexpr size_t BULLETS_PER_PLAYER = 3;
+  static constexpr milliseconds ASTEROID_SPAWN_DELAY = 1s;
+};
+
+struct ArenaRoom {
+  static constexpr RoomType TYPE = RoomType::Arena;
+  static constexpr size_t PLAYERS = Constants::PLAYERS_MAX;
+  static constexpr size_t ASTEROIDS = 512;
+  static constexpr size_t BULLETS_PER_PLAYER = 5;
+  static constexpr milliseconds ASTEROID_SPAWN_DELAY = 150ms;
+};
+
+// Calls f with the config of type, f(ClassicRoom{}) for unknown ones
+template <typename F> decltype(auto) WithRoomConfig(RoomType type, F &&f) {
+  switch (type) {
+  case RoomType::Duel:
+    return f(DuelRoom{});
+  case RoomType::Arena:
+    return f(ArenaRoom{});
+  default:
+    return f(ClassicRoom{});
+  }
+}
+
+// Lower case name used on the command line
+const char *room_type_name(RoomType type);
+// false when name isn't one of the names above
+bool parse_room_type(const std::string &name, RoomType &type);
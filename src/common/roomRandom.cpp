@@ -0,0 +1,16 @@
+#include "roomRandom.hpp"
+#include <utility>
+
+int RoomRandom::value(int min, int max) {
+  if (min > max)
+    std::swap(min, max);
+  uint64_t range = uint64_t(int64_t(max) - min) + 1;
+  return int(min + int64_t(next() % range));
+}
+
+uint64_t RoomRandom::next() {
+  uint64_t z = state += 0x9E3779B97F4A7C15;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+  return z ^ (z >> 31);
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include <cstdint>
+
+// Random numbers of a room, drawn from the round's seed so every machine
+// simulating the round draws the same ones. Unlike raylib's global
+// generator, concurrent rooms don't share it.
+struct RoomRandom {
+  uint64_t state = 0;
+
+  RoomRandom() = default;
+  explicit RoomRandom(uint32_t seed) : state(seed) {}
+
+  // Like GetRandomValue: in [min, max], bounds in either order
+  int value(int min, int max);
+  // splitmix64
+  uint64_t next();
+};
@@ -0,0 +1,72 @@
+#include "slotPool.hpp"
+
+SlotPool::SlotPool(size_t first, size_t count) : first(first), next(count) {
+  held.resize(0, first + count);
+  retired.resize(0, first + count);
+  for (size_t i = count; i-- > 0;) {
+    next[i] = head;
+    head = first + i;
+  }
+}
+
+uint32_t SlotPool::allocate(const ActiveMask &active) {
+  if (head == NONE)
+    reclaim(active);
+  while (head != NONE) {
+    uint32_t slot = head;
+    head = next[slot - first];
+    held.set(slot, true);
+    // Filled while it was on the list, e.g. from a snapshot. It is held now
+    // and comes back once it is deactivated again.
+    if (active.test(slot)) {
+      if (head == NONE)
+        reclaim(active);
+      continue;
+    }
+    return slot;
+  }
+  exhausted++;
+  return NONE;
+}
+
+void SlotPool::release(uint32_t slot) {
+  if (slot < first || slot >= first + next.size() || !held.test(slot))
+    return;
+  held.set(slot, false);
+  next[slot - first] = head;
+  head = slot;
+}
+
+void SlotPool::reclaim(const ActiveMask &active) {
+  if (next.empty())
+    return;
+  // Only slots in the range are ever held
+  for (size_t w = first / 64; w <= (first + next.size() - 1) / 64; w++) {
+    uint64_t freed = held.words[w] & ~active.words[w] & ~retired.words[w];
+    while (freed) {
+      release(w * 64 + __builtin_ctzll(freed));
+      freed &= freed - 1;
+    }
+  }
+}
+
+void SlotPool::retire(uint32_t slot) {
+  if (slot >= first && slot < first + next.size() && held.test(slot))
+    retired.set(slot, true);
+}
+
+void SlotPool::release_retired() {
+  for (size_t w = 0; w < retired.words.size(); w++) {
+    uint64_t bits = retired.words[w];
+    retired.words[w] = 0;
+    while (bits) {
+      release(w * 64 + __builtin_ctzll(bits));
+      bits &= bits - 1;
+    }
+  }
+}
+
+size_t SlotPool::heap_bytes() const {
+  return next.capacity() * sizeof(uint32_t) +
+         (held.words.capacity() + retired.words.capacity()) * sizeof(uint64_t);
+}
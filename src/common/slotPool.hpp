@@ -0,0 +1,40 @@
+#pragma once
+#include "integration.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Intrusive free list over the slots [first, first + count) of an
+// ActiveMask. Every slot is either held by the pool's owner or linked into
+// the list through next, so allocate and release never scan. Slots that are
+// deactivated behind the pool's back, by the integration kernels or by the
+// network code, come back through reclaim, which compares the mask with the
+// held slots a word at a time. Retired slots stay held until
+// release_retired, so a pass over the slots doesn't see one it freed
+// refilled.
+struct SlotPool {
+  static const uint32_t NONE = UINT32_MAX;
+
+  size_t first = 0;
+  std::vector<uint32_t> next;
+  ActiveMask held, retired;
+  uint32_t head = NONE;
+  // Allocations that found no free slot
+  uint64_t exhausted = 0;
+
+  SlotPool() = default;
+  // All slots start free and are handed out lowest first
+  SlotPool(size_t first, size_t count);
+
+  // Marks a free slot held, NONE when there is none
+  uint32_t allocate(const ActiveMask &active);
+  // Puts a held slot back on the list, other slots are ignored
+  void release(uint32_t slot);
+  // Releases the held slots that are no longer active, except retired ones
+  void reclaim(const ActiveMask &active);
+  // Keeps a held slot from being reused until release_retired
+  void retire(uint32_t slot);
+  void release_retired();
+  // Allocated by the pool
+  size_t heap_bytes() const;
+};
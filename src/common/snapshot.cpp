@@ -0,0 +1,238 @@
+#include "snapshot.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <netinet/in.h>
+
+#include "jsonutils.hpp"
+
+static uint32_t to_word(float f) {
+  uint32_t w;
+  memcpy(&w, &f, sizeof(w));
+  return w;
+}
+
+static float to_float(uint32_t w) {
+  float f;
+  memcpy(&f, &w, sizeof(f));
+  return f;
+}
+
+Snapshot::Snapshot(RoomType type) : type(type) {
+  WithRoomConfig(type, [this](auto config) {
+    using Config = decltype(config);
+    asteroids = Config::ASTEROIDS;
+    players = Config::PLAYERS;
+    bullets = Config::PLAYERS * Config::BULLETS_PER_PLAYER;
+  });
+  words.resize(asteroids * ASTEROID_WORDS + players * PLAYER_WORDS +
+               bullets * BULLET_WORDS);
+}
+
+void Snapshot::entity_words(size_t entity, size_t &offset,
+                            size_t &count) const {
+  if (entity < asteroids) {
+    offset = entity * ASTEROID_WORDS;
+    count = ASTEROID_WORDS;
+    return;
+  }
+  entity -= asteroids;
+  offset = asteroids * ASTEROID_WORDS;
+  if (entity < players) {
+    offset += entity * PLAYER_WORDS;
+    count = PLAYER_WORDS;
+    return;
+  }
+  entity -= players;
+  offset += players * PLAYER_WORDS + entity * BULLET_WORDS;
+  count = BULLET_WORDS;
+}
+
+size_t Snapshot::max_delta_size(RoomType type) {
+  Snapshot layout(type);
+  return (4 + layout.entities() + layout.words.size()) * sizeof(uint32_t);
+}
+
+const Snapshot &Snapshot::empty(RoomType type) {
+  static const Snapshot empty[] = {Snapshot(RoomType::Classic),
+                                   Snapshot(RoomType::Duel),
+                                   Snapshot(RoomType::Arena)};
+  return empty[(size_t)type < std::size(empty) ? (size_t)type : 0];
+}
+
+void Snapshot::capture(const GameManager &gm, uint32_t snapshot_id) {
+  id = snapshot_id;
+  std::fill(words.begin(), words.end(), 0);
+  size_t offset, count;
+
+  const AsteroidArrays &a = gm.asteroids;
+  for (size_t i = 0; i < std::min(a.count(), asteroids); i++) {
+    if (!a.is_active(i))
+      continue;
+    entity_words(i, offset, count);
+    uint32_t *w = &words[offset];
+    // Active, and which asteroid holds the slot
+    w[0] = 1 | a.spawns[i] << 1;
+    w[1] = to_word(a.x[i]);
+    w[2] = to_word(a.y[i]);
+    w[3] = to_word(a.vx[i]);
+    w[4] = to_word(a.vy[i]);
+    w[5] = to_word(a.rotation[i]);
+    w[6] = to_word(a.rotation_speed[i]);
+    w[7] = a.size[i];
+    w[8] = a.polygon[i];
+  }
+
+  for (size_t i = 0; i < std::min(gm.players.size(), players); i++) {
+    const Player &p = gm.players[i];
+    if (!p.active)
+      continue;
+    entity_words(asteroids + i, offset, count);
+    uint32_t *w = &words[offset];
+    w[0] = 1;
+    w[1] = to_word(p.position.x);
+    w[2] = to_word(p.position.y);
+    w[3] = to_word(p.velocity.x);
+    w[4] = to_word(p.velocity.y);
+    w[5] = to_word(p.rotation);
+  }
+
+  const BulletArrays &b = gm.bullets;
+  for (size_t i = 0; i < std::min(b.count(), bullets); i++) {
+    if (!b.is_active(i))
+      continue;
+    entity_words(asteroids + players + i, offset, count);
+    uint32_t *w = &words[offset];
+    w[0] = 1;
+    w[1] = to_word(b.x[i]);
+    w[2] = to_word(b.y[i]);
+    w[3] = to_word(b.rotation[i]);
+  }
+}
+
+void Snapshot::apply(GameManager &gm, uint32_t local_player_id) const {
+  size_t offset, count;
+  AsteroidArrays &a = gm.asteroids;
+  a.resize(asteroids);
+  for (size_t i = 0; i < asteroids; i++) {
+    entity_words(i, offset, count);
+    const uint32_t *w = &words[offset];
+    a.active.set(i, w[0]);
+    if (!w[0])
+      continue;
+    a.spawns[i] = w[0] >> 1;
+    a.x[i] = to_float(w[1]);
+    a.y[i] = to_float(w[2]);
+    a.vx[i] = to_float(w[3]);
+    a.vy[i] = to_float(w[4]);
+    a.rotation[i] = to_float(w[5]);
+    a.rotation_speed[i] = to_float(w[6]);
+    a.size[i] = w[7];
+    a.polygon[i] = w[8];
+  }
+
+  for (size_t i = 0; i < std::min(gm.players.size(), players); i++) {
+    Player &p = gm.players[i];
+    entity_words(asteroids + i, offset, count);
+    const uint32_t *w = &words[offset];
+    p.active = w[0];
+    if (!p.active || i == local_player_id)
+      continue;
+    p.position = {to_float(w[1]), to_float(w[2])};
+    p.velocity = {to_float(w[3]), to_float(w[4])};
+    p.rotation = to_float(w[5]);
+  }
+
+  gm.bullets.resize(bullets);
+  for (size_t i = 0; i < bullets; i++) {
+    entity_words(asteroids + players + i, offset, count);
+    const uint32_t *w = &words[offset];
+    if (!w[0]) {
+      gm.bullets.deactivate(i);
+      continue;
+    }
+    // Recomputes the velocity from the rotation
+    gm.bullets.set(i, Bullet{true, {to_float(w[1]), to_float(w[2])},
+                             to_float(w[3])});
+  }
+}
+
+// Overwrites a word written earlier
+static void patch_uint32(std::vector<uint8_t> &out, size_t pos, uint32_t v) {
+  uint32_t val = htonl(v);
+  memcpy(out.data() + pos, &val, sizeof(val));
+}
+
+void write_snapshot_delta(std::vector<uint8_t> &out, const Snapshot &baseline,
+                          const Snapshot &snapshot) {
+  assert(baseline.type == snapshot.type);
+  size_t size_pos = out.size();
+  write_uint32(out, 0);
+  write_uint32(out, snapshot.id);
+  write_uint32(out, baseline.id);
+  size_t count_pos = out.size();
+  write_uint32(out, 0);
+
+  uint32_t changed = 0;
+  size_t offset, count;
+  for (size_t e = 0; e < snapshot.entities(); e++) {
+    snapshot.entity_words(e, offset, count);
+    uint32_t mask = 0;
+    for (size_t k = 0; k < count; k++) {
+      if (snapshot.words[offset + k] != baseline.words[offset + k])
+        mask |= 1u << k;
+    }
+    if (mask == 0)
+      continue;
+    write_uint32(out, e << 16 | mask);
+    for (size_t k = 0; k < count; k++) {
+      if (mask & (1u << k))
+        write_uint32(out, snapshot.words[offset + k]);
+    }
+    changed++;
+  }
+  patch_uint32(out, count_pos, changed);
+  patch_uint32(out, size_pos, out.size() - size_pos - sizeof(uint32_t));
+}
+
+ReadStatus read_snapshot_header(InputCursor &cursor, uint32_t &snapshot_id,
+                                uint32_t &baseline_id) {
+  uint32_t size;
+  ReadStatus status = cursor.read_uint32(size);
+  if (status != ReadStatus::Ok)
+    return status;
+  if (size < 3 * sizeof(uint32_t))
+    return ReadStatus::Invalid;
+  if (cursor.in.data.size() - cursor.pos < size)
+    return ReadStatus::Incomplete;
+  cursor.read_uint32(snapshot_id);
+  return cursor.read_uint32(baseline_id);
+}
+
+ReadStatus read_snapshot_changes(InputCursor &cursor, const Snapshot &baseline,
+                                 Snapshot &snapshot) {
+  snapshot = baseline;
+  uint32_t changed;
+  ReadStatus status = cursor.read_uint32(changed);
+  if (status != ReadStatus::Ok || changed > snapshot.entities())
+    return ReadStatus::Invalid;
+
+  size_t offset, count;
+  for (uint32_t i = 0; i < changed; i++) {
+    uint32_t entry;
+    if (cursor.read_uint32(entry) != ReadStatus::Ok)
+      return ReadStatus::Invalid;
+    uint32_t e = entry >> 16, mask = entry & 0xffff;
+    if (e >= snapshot.entities())
+      return ReadStatus::Invalid;
+    snapshot.entity_words(e, offset, count);
+    if (mask >> count)
+      return ReadStatus::Invalid;
+    for (size_t k = 0; k < count; k++) {
+      if ((mask & (1u << k)) &&
+          cursor.read_uint32(snapshot.words[offset + k]) != ReadStatus::Ok)
+        return ReadStatus::Invalid;
+    }
+  }
+  return ReadStatus::Ok;
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "gameManager.hpp"
+#include "inputBuffer.hpp"
+
+// World state of one tick flattened into 32-bit words (asteroids, players,
+// bullets in slot order), so two snapshots are compared word by word.
+// Inactive slots are all zero and cost nothing in a delta. The layout
+// follows the capacities of a room type, both ends lay out their
+// snapshots for the room's type.
+struct Snapshot {
+  static const size_t ASTEROID_WORDS = 9;
+  static const size_t PLAYER_WORDS = 6;
+  static const size_t BULLET_WORDS = 4;
+
+  RoomType type = RoomType::Classic;
+  size_t asteroids = 0, players = 0, bullets = 0;
+  uint32_t id = 0; // 0 is the empty world, the baseline of keyframes
+  std::vector<uint32_t> words;
+
+  Snapshot() : Snapshot(RoomType::Classic) {}
+  explicit Snapshot(RoomType type);
+
+  size_t entities() const { return asteroids + players + bullets; }
+  // Words of one entity slot
+  void entity_words(size_t entity, size_t &offset, size_t &count) const;
+  // Largest delta of a room type, header included
+  static size_t max_delta_size(RoomType type);
+  // The empty world of a room type, baseline of keyframes
+  static const Snapshot &empty(RoomType type);
+
+  // gm has to be of the snapshot's type
+  void capture(const GameManager &gm, uint32_t snapshot_id);
+  // Positions of local_player_id are left alone, the client moves it itself
+  void apply(GameManager &gm, uint32_t local_player_id) const;
+};
+
+// Delta against the baseline: every entity with changed words is sent as
+// its slot, a mask of the changed words and their values. Length prefixed,
+// the header is readable before the baseline is looked up.
+void write_snapshot_delta(std::vector<uint8_t> &out, const Snapshot &baseline,
+                          const Snapshot &snapshot);
+ReadStatus read_snapshot_header(InputCursor &cursor, uint32_t &snapshot_id,
+                                uint32_t &baseline_id);
+ReadStatus read_snapshot_changes(InputCursor &cursor, const Snapshot &baseline,
+                                 Snapshot &snapshot);
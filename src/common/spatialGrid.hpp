@@ -0,0 +1,74 @@
+#pragma once
+#include "constants.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <raylib.h>
+#include <vector>
+
+// Uniform grid over the playfield plus the despawn margin, rebuilt every
+// tick. Indices are counting-sorted by cell into one array, so a rebuild
+// doesn't allocate once the vectors have grown. Positions outside the grid
+// are clamped to its border cells, which keeps queries conservative.
+struct SpatialGrid {
+  static const int CELL_SIZE = 64;
+  static constexpr float ORIGIN_X = -Constants::ASTEROID_SIZE_MAX;
+  static constexpr float ORIGIN_Y = -Constants::ASTEROID_SIZE_MAX;
+  static const int COLUMNS =
+      (Constants::screenWidth + 2 * Constants::ASTEROID_SIZE_MAX) / CELL_SIZE +
+      1;
+  static const int ROWS =
+      (Constants::screenHeight + 2 * Constants::ASTEROID_SIZE_MAX) /
+          CELL_SIZE +
+      1;
+
+  std::vector<uint32_t> cell_start = std::vector<uint32_t>(COLUMNS * ROWS + 1);
+  std::vector<uint32_t> items;
+  std::vector<uint32_t> item_cell;
+
+  static int column(float x) {
+    return std::clamp((int)((x - ORIGIN_X) / CELL_SIZE), 0, COLUMNS - 1);
+  }
+  static int row(float y) {
+    return std::clamp((int)((y - ORIGIN_Y) / CELL_SIZE), 0, ROWS - 1);
+  }
+
+  // Indexes the active slots of an AsteroidArrays or BulletArrays by their
+  // position
+  template <typename T> void build(const T &objects) {
+    std::fill(cell_start.begin(), cell_start.end(), 0);
+    item_cell.resize(objects.count());
+    for (size_t i = 0; i < objects.count(); i++) {
+      if (!objects.is_active(i))
+        continue;
+      item_cell[i] = row(objects.y[i]) * COLUMNS + column(objects.x[i]);
+      cell_start[item_cell[i] + 1]++;
+    }
+    for (size_t c = 1; c < cell_start.size(); c++)
+      cell_start[c] += cell_start[c - 1];
+
+    items.resize(cell_start.back());
+    for (size_t i = 0; i < objects.count(); i++) {
+      if (!objects.is_active(i))
+        continue;
+      items[cell_start[item_cell[i]]++] = i;
+    }
+    // The fill above advanced every start to the next cell's
+    std::copy_backward(cell_start.begin(), cell_start.end() - 1,
+                       cell_start.end());
+    cell_start[0] = 0;
+  }
+
+  // Calls visit(index) for every object whose cell overlaps the square
+  // around position, possibly for some further away
+  template <typename F>
+  void query(Vector2 position, float radius, F &&visit) const {
+    int x0 = column(position.x - radius), x1 = column(position.x + radius);
+    int y0 = row(position.y - radius), y1 = row(position.y + radius);
+    for (int y = y0; y <= y1; y++) {
+      for (int c = y * COLUMNS + x0; c <= y * COLUMNS + x1; c++) {
+        for (uint32_t i = cell_start[c]; i < cell_start[c + 1]; i++)
+          visit(items[i]);
+      }
+    }
+  }
+};
@@ -1,15 +1,56 @@
 #pragma once
+#include <chrono>
 #include <cstdint>
 #include <ctime>
+#include <map>
+#include <vector>
+#include <netinet/in.h>
 #include <sys/socket.h>
 #include <unistd.h>
 
+#include "binaryCodec.hpp"
+#include "inputBuffer.hpp"
+#include "outputBuffer.hpp"
+
 struct Client {
   int fd_main;
   uint32_t client_id = 0;
   uint32_t player_id = 0;
   uint32_t room_id = 0;
-  int epd = -1;
+  uint32_t worker_id = 0;
+  uint32_t capabilities = 0; // Accepted in the handshake
+  WireFormat format = WireFormat::Json;
   int todo_fd = -1;
   bool good_connection = true;
+  std::chrono::steady_clock::time_point last_activity;
+
+  // Socket is non-blocking, frames are decoded from `in` once complete
+  InputBuffer in;
+
+  // Handlers only append, the worker flushes once per epoll cycle
+  OutputBuffer out;
+  bool flush_pending = false;
+  bool waiting_for_write = false; // EPOLLOUT armed after a partial flush
+  std::chrono::steady_clock::time_point write_blocked_since;
+
+  // Latest-wins updates held back while the socket is full, keyed by event
+  // and id (e.g. movement per player)
+  std::map<std::pair<uint32_t, uint32_t>, SharedBytes> superseding;
+  uint64_t dropped_updates = 0;
+
+  // Oldest tick broadcast not yet handed to the kernel
+  std::chrono::steady_clock::time_point broadcast_queued;
+
+  // io_uring backend: a sendmsg in flight points into `out`
+  bool send_in_flight = false;
+  bool todo_poll_armed = false;
+  msghdr send_msg{};
+  std::vector<iovec> send_iov;
+
+  // UDP side channel, its address is learned from the first datagram
+  uint32_t udp_token = 0; // 0 when the client didn't ask for it
+  bool udp_received = false;
+  sockaddr_in udp_addr{};
+  uint32_t udp_in_sequence = 0; // Last accepted
+  uint32_t udp_out_sequence = 0;
 };
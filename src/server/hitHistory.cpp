@@ -0,0 +1,53 @@
+#include "hitHistory.hpp"
+#include <algorithm>
+#include <cmath>
+
+HitHistory::HitHistory(unsigned int tick_rate)
+    : frames(std::max(1u, tick_rate) *
+                 duration<double>(Constants::LAG_COMPENSATION_MAX).count() +
+             2) {}
+
+void HitHistory::record(steady_clock::time_point time,
+                        const std::vector<Player> &players) {
+  if (count == frames.size()) {
+    head = (head + 1) % frames.size();
+    count--;
+  }
+  Frame &frame = frames[(head + count) % frames.size()];
+  frame.time = time;
+  for (size_t j = 0; j < std::min(players.size(), frame.x.size()); j++) {
+    frame.x[j] = players[j].position.x;
+    frame.y[j] = players[j].position.y;
+  }
+  count++;
+}
+
+bool HitHistory::rewind(steady_clock::time_point view_time, float *x,
+                        float *y) const {
+  if (count == 0)
+    return false;
+  size_t i = count - 1;
+  while (i > 0 && at(i).time > view_time)
+    i--;
+  const Frame &a = at(i);
+  if (i + 1 == count || view_time <= a.time) {
+    std::copy(a.x.begin(), a.x.end(), x);
+    std::copy(a.y.begin(), a.y.end(), y);
+    return true;
+  }
+  const Frame &b = at(i + 1);
+  float t = duration<float>(view_time - a.time) /
+            duration<float>(b.time - a.time);
+  for (size_t j = 0; j < a.x.size(); j++) {
+    // Wrapped around the screen edge in between, the closer frame it is
+    if (std::fabs(b.x[j] - a.x[j]) > Constants::screenWidth / 2.0f ||
+        std::fabs(b.y[j] - a.y[j]) > Constants::screenHeight / 2.0f) {
+      x[j] = t < 0.5f ? a.x[j] : b.x[j];
+      y[j] = t < 0.5f ? a.y[j] : b.y[j];
+      continue;
+    }
+    x[j] = a.x[j] + (b.x[j] - a.x[j]) * t;
+    y[j] = a.y[j] + (b.y[j] - a.y[j]) * t;
+  }
+  return true;
+}
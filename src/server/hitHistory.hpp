@@ -0,0 +1,34 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+#include "constants.hpp"
+#include "player.hpp"
+
+using namespace std::chrono;
+
+// Positions of a room's players over the last LAG_COMPENSATION_MAX, one
+// frame per tick in a ring allocated for the tick rate. Recording a tick
+// copies PLAYERS_MAX positions, a rewind walks at most every frame.
+struct HitHistory {
+  struct Frame {
+    steady_clock::time_point time;
+    std::array<float, Constants::PLAYERS_MAX> x{}, y{};
+  };
+  std::vector<Frame> frames;
+  size_t head = 0; // Oldest
+  size_t count = 0;
+
+  HitHistory(unsigned int tick_rate = 60);
+
+  const Frame &at(size_t i) const { return frames[(head + i) % frames.size()]; }
+  void record(steady_clock::time_point time,
+              const std::vector<Player> &players);
+  // Positions at view_time, between the frames around it, or of the oldest
+  // frame when it is older. false without any frame.
+  bool rewind(steady_clock::time_point view_time, float *x, float *y) const;
+  void clear() { count = 0; }
+  size_t heap_bytes() const { return frames.capacity() * sizeof(Frame); }
+};
@@ -0,0 +1,41 @@
+#include "inputQueue.hpp"
+#include "constants.hpp"
+#include "datagram.hpp"
+
+void InputQueue::receive(const std::vector<InputState> &incoming,
+                         uint32_t slack) {
+  for (const auto &state : incoming) {
+    // Datagrams repeat the latest changes
+    if (started && !sequence_newer(state.tick, received))
+      continue;
+    if (!started) {
+      started = true;
+      tick = state.tick - 1;
+    }
+    received = state.tick;
+    if (states.size() == Constants::INPUT_QUEUE_MAX)
+      states.pop_front();
+    states.push_back(state);
+  }
+  // A burst of lag, the queued changes are applied together by the next
+  // step. The tick is acknowledged to the client and never goes back, the
+  // changes of a client that fell behind are applied as they arrive.
+  if (started && sequence_newer(received, tick + slack))
+    tick = received - 1;
+}
+
+uint32_t InputQueue::step() {
+  if (started) {
+    tick++;
+    while (!states.empty() && !sequence_newer(states.front().tick, tick)) {
+      buttons = states.front().buttons;
+      fire |= (buttons & InputFire) != 0;
+      states.pop_front();
+    }
+  }
+  uint32_t held = buttons & ~InputFire;
+  if (fire)
+    held |= InputFire;
+  fire = false;
+  return held;
+}
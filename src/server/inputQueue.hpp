@@ -0,0 +1,25 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "player.hpp"
+
+// Input of one player, filled by its client's worker and consumed by the
+// room tick, so the player only moves within ticks. The server simulates
+// the client's input ticks one per room tick, a little behind the newest
+// state received, and holds the buttons between changes.
+struct InputQueue {
+  bool started = false; // Nothing is held before the first state
+  uint32_t tick = 0;     // Last client tick simulated, acknowledged
+  uint32_t received = 0; // Newest state received
+  uint32_t buttons = InputNone;
+  bool fire = false; // A shot waiting for the next tick
+  std::deque<InputState> states; // Changes for ticks not simulated yet
+
+  // Ticks the client may run ahead of the simulation before the
+  // simulation skips to its newest state
+  void receive(const std::vector<InputState> &incoming, uint32_t slack);
+  // Buttons of the next tick, fire included when a shot was queued
+  uint32_t step();
+};
@@ -0,0 +1,203 @@
+#include "ioUring.hpp"
+#include <algorithm>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace std::chrono;
+
+IoUring::~IoUring() {
+  if (buffers)
+    munmap(buffers, (size_t)BUFFERS * BUFFER_SIZE);
+  if (buf_ring)
+    munmap(buf_ring, buf_ring_len);
+  if (sqes)
+    munmap(sqes, sqes_len);
+  if (cq_ptr && cq_ptr != sq_ptr)
+    munmap(cq_ptr, cq_len);
+  if (sq_ptr)
+    munmap(sq_ptr, sq_len);
+  if (ring_fd != -1)
+    close(ring_fd);
+}
+
+bool IoUring::init() {
+  io_uring_params p{};
+  ring_fd = syscall(__NR_io_uring_setup, ENTRIES, &p);
+  if (ring_fd < 0) {
+    ring_fd = -1;
+    return false;
+  }
+  // Timeouts on io_uring_enter and no dropped completions
+  if (!(p.features & IORING_FEAT_EXT_ARG) || !(p.features & IORING_FEAT_NODROP))
+    return false;
+
+  sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+  cq_len = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+  bool single_mmap = p.features & IORING_FEAT_SINGLE_MMAP;
+  if (single_mmap)
+    sq_len = cq_len = std::max(sq_len, cq_len);
+
+  sq_ptr = mmap(nullptr, sq_len, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+  if (sq_ptr == MAP_FAILED) {
+    sq_ptr = nullptr;
+    return false;
+  }
+  if (single_mmap) {
+    cq_ptr = sq_ptr;
+  } else {
+    cq_ptr = mmap(nullptr, cq_len, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+    if (cq_ptr == MAP_FAILED) {
+      cq_ptr = nullptr;
+      return false;
+    }
+  }
+  sqes_len = p.sq_entries * sizeof(io_uring_sqe);
+  void *s = mmap(nullptr, sqes_len, PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+  if (s == MAP_FAILED)
+    return false;
+  sqes = (io_uring_sqe *)s;
+
+  char *sq = (char *)sq_ptr, *cq = (char *)cq_ptr;
+  sq_head = (unsigned *)(sq + p.sq_off.head);
+  sq_tail = (unsigned *)(sq + p.sq_off.tail);
+  sq_mask = (unsigned *)(sq + p.sq_off.ring_mask);
+  sq_array = (unsigned *)(sq + p.sq_off.array);
+  cq_head = (unsigned *)(cq + p.cq_off.head);
+  cq_tail = (unsigned *)(cq + p.cq_off.tail);
+  cq_mask = (unsigned *)(cq + p.cq_off.ring_mask);
+  cqes = (io_uring_cqe *)(cq + p.cq_off.cqes);
+
+  // Submission slots are used in order
+  for (unsigned i = 0; i < p.sq_entries; i++)
+    sq_array[i] = i;
+  sqe_tail = *sq_tail;
+
+  return setup_buffers();
+}
+
+bool IoUring::setup_buffers() {
+  buf_ring_len = BUFFERS * sizeof(io_uring_buf);
+  void *r = mmap(nullptr, buf_ring_len, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (r == MAP_FAILED)
+    return false;
+  buf_ring = (io_uring_buf_ring *)r;
+
+  void *b = mmap(nullptr, (size_t)BUFFERS * BUFFER_SIZE, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (b == MAP_FAILED)
+    return false;
+  buffers = (uint8_t *)b;
+
+  io_uring_buf_reg reg{};
+  reg.ring_addr = (uint64_t)buf_ring;
+  reg.ring_entries = BUFFERS;
+  reg.bgid = BUFFER_GROUP;
+  if (syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_PBUF_RING, &reg,
+              1) < 0)
+    return false;
+
+  for (uint16_t id = 0; id < BUFFERS; id++)
+    recycle_buffer(id);
+  return true;
+}
+
+void IoUring::recycle_buffer(uint16_t id) {
+  // Not buf_ring->bufs, the header's flexible array lands at offset 8 in C++
+  io_uring_buf *buf = (io_uring_buf *)buf_ring + (buf_tail & (BUFFERS - 1));
+  buf->addr = (uint64_t)buffer(id);
+  buf->len = BUFFER_SIZE;
+  buf->bid = id;
+  buf_tail++;
+  __atomic_store_n(&buf_ring->tail, buf_tail, __ATOMIC_RELEASE);
+}
+
+int IoUring::enter(unsigned min_complete, unsigned flags, void *arg,
+                   size_t argsz) {
+  // Entries the kernel hasn't consumed yet are submitted again
+  __atomic_store_n(sq_tail, sqe_tail, __ATOMIC_RELEASE);
+  unsigned to_submit = sqe_tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE);
+  enters++;
+  return syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags,
+                 arg, argsz);
+}
+
+io_uring_sqe *IoUring::get_sqe() {
+  if (sqe_tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE) > *sq_mask)
+    enter(0, 0, nullptr, 0); // Full, make room
+  io_uring_sqe *sqe = &sqes[sqe_tail & *sq_mask];
+  sqe_tail++;
+  memset(sqe, 0, sizeof(*sqe));
+  return sqe;
+}
+
+void IoUring::submit_and_wait(milliseconds timeout) {
+  __kernel_timespec ts{};
+  ts.tv_sec = timeout.count() / 1000;
+  ts.tv_nsec = (timeout.count() % 1000) * 1000000;
+  io_uring_getevents_arg arg{};
+  arg.ts = (uint64_t)&ts;
+  // -ETIME and -EINTR only mean there is nothing to reap yet
+  enter(1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+}
+
+void IoUring::prep_poll(int fd, uint32_t events, uint64_t user_data) {
+  io_uring_sqe *sqe = get_sqe();
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = fd;
+  sqe->poll32_events = events;
+  sqe->user_data = user_data;
+}
+
+void IoUring::prep_poll_remove(uint64_t target) {
+  io_uring_sqe *sqe = get_sqe();
+  sqe->opcode = IORING_OP_POLL_REMOVE;
+  sqe->fd = -1;
+  sqe->addr = target;
+}
+
+void IoUring::prep_recv_multishot(int fd, uint64_t user_data) {
+  io_uring_sqe *sqe = get_sqe();
+  sqe->opcode = IORING_OP_RECV;
+  sqe->fd = fd;
+  sqe->ioprio = IORING_RECV_MULTISHOT;
+  sqe->flags = IOSQE_BUFFER_SELECT;
+  sqe->buf_group = BUFFER_GROUP;
+  sqe->user_data = user_data;
+}
+
+void IoUring::prep_sendmsg(int fd, const msghdr *msg, uint64_t user_data) {
+  io_uring_sqe *sqe = get_sqe();
+  sqe->opcode = IORING_OP_SENDMSG;
+  sqe->fd = fd;
+  sqe->addr = (uint64_t)msg;
+  sqe->len = 1;
+  sqe->msg_flags = MSG_NOSIGNAL;
+  sqe->user_data = user_data;
+}
+
+bool IoUring::supported() {
+  IoUring ring;
+  if (!ring.init())
+    return false;
+
+  int sv[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv))
+    return false;
+  ring.prep_recv_multishot(sv[0], 1);
+  bool ok = write(sv[1], "x", 1) == 1;
+  ring.submit_and_wait(milliseconds(100));
+  unsigned seen = ring.for_each_cqe([&](const io_uring_cqe &cqe) {
+    ok = ok && cqe.res == 1 && (cqe.flags & IORING_CQE_F_BUFFER) &&
+         (cqe.flags & IORING_CQE_F_MORE);
+  });
+  close(sv[0]);
+  close(sv[1]);
+  return ok && seen == 1;
+}
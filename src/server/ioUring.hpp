@@ -0,0 +1,72 @@
+#pragma once
+#include <linux/io_uring.h>
+#include <sys/socket.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Minimal io_uring over the raw syscalls (no liburing). Owns one submission
+// and completion ring plus a provided buffer ring used by multishot receives.
+struct IoUring {
+  static const unsigned ENTRIES = 4096;
+  static const unsigned BUFFERS = 128;
+  static const unsigned BUFFER_SIZE = 16 * 1024;
+  static const uint16_t BUFFER_GROUP = 0;
+
+  int ring_fd = -1;
+  uint64_t enters = 0; // io_uring_enter syscalls
+
+  IoUring() = default;
+  ~IoUring();
+  IoUring(const IoUring &) = delete;
+  IoUring &operator=(const IoUring &) = delete;
+
+  // returns false if the kernel lacks io_uring or one of the used features
+  bool init();
+  // Runs a multishot receive on a socketpair, returns true if it worked
+  static bool supported();
+
+  // Never null, submits queued entries when the ring is full
+  io_uring_sqe *get_sqe();
+  // Submits everything queued and waits for at least one completion or
+  // the timeout
+  void submit_and_wait(std::chrono::milliseconds timeout);
+
+  template <typename F> unsigned for_each_cqe(F f) {
+    unsigned head = *cq_head;
+    unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+    unsigned seen = 0;
+    for (; head != tail; head++, seen++) {
+      f(cqes[head & *cq_mask]);
+    }
+    __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+    return seen;
+  }
+
+  uint8_t *buffer(uint16_t id) { return buffers + (size_t)id * BUFFER_SIZE; }
+  // Hands a provided buffer back to the kernel
+  void recycle_buffer(uint16_t id);
+
+  void prep_poll(int fd, uint32_t events, uint64_t user_data);
+  void prep_poll_remove(uint64_t target);
+  void prep_recv_multishot(int fd, uint64_t user_data);
+  void prep_sendmsg(int fd, const msghdr *msg, uint64_t user_data);
+
+private:
+  unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+  unsigned *cq_head, *cq_tail, *cq_mask;
+  io_uring_sqe *sqes = nullptr;
+  io_uring_cqe *cqes = nullptr;
+  void *sq_ptr = nullptr, *cq_ptr = nullptr;
+  size_t sq_len = 0, cq_len = 0, sqes_len = 0;
+  unsigned sqe_tail = 0; // Prepared entries, published on enter
+
+  io_uring_buf_ring *buf_ring = nullptr;
+  size_t buf_ring_len = 0;
+  uint8_t *buffers = nullptr;
+  uint16_t buf_tail = 0;
+
+  int enter(unsigned min_complete, unsigned flags, void *arg, size_t argsz);
+  bool setup_buffers();
+};
@@ -3,6 +3,8 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <sstream>
+#include <string>
 #include <error.h>
 #include <netdb.h>
 #include <netinet/in.h>
@@ -12,16 +14,118 @@
 
 #include "networkUtils.hpp"
 #include "server.hpp"
+#include "serverConfig.hpp"
 
 void my_exit(int) { exit(0); }
 
-int main(int argc, char **argv) {
-  if (argc != 2)
+ServerConfig read_server_config(int argc, char **argv) {
+  ServerConfig config;
+  int opt;
+  while ((opt = getopt(argc, argv, "w:a:b:t:r:m:T:DNCuUl:o:s:SJQ")) != -1) {
+    switch (opt) {
+    case 'w':
+      config.workers = readPositive(optarg);
+      break;
+    case 'a':
+      config.acceptors = readPositive(optarg);
+      break;
+    case 'b':
+      config.backlog = readPositive(optarg);
+      break;
+    case 't':
+      config.tick_rate = readPositive(optarg);
+      break;
+    case 'r':
+      config.room_threads = readPositive(optarg);
+      break;
+    case 'm':
+      config.max_rooms = readPositive(optarg);
+      break;
+    case 'T': {
+      config.room_types.clear();
+      std::stringstream types(optarg);
+      std::string name;
+      while (std::getline(types, name, ',')) {
+        RoomType type;
+        if (!parse_room_type(name, type))
+          error(1, 0, "unknown room type %s", name.c_str());
+        config.room_types.push_back(type);
+      }
+      if (config.room_types.empty())
+        error(1, 0, "illegal argument %s", optarg);
+    } break;
+    case 'D':
+      config.deterministic = true;
+      break;
+    case 'N':
+      config.tcp_nodelay = false;
+      break;
+    case 'C':
+      config.tcp_cork = true;
+      break;
+    case 'u':
+      config.io_backend = IoBackend::IoUring;
+      break;
+    case 'U':
+      config.udp = false;
+      break;
+    case 'l':
+      config.udp_loss = readPercent(optarg);
+      break;
+    case 'o':
+      config.udp_reorder = readPercent(optarg);
+      break;
+    case 's':
+      config.snapshot_rate = readPositive(optarg);
+      break;
+    case 'S':
+      config.snapshot_rate = 0;
+      break;
+    case 'J':
+      config.binary = false;
+      break;
+    case 'Q':
+      config.quantize = false;
+      break;
+    default:
+      error(1, 0, "Usage: %s [-w WORKERS] [-a ACCEPTORS] [-b BACKLOG] [-t TICK_RATE] [-r ROOM_THREADS] [-m MAX_ROOMS] [-T ROOM_TYPES] [-D] [-N] [-C] [-u] [-U] [-l LOSS] [-o REORDER] [-s SNAPSHOT_RATE] [-S] [-J] [-Q] PORT", argv[0]);
+    }
+  }
+  if (optind != argc - 1)
     error(1, 0, "Need 1 arg (port)");
-  auto main_port = readPort(argv[1]);
+  config.port = readPort(argv[optind]);
+  return config;
+}
+
+int main(int argc, char **argv) {
+  auto config = read_server_config(argc, argv);
+  config.min_rooms = std::min(config.min_rooms, config.max_rooms);
+  if (config.acceptors == 0 || config.acceptors > config.workers)
+    config.acceptors = config.workers;
 
   signal(SIGINT, my_exit);
   signal(SIGPIPE, SIG_IGN);
-  auto server = Server(main_port);
-  TraceLog(LOG_INFO, "Server is running on localhost:%s", argv[1]);
+  auto server = Server(config);
+  TraceLog(LOG_INFO,
+           "Server is running on localhost:%u with %u %s workers (%u "
+           "accepting, backlog %d), %u room threads at %u ticks/s (%s "
+           "physics)",
+           config.port, config.workers,
+           server.config.io_backend == IoBackend::IoUring ? "io_uring"
+                                                          : "epoll",
+           config.acceptors, config.backlog, config.room_threads,
+           config.tick_rate, IntegrationKernels());
+  if (config.deterministic)
+    TraceLog(LOG_INFO, "Deterministic rounds: fixed-point steps of 1/%u s",
+             config.tick_rate);
+  if (server.udp_fd != -1 && (config.udp_loss > 0 || config.udp_reorder > 0))
+    TraceLog(LOG_INFO, "UDP shim drops %.0f%% and reorders %.0f%% of datagrams",
+             config.udp_loss, config.udp_reorder);
+  if (config.binary && config.quantize)
+    TraceLog(LOG_INFO,
+             "Quantized payloads: positions within %.3f px, velocities "
+             "within %.3f px/s, angles within %.3f deg",
+             std::max(codec::POSITION.x.max_error(),
+                      codec::POSITION.y.max_error()),
+             codec::VELOCITY.x.max_error(), codec::ANGLE.max_error());
 }
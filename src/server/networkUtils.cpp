@@ -13,9 +13,32 @@ uint16_t readPort(char *txt) {
   return port;
 }
 
+uint32_t readPositive(char *txt) {
+  char *ptr;
+  auto value = strtol(txt, &ptr, 10);
+  if (*ptr != 0 || value < 1 || value > UINT32_MAX)
+    error(1, 0, "illegal argument %s", txt);
+  return value;
+}
+
+uint32_t readPercent(char *txt) {
+  char *ptr;
+  auto value = strtol(txt, &ptr, 10);
+  if (*ptr != 0 || *txt == 0 || value < 0 || value > 100)
+    error(1, 0, "illegal argument %s", txt);
+  return value;
+}
+
 void setReuseAddr(int sock) {
   const int one = 1;
   int res = setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
   if (res)
     error(1, errno, "setsockopt failed");
 }
+
+void setReusePort(int sock) {
+  const int one = 1;
+  int res = setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+  if (res)
+    error(1, errno, "setsockopt failed");
+}
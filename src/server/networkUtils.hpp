@@ -3,4 +3,11 @@
 
 uint16_t readPort(char *txt);
 
+uint32_t readPositive(char *txt);
+
+// 0 to 100
+uint32_t readPercent(char *txt);
+
 void setReuseAddr(int sock);
+
+void setReusePort(int sock);
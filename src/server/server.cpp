@@ -1,16 +1,21 @@
 #include "server.hpp"
+#include <algorithm>
+#include <array>
 #include <chrono>
+#include <cmath>
 #include <errno.h>
 #include <error.h>
 #include <fcntl.h>
 
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <sys/epoll.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <unistd.h>
 
 #include <cstdint>
+#include <cstring>
 #include <ctime>
 #include <map>
 #include <mutex>
@@ -25,227 +30,665 @@
 #include "gameManager.hpp"
 #include "gameStatus.hpp"
 #include "jsonutils.hpp"
-#include "lockingQueue.hpp"
+#include "mpscQueue.hpp"
 #include "networkUtils.hpp"
 #include "player.hpp"
 #include "room.hpp"
+#include "tickScheduler.hpp"
 #include "vec2json.hpp"
 
-Server::Server(in_port_t main_port) {
-  this->mainfd = socket(AF_INET, SOCK_STREAM, 0);
-  if (this->mainfd == -1)
+Server::Server(const ServerConfig &config)
+    : config(config), room_executor(config.room_threads) {
+  _next_seed = std::random_device{}();
+  {
+    std::lock_guard<std::mutex> gml(games_mutex);
+    for (uint32_t i = 0; i < config.min_rooms; i++) {
+      create_room();
+    }
+    // Spare rooms, allocated up front under the temporary key 0
+    for (uint32_t i = 0; i < config.prewarmed_rooms; i++) {
+      games[0];
+      room_pool.push_back(games.extract(0));
+    }
+    if (!room_pool.empty())
+      TraceLog(LOG_INFO, "Room memory cost: ~%lu bytes per room",
+               room_memory_usage(room_pool.back().mapped()));
+  }
+  room_executor.submit([this]() { manage_rooms(); });
+
+  if (this->config.io_backend == IoBackend::IoUring && !IoUring::supported()) {
+    TraceLog(LOG_WARNING, "io_uring with multishot receives is not supported "
+                          "by the kernel, falling back to epoll");
+    this->config.io_backend = IoBackend::Epoll;
+  }
+  if (config.udp)
+    udp_fd = open_udp_socket();
+
+  for (uint32_t i = 0; i < config.workers; i++) {
+    Worker &worker = this->workers[i];
+    worker.worker_id = i;
+    worker.shim_rng.seed(std::random_device{}());
+
+    // The first workers accept connections on their own listening socket,
+    // the kernel balances new connections between them
+    if (i < config.acceptors)
+      worker.listen_fd = open_listener();
+
+    if (this->config.io_backend == IoBackend::IoUring) {
+      worker.ring = std::make_unique<IoUring>();
+      if (!worker.ring->init())
+        error(1, errno, "worker io_uring setup failed");
+      continue; // Polls are armed by the worker itself
+    }
+
+    worker.epoll_fd = epoll_create1(0);
+    if (worker.epoll_fd == -1)
+      error(1, errno, "worker epoll_create failed");
+
+    epoll_event ee{};
+    ee.events = EPOLLIN;
+    ee.data.fd = worker.new_connections.get_event_fd();
+    int res = epoll_ctl(worker.epoll_fd, EPOLL_CTL_ADD, ee.data.fd, &ee);
+    if (res)
+      error(1, errno, "worker epoll_ctl failed");
+
+    if (worker.listen_fd != -1) {
+      ee.data.fd = worker.listen_fd;
+      res = epoll_ctl(worker.epoll_fd, EPOLL_CTL_ADD, ee.data.fd, &ee);
+      if (res)
+        error(1, errno, "listener epoll_ctl failed");
+    }
+
+    if (i == 0 && udp_fd != -1) {
+      ee.data.fd = udp_fd;
+      res = epoll_ctl(worker.epoll_fd, EPOLL_CTL_ADD, ee.data.fd, &ee);
+      if (res)
+        error(1, errno, "UDP socket epoll_ctl failed");
+    }
+  }
+
+  for (auto &[worker_id, worker] : workers) {
+    if (worker.ring)
+      worker.thread =
+          std::thread(&Server::run_uring_worker, this, std::ref(worker));
+    else
+      worker.thread = std::thread(&Server::run_worker, this, std::ref(worker));
+  }
+}
+
+int Server::open_listener() {
+  int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd == -1)
     error(1, errno, "main socket failed");
 
-  setReuseAddr(this->mainfd);
+  setReuseAddr(fd);
+  setReusePort(fd);
 
   sockaddr_in serverAddr{};
   serverAddr.sin_family = AF_INET;
-  serverAddr.sin_port = htons((short)main_port);
+  serverAddr.sin_port = htons((short)config.port);
   serverAddr.sin_addr = {INADDR_ANY};
 
-  int res = bind(this->mainfd, (sockaddr *)&serverAddr, sizeof(serverAddr));
+  int res = bind(fd, (sockaddr *)&serverAddr, sizeof(serverAddr));
   if (res)
     error(1, errno, "main bind failed");
 
-  res = listen(this->mainfd, 1);
+  res = listen(fd, config.backlog);
   if (res)
     error(1, errno, "main listen failed");
+  return fd;
+}
 
-  {
-    std::lock_guard<std::mutex> gml(games_mutex);
-    for (int i = 0; i < 4; i++) {
-      uint32_t game_id = _next_game_id++;
+Server::~Server() {
+  // join worker threads
+  for (auto &[worker_id, worker] : workers) {
+    if (worker.thread.joinable())
+      worker.thread.join();
+    if (worker.epoll_fd != -1)
+      close(worker.epoll_fd);
+
+    // close network resources
+    if (worker.listen_fd != -1 && close(worker.listen_fd))
+      error(1, errno, "close listening fd failed");
+  }
+  if (udp_fd != -1)
+    close(udp_fd);
+}
 
-      this->games[game_id];
-      {
-        GameRoom &gr = this->games.at(game_id);
-        std::lock_guard<std::mutex> grl(gr.gameRoomMutex);
-        gr.room =
-            Room{game_id, std::vector<PlayerIdState>(Constants::PLAYERS_MAX),
-                 GameStatus::LOBBY, Constants::COOL_ROOM_NAMES[i]};
-        for (uint32_t j = 0; j < Constants::PLAYERS_MAX; j++) {
-          gr.room.players.at(j).player_id = j;
-        }
-        gr.gameManager = GameManager(game_id, gr.room.players);
-      }
+void Server::accept_connections(Worker &worker) {
+  // Listener is level triggered, whatever is left after a batch is accepted
+  // in the next epoll cycle
+  for (int n = 0; n < Constants::ACCEPT_BATCH; n++) {
+    int client_fd = accept4(worker.listen_fd, nullptr, nullptr,
+                            SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (client_fd == -1) {
+      if (errno == EINTR || errno == ECONNABORTED)
+        continue;
+      if (errno != EAGAIN && errno != EWOULDBLOCK)
+        TraceLog(LOG_WARNING, "Worker %lu couldn't accept connection: %s",
+                 worker.worker_id, strerror(errno));
+      return;
     }
+    worker.stats.accepted++;
+
+    if (config.acceptors >= config.workers) {
+      add_connection(worker, client_fd);
+      continue;
+    }
+    // Spread connections over workers without a listener of their own
+    uint32_t worker_id = _next_worker_id++ % config.workers;
+    if (worker_id == worker.worker_id)
+      add_connection(worker, client_fd);
+    else
+      workers.at(worker_id).new_connections.push(client_fd);
   }
+}
 
-  this->connection_thread = std::thread(&Server::listen_for_connections, this);
+bool Server::sendCheckConnection(Client &client) {
+  client.good_connection = false;
+  // Send ping
+  return serverSetEvent(client, NetworkEvents::CheckConnection);
 }
 
-Server::~Server() {
-  // join worker threads
-  if (this->connection_thread.joinable())
-    this->connection_thread.join();
+void Server::run_worker(Worker &worker) {
+  const int MAX_EVENTS = 64;
+  epoll_event events[MAX_EVENTS];
+  worker.last_connection_check = steady_clock::now();
 
-  // close network resources
-  int res = shutdown(mainfd, SHUT_RDWR);
-  if (res)
-    error(1, errno, "shutdown main fd failed");
-  res = close(mainfd);
-  if (res)
-    error(1, errno, "close main fd failed");
+  while (!this->_stop) {
+    int nfds = epoll_wait(worker.epoll_fd, events, MAX_EVENTS,
+                          Constants::CONNECTION_CHECK_INTERVAL_MILISECONDS);
+    worker.stats.syscalls++;
+    if (nfds == -1) {
+      if (errno == EINTR)
+        continue;
+      // EPOLL WAIT ERROR
+      TraceLog(LOG_ERROR, "Epoll wait error for worker_id=%lu",
+               worker.worker_id);
+      return;
+    }
+    for (int n = 0; n < nfds; n++) {
+      handle_worker_event(worker, events[n]);
+    }
+    check_connections(worker);
+    flush_clients(worker);
+  }
 }
 
-void Server::listen_for_connections() {
-  while (!this->_stop) {
-    sockaddr_in clientAddrMain{};
-    socklen_t socklen = sizeof(clientAddrMain);
+// Sends everything handlers queued during this epoll cycle, one sendmsg per
+// client
+void Server::flush_clients(Worker &worker) {
+  for (auto client_id : worker.pending_flush) {
+    Client *client_ptr = nullptr;
+    try {
+      std::lock_guard<std::mutex> lg(clients_mutex);
+      client_ptr = &clients.at(client_id);
+    } catch (const std::out_of_range &ex) {
+      continue;
+    }
+    Client &client = *client_ptr;
+    client.flush_pending = false;
+    if (client.fd_main == -1)
+      continue;
 
-    int client_main_fd = accept(mainfd, (sockaddr *)&clientAddrMain, &socklen);
-    if (client_main_fd == -1) {
+    bool status = worker.ring ? submit_send(worker, client)
+                              : flush_client(worker, client);
+    worker.stats.max_queued = std::max(worker.stats.max_queued,
+                                       (uint64_t)client.out.queued);
+    worker.stats.dropped_updates += client.dropped_updates;
+    client.dropped_updates = 0;
+    if (!status) {
+      TraceLog(LOG_WARNING, "Couldn't flush output to client_id=%ld,fd=%d",
+               client.client_id, client.fd_main);
+      disconnect_client(client);
+      release_client(worker, client);
       continue;
     }
 
-    std::thread(&Server::handle_connection, this, client_main_fd).detach();
+    if (!within_output_budget(client, steady_clock::now())) {
+      worker.stats.slow_disconnects++;
+      disconnect_client(client);
+      release_client(worker, client);
+    }
   }
+  worker.pending_flush.clear();
+  flush_datagrams(worker);
 }
 
-bool Server::sendCheckConnection(Client &client) {
-  client.good_connection = false;
-  // Set socket timeouts
-  struct timeval tv;
-  size_t tvs = sizeof(tv);
-  tv.tv_sec = Constants::CONNECTION_TIMEOUT_MILISECONDS / 1000;
-  tv.tv_usec = (Constants::CONNECTION_TIMEOUT_MILISECONDS % 1000) * 1000;
-  setsockopt(client.fd_main, SOL_SOCKET, SO_RCVTIMEO, (const char *)&tv, tvs);
-  setsockopt(client.fd_main, SOL_SOCKET, SO_SNDTIMEO, (const char *)&tv, tvs);
+bool Server::flush_client(Worker &worker, Client &client) {
+  auto syscalls = client.out.syscalls;
+  auto bytes_sent = client.out.bytes_sent;
+  take_superseded(client);
+  bool status = client.out.flush(client.fd_main, config.tcp_cork);
+  if (status && take_superseded(client)) {
+    status = client.out.flush(client.fd_main, config.tcp_cork);
+  }
+  worker.stats.flushes++;
+  worker.stats.syscalls += client.out.syscalls - syscalls;
+  worker.stats.bytes += client.out.bytes_sent - bytes_sent;
+  if (!status)
+    return false;
+  if (client.out.empty())
+    output_drained(worker, client);
+
+  // Socket buffer is full, finish the flush once it becomes writable
+  bool waiting_for_write = !client.out.empty();
+  if (waiting_for_write && !client.waiting_for_write)
+    client.write_blocked_since = steady_clock::now();
+  if (waiting_for_write != client.waiting_for_write) {
+    epoll_event ee{};
+    ee.events = EPOLLIN | EPOLLRDHUP | EPOLLERR;
+    if (waiting_for_write)
+      ee.events |= EPOLLOUT;
+    ee.data.fd = client.fd_main;
+    epoll_ctl(worker.epoll_fd, EPOLL_CTL_MOD, client.fd_main, &ee);
+    client.waiting_for_write = waiting_for_write;
+  }
+  return true;
+}
 
-  // Send ping
-  return serverSetEvent(client, NetworkEvents::CheckConnection);
+// Socket caught up, queues the updates held back meanwhile
+bool Server::take_superseded(Client &client) {
+  if (!client.out.empty() || client.superseding.empty())
+    return false;
+  for (auto &[key, bytes] : client.superseding)
+    client.out.append(bytes);
+  client.superseding.clear();
+  return true;
 }
 
-void Server::handle_connection(int client_fd) {
+// Everything queued reached the kernel, samples the broadcast latency
+void Server::output_drained(Worker &worker, Client &client) {
+  if (client.broadcast_queued == steady_clock::time_point{})
+    return;
+  auto latency = steady_clock::now() - client.broadcast_queued;
+  worker.stats.broadcast_latency.push_back(
+      duration_cast<microseconds>(latency).count());
+  client.broadcast_queued = {};
+}
 
-  // Each new client is expected to send "GetClientId" event on connection with
-  // value 0 Server then responds with client id
-  uint32_t client_id = handleGetClientId(client_fd);
-  if (client_id == 0) {
+uint32_t NetworkStats::latency_percentile(double q) {
+  if (broadcast_latency.empty())
+    return 0;
+  auto nth = broadcast_latency.begin() + (size_t)(q * (broadcast_latency.size() - 1));
+  std::nth_element(broadcast_latency.begin(), nth, broadcast_latency.end());
+  return *nth;
+}
+
+void Server::schedule_flush(Worker &worker, Client &client) {
+  if (!client.flush_pending &&
+      (!client.out.empty() || !client.superseding.empty())) {
+    client.flush_pending = true;
+    worker.pending_flush.push_back(client.client_id);
+  }
+}
+
+// Queues an update that a newer one with the same event and id replaces
+// entirely. While the client's socket is full only the latest one is kept.
+void Server::send_latest(Client &client, uint32_t event, uint32_t id,
+                         SharedBytes bytes) {
+  if (!client.waiting_for_write) {
+    client.out.append(std::move(bytes));
+    return;
+  }
+  auto [i, inserted] =
+      client.superseding.insert_or_assign({event, id}, std::move(bytes));
+  if (!inserted)
+    client.dropped_updates++;
+}
+
+// Clients that can't keep up with their output are disconnected instead of
+// buffering without limit
+bool Server::within_output_budget(Client &client,
+                                  steady_clock::time_point now) {
+  if (client.out.queued > config.max_output_bytes) {
+    TraceLog(LOG_WARNING,
+             "Output of client_id=%ld,fd=%d exceeded %lu bytes, disconnecting",
+             client.client_id, client.fd_main, config.max_output_bytes);
+    return false;
+  }
+  if (client.waiting_for_write &&
+      now - client.write_blocked_since > config.max_output_delay) {
+    TraceLog(LOG_WARNING,
+             "Output of client_id=%ld,fd=%d blocked for over %ld ms, "
+             "disconnecting",
+             client.client_id, client.fd_main,
+             duration_cast<milliseconds>(config.max_output_delay).count());
+    return false;
+  }
+  return true;
+}
+
+void Server::add_connection(Worker &worker, int client_fd) {
+  // Accepted non-blocking, workers never block on a client socket
+  if (config.tcp_nodelay) {
+    // Output is already coalesced, don't delay the flushes
+    const int one = 1;
+    setsockopt(client_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  }
+
+  if (worker.ring) {
+    watch_handshake(worker, client_fd);
+  } else {
+    epoll_event ee{};
+    ee.events = EPOLLIN | EPOLLRDHUP | EPOLLERR;
+    ee.data.fd = client_fd;
+    if (epoll_ctl(worker.epoll_fd, EPOLL_CTL_ADD, client_fd, &ee) == -1) {
+      TraceLog(LOG_ERROR, "Couldn't instantiate EPOLLIN for fd=%d", client_fd);
+      shutdown(client_fd, SHUT_RDWR);
+      close(client_fd);
+      return;
+    }
+  }
+  // Client id is assigned after handshake
+  worker.clients_by_fd[client_fd] = 0;
+}
+
+void Server::handle_worker_event(Worker &worker, const epoll_event &event) {
+  int fd = event.data.fd;
+  if (fd == worker.listen_fd) {
+    accept_connections(worker);
+    return;
+  }
+  if (fd == worker.new_connections.get_event_fd()) {
+    worker.new_connections.drain([&](int client_fd) {
+      add_connection(worker, client_fd);
+      return true;
+    });
+    return;
+  }
+  if (fd == udp_fd) {
+    receive_datagrams(worker);
+    return;
+  }
+
+  auto i = worker.clients_by_fd.find(fd);
+  if (i == worker.clients_by_fd.end()) {
+    return;
+  }
+
+  if (i->second == 0) {
+    handle_handshake(worker, fd, event.events);
     return;
   }
 
   Client *client_ptr = nullptr;
   try {
     std::lock_guard<std::mutex> lg(clients_mutex);
-    client_ptr = &clients.at(client_id);
+    client_ptr = &clients.at(i->second);
   } catch (const std::out_of_range &ex) {
+    worker.clients_by_fd.erase(i);
     return;
   }
   Client &client = *client_ptr; // Get a clean reference to client
+  client.last_activity = steady_clock::now();
 
-  epoll_event ee, events[2]; // Client socket and todo queue
-  int epoll_fd = epoll_create1(0);
-  if (epoll_fd == -1) {
-    TraceLog(LOG_ERROR, "Couldn't epoll_create for fd=%d", client_fd);
-    shutdown(client_fd, SHUT_RDWR);
-    close(client_fd);
+  if (fd == client.fd_main && (event.events & EPOLLIN)) {
+    if (!client.good_connection) {
+      client.good_connection = true;
+    }
+    // Frames received before EOF are still handled. A hang up comes with
+    // EPOLLIN while bytes are left, the connection closes once fill()
+    // reaches the end of them.
+    auto recvs = client.in.syscalls;
+    bool open = client.in.fill(client.fd_main);
+    worker.stats.syscalls += client.in.syscalls - recvs;
+    process_frames(client);
+    if (!open && client.fd_main != -1) {
+      disconnect_client(client);
+    }
+  } else if (event.events & (EPOLLRDHUP | EPOLLERR | EPOLLHUP)) {
+    disconnect_client(client);
+  } else if (fd == client.todo_fd) {
+    // Run everything queued since the last wakeup
+    todos.at(client.client_id).drain([&](auto &f) {
+      f(client);
+      return client.fd_main != -1;
+    });
+  }
+
+  if (client.fd_main == -1) {
+    release_client(worker, client);
+  } else {
+    schedule_flush(worker, client);
+  }
+}
+
+// Each new client is expected to send "GetClientId" event on connection with
+// its capabilities (0 for none), server then responds with the client id and
+// the accepted capabilities
+void Server::handle_handshake(Worker &worker, int fd, uint32_t events) {
+  auto &in = worker.pending_input[fd];
+  auto recvs = in.syscalls;
+  bool open = !(events & (EPOLLRDHUP | EPOLLERR | EPOLLHUP)) && in.fill(fd);
+  worker.stats.syscalls += in.syscalls - recvs;
+  InputCursor cursor(in);
+  Frame frame;
+  ReadStatus status = decode_frame(cursor, frame, WireFormat::Json);
+  if (status == ReadStatus::Incomplete && open) {
+    return; // Wait for the rest of the handshake
+  }
+  cursor.commit();
+  InputBuffer rest = std::move(in);
+  worker.pending_input.erase(fd);
+  worker.clients_by_fd.erase(fd);
+  if (status != ReadStatus::Ok || !open) {
+    TraceLog(LOG_WARNING, "Couldn't read handshake from fd=%d", fd);
+    shutdown(fd, SHUT_RDWR);
+    close(fd);
     return;
   }
-  client.epd = epoll_fd;
 
-  ee.events = EPOLLIN | EPOLLRDHUP | EPOLLERR;
-  ee.data.fd = client.fd_main;
-  if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, client.fd_main, &ee) == -1) {
-    close(epoll_fd);
-    TraceLog(LOG_ERROR,
-             "Couldn't instantiate EPOLLIN for main_fd for client_id=%ld,fd=%d",
-             client.client_id, client.fd_main);
-    disconnect_client(client);
+  uint32_t client_id = handleGetClientId(fd, frame);
+  if (client_id == 0) {
     return;
   }
-  ee.events = EPOLLIN;
-  ee.data.fd = client.todo_fd;
-  if (epoll_ctl(client.epd, EPOLL_CTL_ADD, client.todo_fd, &ee) == -1) {
-    close(client.epd);
-    TraceLog(
-        LOG_ERROR,
-        "Couldn't instantiate EPOLLIN for eventfd=%d for client_id=%ld,fd=%d",
-        client.todo_fd, client.client_id, client.fd_main);
-    disconnect_client(client);
+
+  Client *client_ptr = nullptr;
+  try {
+    std::lock_guard<std::mutex> lg(clients_mutex);
+    client_ptr = &clients.at(client_id);
+  } catch (const std::out_of_range &ex) {
     return;
   }
+  Client &client = *client_ptr;
+  client.worker_id = worker.worker_id;
+  client.last_activity = steady_clock::now();
+  worker.clients_by_fd[client.fd_main] = client_id;
+
+  if (worker.ring) {
+    watch_client_uring(worker, client);
+  } else {
+    epoll_event ee{};
+    ee.events = EPOLLIN;
+    ee.data.fd = client.todo_fd;
+    if (epoll_ctl(worker.epoll_fd, EPOLL_CTL_ADD, client.todo_fd, &ee) == -1) {
+      TraceLog(
+          LOG_ERROR,
+          "Couldn't instantiate EPOLLIN for eventfd=%d for client_id=%ld,fd=%d",
+          client.todo_fd, client.client_id, client.fd_main);
+      disconnect_client(client);
+      release_client(worker, client);
+      return;
+    }
+  }
+  worker.clients_by_fd[client.todo_fd] = client_id;
 
   TraceLog(LOG_DEBUG, "Added queue to epoll for client_id=%ld,fd=%d",
            client.client_id, client.fd_main);
 
-  while (client.fd_main > 2) {
-    int nfds = epoll_wait(epoll_fd, events, 2,
-                          Constants::CONNECTION_TIMEOUT_MILISECONDS);
-    if (nfds == -1) {
-      // EPOLL WAIT ERROR
-      close(epoll_fd);
-      TraceLog(LOG_ERROR, "Epoll wait error for client_id=%ld,fd=%d",
+  // Frames sent right after the handshake
+  client.in = std::move(rest);
+  process_frames(client);
+  if (client.fd_main == -1) {
+    release_client(worker, client);
+  } else {
+    schedule_flush(worker, client);
+  }
+}
+
+void Server::check_connections(Worker &worker) {
+  auto now = steady_clock::now();
+  if (now - worker.last_connection_check <
+      milliseconds(Constants::CONNECTION_CHECK_INTERVAL_MILISECONDS)) {
+    return;
+  }
+  worker.last_connection_check = now;
+
+  if (now - worker.stats.since >= Constants::NETWORK_STATS_INTERVAL) {
+    if (worker.stats.flushes > 0 || worker.stats.accepted > 0) {
+      TraceLog(LOG_INFO,
+               "Worker %lu (%s): %lu accepted, %lu flushes, %lu I/O syscalls, "
+               "%.1f bytes/flush, broadcast latency p99 %.3fms, max queued "
+               "%lu bytes, %lu superseded updates dropped, %lu slow clients "
+               "disconnected",
+               worker.worker_id, worker.ring ? "io_uring" : "epoll",
+               worker.stats.accepted, worker.stats.flushes,
+               worker.stats.syscalls,
+               (double)worker.stats.bytes / std::max<uint64_t>(
+                                                worker.stats.flushes, 1),
+               worker.stats.latency_percentile(0.99) / 1000.0,
+               worker.stats.max_queued, worker.stats.dropped_updates,
+               worker.stats.slow_disconnects);
+    }
+    if (worker.stats.datagrams_sent > 0 ||
+        worker.stats.datagrams_received > 0) {
+      TraceLog(LOG_INFO,
+               "Worker %lu: %lu datagrams sent, %lu received, %lu out of "
+               "order discarded, %lu dropped by the shim",
+               worker.worker_id, worker.stats.datagrams_sent,
+               worker.stats.datagrams_received, worker.stats.stale_datagrams,
+               worker.stats.shim_dropped);
+    }
+    worker.stats = NetworkStats{now};
+  }
+
+  std::vector<uint32_t> client_ids;
+  for (auto &[fd, client_id] : worker.clients_by_fd) {
+    if (client_id != 0)
+      client_ids.push_back(client_id);
+  }
+
+  for (auto client_id : client_ids) {
+    Client *client_ptr = nullptr;
+    try {
+      std::lock_guard<std::mutex> lg(clients_mutex);
+      client_ptr = &clients.at(client_id);
+    } catch (const std::out_of_range &ex) {
+      continue;
+    }
+    Client &client = *client_ptr;
+    if (client.fd_main != -1 && !within_output_budget(client, now)) {
+      // Blocked without any new output to trigger a flush
+      worker.stats.slow_disconnects++;
+      disconnect_client(client);
+      release_client(worker, client);
+      continue;
+    }
+    if (client.fd_main == -1 ||
+        now - client.last_activity <
+            milliseconds(Constants::CONNECTION_TIMEOUT_MILISECONDS)) {
+      continue;
+    }
+    client.last_activity = now;
+
+    if (!client.good_connection) {
+      TraceLog(LOG_WARNING, "%s not received from client_id=%ld,fd=%d",
+               network_event_to_string(CheckConnection).c_str(),
                client.client_id, client.fd_main);
       disconnect_client(client);
-      return;
-    } else if (nfds == 0) {
-      // EPOLL WAIT TIMEOUT
-      if (!client.good_connection) {
-        TraceLog(LOG_WARNING, "%s not received from client_id=%ld,fd=%d",
-                 network_event_to_string(CheckConnection).c_str(),
-                 client.client_id, client.fd_main);
-        disconnect_client(client);
-        return;
-      }
+    } else {
       sendCheckConnection(client);
     }
-    for (int n = 0; n < nfds; n++) {
-      if (events[n].events & (EPOLLRDHUP | EPOLLERR | EPOLLHUP)) {
-        disconnect_client(client);
-        break;
-      } else if (events[n].data.fd == client.fd_main) {
-        // EPOLLIN on client.main_fd
-        if (!client.good_connection) {
-          client.good_connection = true;
-        }
-        uint32_t network_event;
-        bool status = read_uint32(client.fd_main, network_event);
-        if (status) {
-          TraceLog(LOG_DEBUG,
-                   "Received NetworkEvent %s from client_id=%ld,fd=%d",
-                   network_event_to_string(network_event).c_str(),
-                   client.client_id, client.fd_main);
-          handle_network_event(client, network_event);
-        } else {
-          TraceLog(LOG_WARNING,
-                   "Couldn't read NetworkEvent from client_id=%ld,fd=%d",
-                   client.client_id, client.fd_main);
-          disconnect_client(client);
-          break;
-        }
-      } else if (events[n].data.fd == client.todo_fd) {
-        // Something on queue
-        auto f = todos.at(client.client_id).pop();
-        f(client);
-      }
+
+    if (client.fd_main == -1) {
+      release_client(worker, client);
+    } else {
+      schedule_flush(worker, client);
     }
   }
 }
 
-uint32_t Server::handleGetClientId(int client_fd) {
-  if (!expectEvent(client_fd, NetworkEvents::GetClientId)) {
-    shutdown(client_fd, SHUT_RDWR);
-    close(client_fd);
-    return 0;
+void Server::release_client(Worker &worker, Client &client) {
+  if (client.send_in_flight) {
+    return; // Released once the kernel is done with its output
+  }
+  // Client and todo queue were registered twice (once per file descriptor)
+  for (auto i = worker.clients_by_fd.begin();
+       i != worker.clients_by_fd.end();) {
+    if (i->second == client.client_id)
+      i = worker.clients_by_fd.erase(i);
+    else
+      i++;
   }
+  if (worker.ring)
+    unwatch_client_uring(worker, client);
+  else
+    epoll_ctl(worker.epoll_fd, EPOLL_CTL_DEL, client.todo_fd, nullptr);
+
+  std::lock_guard<std::mutex> lc(clients_mutex);
+  todos.erase(client.client_id);
+  clients.erase(client.client_id);
+}
 
-  uint32_t client_id;
-  bool status = read_uint32(client_fd, client_id);
-  if (!status) {
-    TraceLog(LOG_WARNING, "Couldn't read new client_id from fd=%d", client_fd);
-    shutdown(client_fd, SHUT_RDWR);
-    close(client_fd);
-    return 0;
+// Reads one client message, the payload layout depends on the event
+ReadStatus Server::decode_frame(InputCursor &cursor, Frame &frame,
+                                WireFormat format) {
+  ReadStatus status = cursor.read_uint32(frame.event);
+  if (status != ReadStatus::Ok)
+    return status;
+  switch ((NetworkEvents)frame.event) {
+  case NetworkEvents::PlayerInput:
+    return read_value(cursor, frame.inputs, format,
+                      Constants::CLIENT_FRAME_MAX_SIZE);
+  case NetworkEvents::GetClientId:
+  case NetworkEvents::JoinRoom:
+  case NetworkEvents::UpdateRoomState:
+    return cursor.read_uint32(frame.value);
+  case NetworkEvents::SnapshotAck:
+    status = cursor.read_uint32(frame.value);
+    return status == ReadStatus::Ok ? cursor.read_uint32(frame.delay_us)
+                                    : status;
+  default:
+    return ReadStatus::Ok;
   }
-  if (client_id == 0) {
-    client_id = _next_client_id++;
-  } else {
-    TraceLog(LOG_WARNING, "Non zero client_id received from fd=%d", client_fd);
+}
+
+// Handles every complete frame received so far
+void Server::process_frames(Client &client) {
+  while (client.fd_main != -1 && client.in.available() > 0) {
+    InputCursor cursor(client.in);
+    Frame frame;
+    ReadStatus status = decode_frame(cursor, frame, client.format);
+    if (status == ReadStatus::Incomplete)
+      break;
+    if (status == ReadStatus::Invalid) {
+      TraceLog(LOG_WARNING,
+               "Couldn't decode NetworkEvent from client_id=%ld,fd=%d",
+               client.client_id, client.fd_main);
+      disconnect_client(client);
+      break;
+    }
+    cursor.commit();
+
+    TraceLog(LOG_DEBUG, "Received NetworkEvent %s from client_id=%ld,fd=%d",
+             network_event_to_string(frame.event).c_str(), client.client_id,
+             client.fd_main);
+    handle_network_event(client, frame);
+  }
+}
+
+uint32_t Server::handleGetClientId(int client_fd, const Frame &frame) {
+  uint32_t capabilities = frame.value;
+  if (frame.event != NetworkEvents::GetClientId) {
+    TraceLog(LOG_WARNING, "Expected %s from fd=%d",
+             network_event_to_string(NetworkEvents::GetClientId).c_str(),
+             client_fd);
     shutdown(client_fd, SHUT_RDWR);
     close(client_fd);
     return 0;
   }
+  uint32_t client_id = _next_client_id++;
   {
     std::lock_guard<std::mutex> lg(clients_mutex);
     TraceLog(LOG_DEBUG, "Creating client entry in clients for %lu", client_id);
@@ -266,31 +709,37 @@ uint32_t Server::handleGetClientId(int client_fd) {
       close(client_fd);
       return 0;
     }
-  }
 
-  status = write_uint32(client_fd, NetworkEvents::GetClientId);
-  if (!status) {
-    TraceLog(LOG_WARNING,
-             "Couldn't write GetClientId NetworkEvent to client_id=%ld,fd=%d",
-             client_id, client_fd);
-    std::lock_guard<std::mutex> lg(clients_mutex);
-    todos.erase(client_id);
-    clients.erase(client_id);
-    shutdown(client_fd, SHUT_RDWR);
-    close(client_fd);
-    return 0;
-  }
-
-  status = write_uint32(client_fd, client_id);
-  if (!status) {
-    TraceLog(LOG_WARNING, "Couldn't write new client id to client_id=%ld,fd=%d",
-             client_id, client_fd);
-    std::lock_guard<std::mutex> lg(clients_mutex);
-    todos.erase(client_id);
-    clients.erase(client_id);
-    shutdown(client_fd, SHUT_RDWR);
-    close(client_fd);
-    return 0;
+    // Sent with the worker's next flush
+    write_uint32(c.out, NetworkEvents::GetClientId);
+    write_uint32(c.out, client_id);
+    // Clients without capabilities get the original two word reply
+    if (capabilities != CapabilityNone) {
+      uint32_t offered = CapabilityNone;
+      if (udp_fd != -1)
+        offered |= CapabilityUdp;
+      if (config.snapshot_rate > 0)
+        offered |= CapabilitySnapshots;
+      if (config.binary)
+        offered |= CapabilityBinary;
+      if (config.binary && config.quantize &&
+          (capabilities & CapabilityBinary))
+        offered |= CapabilityQuantized;
+      uint32_t accepted = capabilities & offered;
+      c.capabilities = accepted;
+      if (accepted & CapabilityQuantized)
+        c.format = WireFormat::Quantized;
+      else if (accepted & CapabilityBinary)
+        c.format = WireFormat::Binary;
+      write_uint32(c.out, accepted);
+      if (accepted & CapabilityUdp) {
+        static thread_local std::mt19937 rng{std::random_device{}()};
+        while (c.udp_token == 0)
+          c.udp_token = rng();
+        write_uint32(c.out, c.udp_token);
+        write_uint32(c.out, config.port);
+      }
+    }
   }
 
   return client_id;
@@ -301,8 +750,8 @@ void Server::handleGetRoomList(Client &client) {
     return;
   }
 
-  auto j_rooms = json(this->get_available_rooms());
-  bool status = write_json(client.fd_main, j_rooms);
+  bool status =
+      write_value(client.out, this->get_available_rooms(), client.format);
   if (!status) {
     TraceLog(LOG_WARNING, "Couldn't send rooms list to client_id=%ld,fd=%d",
              client.client_id, client.fd_main);
@@ -312,7 +761,7 @@ void Server::handleGetRoomList(Client &client) {
 
 void Server::sendNewGameSoon(Client &client, uint32_t when) {
   serverSetEvent(client, NetworkEvents::NewGameSoon);
-  write_uint32(client.fd_main, when);
+  write_uint32(client.out, when);
 }
 
 void Server::handleVoteReady(Client &client) {
@@ -321,23 +770,24 @@ void Server::handleVoteReady(Client &client) {
   }
 
   try {
-    GameRoom &gr = games.at(client.room_id);
-    json player_short_infos_json;
+    GameRoom &gr = get_room(client.room_id);
+    std::vector<PlayerIdState> player_short_infos;
     {
       std::lock_guard<std::mutex> lgm(gr.gameRoomMutex);
       gr.room.players.at(client.player_id).state = PlayerInfo::READY;
       gr.gameManager.players.at(client.player_id).active = true;
-      player_short_infos_json = gr.room.players;
-      bool thread_is_running = gr.thread_is_running.load();
+      player_short_infos = gr.room.players;
+      bool round_is_running = gr.round_is_running.load();
       if (get_X_players(gr.room.players, READY) >= 2 &&
-          gr.room.status != GameStatus::GAME && !thread_is_running) {
-        while (!gr.thread_is_running.compare_exchange_strong(thread_is_running,
-                                                             true)) {
+          gr.room.status != GameStatus::GAME && !round_is_running) {
+        while (!gr.round_is_running.compare_exchange_strong(round_is_running,
+                                                            true)) {
         }
-        std::thread(&Server::new_game, this, gr.room.room_id).detach();
+        uint32_t room_id = gr.room.room_id;
+        room_executor.submit([this, room_id]() { new_game(room_id); });
       }
     }
-    bool status = write_json(client.fd_main, player_short_infos_json);
+    bool status = write_value(client.out, player_short_infos, client.format);
     if (!status) {
       TraceLog(LOG_WARNING,
                "Couldn't send json of players to client_id=%ld,fd=%d",
@@ -350,68 +800,81 @@ void Server::handleVoteReady(Client &client) {
   }
 
   try {
-    auto &gr = games.at(client.room_id);
+    auto &gr = get_room(client.room_id);
     std::lock_guard<std::mutex> lg(gr.gameRoomMutex);
     for (auto c : gr.clients) {
-      todos.at(c).push([&](Client c1) { sendUpdateRoomState(c1); });
+      todos.at(c).push([&](Client &c1) { sendUpdateRoomState(c1); });
     }
   } catch (const std::out_of_range &ex) {
     TraceLog(LOG_WARNING, "VoteReady: room or player id doesn't exist");
   }
 }
 
-void Server::handlePlayerMovement(Client &client) {
-  Vector2 position, velocity;
-  float rotation;
-  json movement;
-  bool status = read_json(client.fd_main, movement, -1);
-  if (!status) {
-    TraceLog(LOG_ERROR, "NET: Couldn't receive json of movement");
-    disconnect_client(client);
-    return;
-  }
-
-  try {
-    movement.at("position").get_to(position);
-    movement.at("velocity").get_to(velocity);
-    movement.at("rotation").get_to(rotation);
-  } catch (json::exception &ex) {
-    TraceLog(LOG_ERROR, "JSON: Couldn't deserialize json into movement");
-    disconnect_client(client);
-    return;
-  }
+// Only queued, the room's next ticks move the player
+void Server::handlePlayerInput(Client &client,
+                               const std::vector<InputState> &inputs) {
   try {
-    auto &gr = games.at(client.room_id);
+    auto &gr = get_room(client.room_id);
     std::lock_guard<std::mutex> lg(gr.gameRoomMutex);
-    auto &player = gr.gameManager.players.at(client.player_id);
-    player.position = position;
-    player.rotation = rotation;
-    player.velocity = velocity;
-
-    for (auto c : gr.clients) {
-      if (c == client.client_id)
-        continue;
+    if (gr.room.status != GameStatus::GAME)
+      return;
+    uint32_t slack = gr.gameManager.tick_rate *
+                     duration<double>(Constants::INPUT_TICK_SLACK).count();
+    gr.inputs.at(client.player_id).receive(inputs, slack);
+  } catch (const std::out_of_range &ex) {
+    TraceLog(LOG_WARNING, "PlayerInput: room or player id doesn't exist");
+  }
+}
 
-      todos.at(c).push([&](Client c1) {
-        serverSetEvent(c1, NetworkEvents::PlayerMovement);
-        write_uint32(c1.fd_main, client.player_id);
+// Every player moves by one tick of its input. Their movement goes to the
+// whole room at the input send interval, to its own client it acknowledges
+// the input ticks simulated so far.
+void Server::step_players(GameRoom &gr, duration<double> frametime) {
+  auto &game = gr.gameManager;
+  // Movement goes out at the rate clients send their input
+  double interval = duration<double>(Constants::INPUT_SEND_INTERVAL).count();
+  uint64_t relay_ticks =
+      std::max<uint64_t>(1, std::lround(game.tick_rate * interval));
+  bool relay = gr.scheduler.ticks % relay_ticks == 0;
+  for (uint32_t j = 0; j < game.players.size(); j++) {
+    auto &player = game.players[j];
+    uint32_t buttons = gr.inputs.at(j).step();
+    ApplyInputButtons(player, buttons, frametime, game.fixed_tick_rate);
+    if (buttons & InputFire && player.active)
+      shoot_bullet(gr, j);
+    if (relay && gr.room.players.at(j).state != PlayerInfo::NONE)
+      relay_movement(gr, j);
+  }
+}
 
-        auto &player1 = gr.gameManager.players.at(client.player_id);
+void Server::relay_movement(GameRoom &gr, uint32_t player_id) {
+  const auto &player = gr.gameManager.players.at(player_id);
+  // Encoded once per format, a newer movement of the same player
+  // supersedes it
+  Movement relayed = {player.position, player.velocity, player.rotation,
+                      player.active, gr.inputs.at(player_id).tick};
+  std::array<SharedBytes, WIRE_FORMATS> shared;
+  for (auto format :
+       {WireFormat::Json, WireFormat::Binary, WireFormat::Quantized}) {
+    if (!gr.uses(format))
+      continue;
+    auto bytes = std::make_shared<std::vector<uint8_t>>();
+    write_uint32(*bytes, NetworkEvents::PlayerMovement);
+    write_uint32(*bytes, player_id);
+    write_value(*bytes, relayed, format);
+    shared[(size_t)format] = std::move(bytes);
+  }
 
-        json movement1 = {{"position", player1.position},
-                          {"velocity", player1.velocity},
-                          {"rotation", player1.rotation},
-                          {"active", player1.active}};
-        write_json(c1.fd_main, movement1);
-      });
-    }
-  } catch (const std::out_of_range &ex) {
-    TraceLog(LOG_WARNING, "PlayerMovement: room or player id doesn't exist");
+  for (auto c : gr.clients) {
+    todos.at(c).push([this, player_id, shared](Client &c1) {
+      send_unreliable(c1, NetworkEvents::PlayerMovement, player_id,
+                      shared[(size_t)c1.format]);
+    });
   }
 }
 
 bool Server::serverSetEvent(Client &client, NetworkEvents event) {
-  bool status = write_uint32(client.fd_main, event);
+  bool status = write_uint32(client.out, event);
   if (!status) {
     TraceLog(LOG_WARNING,
              "Couldn't write %s NetworkEvent to client_id=%ld,fd=%d",
@@ -422,43 +885,41 @@ bool Server::serverSetEvent(Client &client, NetworkEvents event) {
   return status;
 }
 
+// Clients sending ShootBullets instead of the fire button shoot at the next
+// tick too
 void Server::handleShootBullet(Client &client) {
-  bool status;
-
   try {
-    GameRoom &gr = games.at(client.room_id);
+    GameRoom &gr = get_room(client.room_id);
     std::lock_guard<std::mutex> lg(gr.gameRoomMutex);
-    const Player &p = gr.gameManager.players.at(client.player_id);
-    status = gr.gameManager.AddBullet(p);
+    gr.inputs.at(client.player_id).fire = true;
   } catch (const std::out_of_range &ex) {
-    status = false;
+    TraceLog(LOG_WARNING, "ShootBullets: room or player id doesn't exist");
   }
+}
 
-  if (!status) {
-    TraceLog(LOG_WARNING, "Player id=%lu cannot shoot bullet",
-             client.player_id);
+void Server::shoot_bullet(GameRoom &gr, uint32_t player_id) {
+  uint32_t bullet = gr.gameManager.AddBullet(gr.gameManager.players[player_id]);
+  if (bullet == UINT32_MAX) {
+    TraceLog(LOG_DEBUG, "Player id=%lu cannot shoot bullet", player_id);
     return;
   }
 
-  try {
-    auto &gr = games.at(client.room_id);
-    std::lock_guard<std::mutex> lg(gr.gameRoomMutex);
-    for (auto c : gr.clients) {
-      todos.at(c).push([&](Client c1) {
-        serverSetEvent(c1, NetworkEvents::ShootBullets);
-
-        bool status = write_uint32(c1.fd_main, client.player_id);
-        if (!status) {
-          TraceLog(LOG_WARNING,
-                   "Couldn't send info about bullet shot by player_id=%lu to "
-                   "client_id=%ld,fd=%d",
-                   client.player_id, client.client_id, client.fd_main);
-          disconnect_client(client);
-        }
-      });
-    }
-  } catch (const std::out_of_range &ex) {
-    TraceLog(LOG_WARNING, "ShootBullets: room doesn't exist");
+  for (auto c : gr.clients) {
+    todos.at(c).push([this, player_id, bullet](Client &c1) {
+      serverSetEvent(c1, NetworkEvents::ShootBullets);
+
+      // The slot is chosen by the server's free list, the clients can't
+      // work it out themselves
+      bool status = write_uint32(c1.out, player_id) &&
+                    write_uint32(c1.out, bullet);
+      if (!status) {
+        TraceLog(LOG_WARNING,
+                 "Couldn't send info about bullet shot by player_id=%lu to "
+                 "client_id=%ld,fd=%d",
+                 player_id, c1.client_id, c1.fd_main);
+        disconnect_client(c1);
+      }
+    });
   }
 }
 
@@ -468,7 +929,7 @@ void Server::restart_timer(GameRoom &gr, std::vector<uint32_t> &last_clients) {
   last_clients = gr.clients;
   for (auto c : gr.clients) {
     auto time = system_clock::to_time_t(gr.gameManager.game_start_time);
-    todos.at(c).push([=](Client c1) {
+    todos.at(c).push([this, time](Client &c1) {
       sendUpdateRoomState(c1);
       sendNewGameSoon(c1, time);
     });
@@ -476,123 +937,265 @@ void Server::restart_timer(GameRoom &gr, std::vector<uint32_t> &last_clients) {
 }
 
 void Server::new_game(uint32_t room_id) {
-
-  std::vector<uint32_t> destroyed_asteroids;
-  destroyed_asteroids.resize(Constants::ASTEROIDS_MAX);
-  std::vector<uint32_t> spawned_asteroids;
-  spawned_asteroids.resize(Constants::ASTEROIDS_MAX);
-  std::vector<uint32_t> destroyed_players_ids;
-  destroyed_players_ids.reserve(Constants::PLAYERS_MAX);
-  std::vector<uint32_t> destroyed_bullets_ids;
-  destroyed_bullets_ids.reserve(Constants::BULLETS_PER_PLAYER *
-                                Constants::PLAYERS_MAX);
-
-  auto &gr = games.at(room_id);
-  auto last_clients = gr.clients;
-  restart_timer(gr, last_clients);
-  std::this_thread::sleep_until(gr.gameManager.game_start_time - 0.1s);
-
-  gr.room.status = GameStatus::GAME;
-  gr.gameManager.NewGame(gr.room.players);
-  for (auto c : gr.clients) {
-    todos.at(c).push([=](Client c1) {
-      serverSetEvent(c1, NetworkEvents::StartRound);
-      handleUpdatePlayers(c1);
-    });
+  steady_clock::time_point round_start;
+  try {
+    auto &gr = get_room(room_id);
+    std::lock_guard<std::mutex> lg(gr.gameRoomMutex);
+    auto last_clients = gr.clients;
+    gr.room.seed = _next_seed++;
+    restart_timer(gr, last_clients);
+    round_start = steady_clock::now() +
+                  duration_cast<steady_clock::duration>(
+                      gr.gameManager.game_start_time - system_clock::now() -
+                      0.1s);
+  } catch (const std::out_of_range &ex) {
+    return;
   }
-  auto game_start_time = std::chrono::steady_clock::now();
-  auto frame_start_time = std::chrono::steady_clock::now();
-  duration<double> frametime = game_start_time - steady_clock::now();
-  gr.gameManager.asteroid_spawner_time = steady_clock::now();
-
-  while (games.at(room_id).room.status == GameStatus::GAME) {
-    {
-      auto frame_start_time1 = std::chrono::steady_clock::now();
-      frametime = frame_start_time1 - frame_start_time;
-      frame_start_time = frame_start_time1;
-      auto &gr = games.at(room_id);
-      std::lock_guard<std::mutex> lg(gr.gameRoomMutex);
-      auto &game = gr.gameManager;
-
-      destroyed_asteroids.clear();
-      spawned_asteroids.clear();
-      destroyed_players_ids.clear();
-      destroyed_bullets_ids.clear();
+  room_executor.submit_at(round_start,
+                          [this, room_id]() { begin_round(room_id); });
+}
 
-      game.ManageCollisions(destroyed_asteroids, spawned_asteroids,
-                            destroyed_players_ids, destroyed_bullets_ids);
+void Server::begin_round(uint32_t room_id) {
+  auto &gr = get_room(room_id);
+  {
+    std::lock_guard<std::mutex> lg(gr.gameRoomMutex);
+    gr.room.status = GameStatus::GAME;
+    gr.gameManager.seed = gr.room.seed;
+    gr.gameManager.NewGame(gr.room.players);
+    for (auto c : gr.clients) {
+      todos.at(c).push([this](Client &c1) {
+        serverSetEvent(c1, NetworkEvents::StartRound);
+        handleUpdatePlayers(c1);
+      });
+    }
+    gr.gameManager.asteroid_spawner_time = steady_clock::now();
+    gr.hit_history.clear();
+    gr.max_rewind = 0s;
+    gr.inputs = {};
+    gr.scheduler.start();
+  }
+  room_executor.submit([this, room_id]() { tick_room(room_id); });
+}
 
-      for (auto &player : game.players) {
-        CalculateUpdatePlayerMovement(player, frametime);
+void Server::tick_room(uint32_t room_id) {
+  auto &gr = get_room(room_id);
+  steady_clock::time_point next_tick;
+  {
+    std::lock_guard<std::mutex> lg(gr.gameRoomMutex);
+    if (gr.room.status != GameStatus::GAME) {
+      end_round(gr);
+      return;
+    }
+    gr.scheduler.tick_started(steady_clock::now());
+    duration<double> frametime = gr.scheduler.frametime();
+
+    auto &game = gr.gameManager;
+    auto &events = gr.tick_events;
+    events.clear();
+
+    rewind_players(gr);
+    game.ManageCollisions(events.destroyed_asteroids, events.spawned_asteroids,
+                          events.destroyed_players_ids,
+                          events.destroyed_bullets_ids);
+
+    step_players(gr, frametime);
+    game.UpdateBullets(frametime);
+    game.UpdateAsteroids(frametime);
+    game.AsteroidSpawner(events.spawned_asteroids);
+
+    // Everything the clients need from this tick, encoded once per format
+    // and shared by all of their output buffers
+    std::array<std::vector<uint8_t>, WIRE_FORMATS> broadcasts;
+    for (auto format :
+         {WireFormat::Json, WireFormat::Binary, WireFormat::Quantized}) {
+      if (!gr.uses(format))
+        continue;
+      auto &broadcast = broadcasts[(size_t)format];
+      for (auto b : events.destroyed_bullets_ids) {
+        encodeBulletDestroyed(broadcast, b);
       }
-
-      game.UpdateBullets(frametime);
-      game.UpdateAsteroids(frametime);
-      game.AsteroidSpawner(spawned_asteroids);
-
-      for (auto b : destroyed_bullets_ids) {
-        for (auto c : gr.clients) {
-          todos.at(c).push([=](Client c1) {
-            TraceLog(LOG_DEBUG, "Updating bullets for client_id=%lu",
-                     c1.client_id);
-            handleBulletDestroyed(c1, b);
-          });
-        }
+      for (auto id : events.spawned_asteroids) {
+        encodeSpawnAsteroid(broadcast, game.asteroids.at(id), id, format);
       }
-
-      for (auto id : spawned_asteroids) {
-        Asteroid &a = game.asteroids.at(id);
-        for (auto c : gr.clients) {
-          todos.at(c).push([=](Client c1) {
-            TraceLog(LOG_DEBUG, "Updating asteroids for client_id=%lu",
-                     c1.client_id);
-            handleSpawnAsteroid(c1, a, id);
-          });
-        }
+      for (auto id : events.destroyed_asteroids) {
+        encodeAsteroidDestroyed(broadcast, id);
       }
-
-      for (auto id : destroyed_asteroids) {
-        for (auto c : gr.clients) {
-          todos.at(c).push([=](Client c1) {
-            TraceLog(LOG_DEBUG, "Updating asteroids for client_id=%lu",
-                     c1.client_id);
-            handleAsteroidDestroyed(c1, id);
-          });
-        }
+      for (auto p : events.destroyed_players_ids) {
+        encodePlayerDestroyed(broadcast, p);
       }
+    }
 
-      for (auto p : destroyed_players_ids) {
-        for (auto c : gr.clients) {
-          todos.at(c).push([=](Client c1) {
-            TraceLog(LOG_DEBUG, "Updating players for client_id=%lu",
-                     c1.client_id);
-            handlePlayerDestroyed(c1, p);
-          });
-        }
+    int active_players = 0;
+    uint32_t winner = UINT32_MAX;
+    for (auto &p : gr.gameManager.players) {
+      if (p.active) {
+        active_players += 1;
+        winner = p.player_id;
       }
-      int active_players = 0;
-      uint32_t winner = UINT32_MAX;
-      for (auto &p : gr.gameManager.players) {
-        if (p.active) {
-          active_players += 1;
-          winner = p.player_id;
-        }
+    }
+    if (active_players < 2) {
+      gr.room.status = GameStatus::LOBBY;
+      gr.gameManager.game_start_time =
+          system_clock::now() + Constants::NEW_ROUND_WAIT_TIME;
+      auto time = system_clock::to_time_t(gr.gameManager.game_start_time);
+      for (auto &broadcast : broadcasts) {
+        write_uint32(broadcast, NetworkEvents::EndRound);
+        write_uint32(broadcast, winner);
+        write_uint32(broadcast, time);
       }
-      if (active_players < 2) {
-        gr.room.status = GameStatus::LOBBY;
-        gr.gameManager.game_start_time =
-            system_clock::now() + Constants::NEW_ROUND_WAIT_TIME;
-        auto time = system_clock::to_time_t(gr.gameManager.game_start_time);
-        for (auto c : gr.clients) {
-          todos.at(c).push([=](Client c1) {
-            serverSetEvent(c1, NetworkEvents::EndRound);
-            write_uint32(c1.fd_main, winner);
-            write_uint32(c1.fd_main, time);
-          });
-        }
+    }
+
+    if (config.snapshot_rate > 0 &&
+        gr.scheduler.ticks %
+                std::max(1u, config.tick_rate / config.snapshot_rate) ==
+            0)
+      send_snapshots(gr);
+
+    if (std::any_of(broadcasts.begin(), broadcasts.end(),
+                    [](auto &broadcast) { return !broadcast.empty(); })) {
+      std::array<SharedBytes, WIRE_FORMATS> shared;
+      for (size_t i = 0; i < WIRE_FORMATS; i++)
+        shared[i] = std::make_shared<const std::vector<uint8_t>>(
+            std::move(broadcasts[i]));
+      auto queued_at = steady_clock::now();
+      for (auto c : gr.clients) {
+        todos.at(c).push([shared, queued_at](Client &c1) {
+          c1.out.append(shared[(size_t)c1.format]);
+          if (c1.broadcast_queued == steady_clock::time_point{})
+            c1.broadcast_queued = queued_at;
+        });
       }
     }
+    next_tick = gr.scheduler.advance();
+  }
+  room_executor.submit_at(next_tick,
+                          [this, room_id]() { tick_room(room_id); });
+}
+
+// Every subscribed client gets the world as a delta against the last
+// snapshot it acknowledged. Clients sharing a baseline share the encoding.
+void Server::send_snapshots(GameRoom &gr) {
+  if (gr.snapshot_acks.empty())
+    return;
+  uint32_t id = ++gr.snapshot_id;
+  if (id == 0) // 0 is reserved for the empty world
+    id = ++gr.snapshot_id;
+  Snapshot &snapshot = gr.snapshots[id % Constants::SNAPSHOT_HISTORY];
+  snapshot.capture(gr.gameManager, id);
+  gr.snapshot_times[id % Constants::SNAPSHOT_HISTORY] = steady_clock::now();
+  // Bounds the damage of a corrupted baseline on the client
+  bool keyframe = id % Constants::SNAPSHOT_KEYFRAME_INTERVAL == 0;
+
+  std::map<uint32_t, SharedBytes> encoded;
+  for (auto &[client_id, acked] : gr.snapshot_acks) {
+    const Snapshot *baseline = &Snapshot::empty(snapshot.type);
+    const Snapshot &candidate =
+        gr.snapshots[acked % Constants::SNAPSHOT_HISTORY];
+    if (!keyframe && acked != 0 && candidate.id == acked &&
+        id - acked < Constants::SNAPSHOT_HISTORY)
+      baseline = &candidate;
+
+    auto &bytes = encoded[baseline->id];
+    if (!bytes) {
+      auto out = std::make_shared<std::vector<uint8_t>>();
+      write_uint32(*out, NetworkEvents::WorldSnapshot);
+      write_snapshot_delta(*out, *baseline, snapshot);
+      bytes = std::move(out);
+    }
+    gr.snapshots_sent++;
+    gr.snapshot_bytes += bytes->size();
+    todos.at(client_id).push([this, bytes](Client &c1) {
+      send_unreliable(c1, NetworkEvents::WorldSnapshot, 0, bytes);
+    });
+  }
+}
+
+// Bullets of every shooter hit the other players where its client drew
+// them: a round trip plus its interpolation delay ago. Not in deterministic
+// rounds, whose outcome must only depend on the inputs.
+void Server::rewind_players(GameRoom &gr) {
+  auto &game = gr.gameManager;
+  auto now = steady_clock::now();
+  gr.hit_history.record(now, game.players);
+  game.rewound_views = 0;
+  if (game.fixed_tick_rate)
+    return;
+  for (size_t j = 0; j < game.players.size(); j++) {
+    auto rewind = std::min<duration<double>>(
+        gr.player_rtt[j] + gr.player_delay[j], Constants::LAG_COMPENSATION_MAX);
+    if (rewind < gr.scheduler.frametime())
+      continue;
+    auto view_time = now - duration_cast<steady_clock::duration>(rewind);
+    if (gr.hit_history.rewind(view_time, game.rewound_x[j].data(),
+                              game.rewound_y[j].data()))
+      game.rewound_views |= uint64_t(1) << j;
+    gr.max_rewind = std::max(gr.max_rewind, rewind);
+  }
+}
+
+void Server::handleSnapshotAck(Client &client, uint32_t snapshot_id,
+                               uint32_t delay_us) {
+  try {
+    auto &gr = get_room(client.room_id);
+    std::lock_guard<std::mutex> lg(gr.gameRoomMutex);
+    auto ack = gr.snapshot_acks.find(client.client_id);
+    // Acks can arrive out of order over UDP, only move forward
+    if (ack == gr.snapshot_acks.end() ||
+        sequence_newer(snapshot_id, gr.snapshot_id) ||
+        (ack->second != 0 && !sequence_newer(snapshot_id, ack->second)))
+      return;
+    ack->second = snapshot_id;
+    if (client.player_id < gr.player_delay.size())
+      gr.player_delay[client.player_id] = std::min<duration<double>>(
+          microseconds(delay_us), Constants::INTERPOLATION_DELAY_MAX);
+
+    // Smoothed by 1/8 like TCP's round trip estimate
+    size_t slot = snapshot_id % Constants::SNAPSHOT_HISTORY;
+    if (gr.snapshots[slot].id != snapshot_id ||
+        client.player_id >= gr.player_rtt.size())
+      return;
+    duration<double> rtt = steady_clock::now() - gr.snapshot_times[slot];
+    auto &srtt = gr.player_rtt[client.player_id];
+    srtt = srtt == 0s ? rtt : srtt + (rtt - srtt) / 8;
+  } catch (const std::out_of_range &ex) {
+    TraceLog(LOG_WARNING, "SnapshotAck: room doesn't exist");
+  }
+}
+
+void Server::end_round(GameRoom &gr) {
+  gr.tick_overruns += gr.scheduler.overruns;
+  TraceLog(LOG_INFO,
+           "Room %lu finished round after %lu ticks, %lu overruns, tick "
+           "latency avg %.3fms max %.3fms",
+           gr.room.room_id, gr.scheduler.ticks, gr.scheduler.overruns,
+           gr.scheduler.average_latency().count(),
+           duration<double, std::milli>(gr.scheduler.latency_max).count());
+  if (gr.max_rewind > 0s)
+    TraceLog(LOG_INFO, "Room %lu rewound players by up to %.0fms for hits",
+             gr.room.room_id, gr.max_rewind.count() * 1000);
+  if (gr.snapshots_sent > 0) {
+    // Against the full state in every format, deltas carry whole words and
+    // can lose to the quantized one when most asteroids move
+    std::array<size_t, WIRE_FORMATS> full_state{};
+    for (auto format :
+         {WireFormat::Json, WireFormat::Binary, WireFormat::Quantized}) {
+      std::vector<uint8_t> bytes;
+      write_value(bytes, gr.gameManager, format);
+      full_state[(size_t)format] = bytes.size();
+    }
+    TraceLog(LOG_INFO,
+             "Room %lu sent %lu snapshots, %.1f bytes each on average "
+             "(UpdateGameState: %lu bytes BSON, %lu binary, %lu quantized)",
+             gr.room.room_id, gr.snapshots_sent,
+             (double)gr.snapshot_bytes / gr.snapshots_sent,
+             full_state[(size_t)WireFormat::Json],
+             full_state[(size_t)WireFormat::Binary],
+             full_state[(size_t)WireFormat::Quantized]);
+    gr.snapshots_sent = gr.snapshot_bytes = 0;
   }
+  if (gr.gameManager.asteroid_pool.exhausted > 0)
+    TraceLog(LOG_INFO, "Room %lu ran out of asteroid slots %lu times",
+             gr.room.room_id, gr.gameManager.asteroid_pool.exhausted);
   gr.room.status = GameStatus::LOBBY;
   for (auto &p : gr.room.players) {
     if (p.state == PlayerInfo::READY)
@@ -603,34 +1206,28 @@ void Server::new_game(uint32_t room_id) {
     gr.gameManager.game_start_time =
         system_clock::now() - Constants::NEW_ROUND_WAIT_TIME;
     auto when = system_clock::to_time_t(gr.gameManager.game_start_time);
-    todos.at(c).push([=](Client c1) {
+    todos.at(c).push([this, when](Client &c1) {
       serverSetEvent(c1, NetworkEvents::ReturnToLobby);
-      write_uint32(c1.fd_main, when);
+      write_uint32(c1.out, when);
       sendUpdateRoomState(c1);
     });
   }
 
-  bool thread_is_running = gr.thread_is_running.load();
+  bool round_is_running = gr.round_is_running.load();
   while (
-      !gr.thread_is_running.compare_exchange_strong(thread_is_running, false)) {
+      !gr.round_is_running.compare_exchange_strong(round_is_running, false)) {
   }
 }
 
-void Server::handleJoinRoom(Client &client) {
+void Server::handleJoinRoom(Client &client, uint32_t read_room_id) {
   bool status = false;
-  uint32_t read_room_id;
-  status = read_uint32(client.fd_main, read_room_id);
-  if (!status) {
-    TraceLog(LOG_WARNING,
-             "Couldn't read room id to join from client_id=%ld,fd=%d",
-             client.client_id, client.fd_main);
-    disconnect_client(client);
-  }
   TraceLog(LOG_DEBUG, "Received room id=%lu to join from client_id=%lu,fd=%d",
            read_room_id, client.client_id, client.fd_main);
 
   try {
     {
+      // Rooms are only reclaimed with games_mutex held
+      std::lock_guard<std::mutex> gml(games_mutex);
       auto &gr = games.at(read_room_id);
       std::lock_guard<std::mutex> lg(gr.gameRoomMutex);
       auto player_id = get_next_available_player_id(gr);
@@ -639,9 +1236,16 @@ void Server::handleJoinRoom(Client &client) {
       if (status) {
         gr.room.players.at(player_id).state = PlayerInfo::NOT_READY;
         gr.clients.push_back(client.client_id);
+        if (client.capabilities & CapabilitySnapshots)
+          gr.snapshot_acks[client.client_id] = 0;
+        gr.player_rtt.at(player_id) = 0s;
+        gr.player_delay.at(player_id) = 0s;
+        gr.format_clients[(size_t)client.format]++;
       }
     }
-    client.room_id = read_room_id;
+    // Only a room the client is in stays out of the reclaimed ones
+    if (status)
+      client.room_id = read_room_id;
   } catch (const std::out_of_range &ex) {
     status = false;
   }
@@ -652,7 +1256,7 @@ void Server::handleJoinRoom(Client &client) {
   }
 
   TraceLog(LOG_DEBUG, "Sending read room join to id=%lu", client.player_id);
-  status = write_uint32(client.fd_main, (uint32_t)status * read_room_id);
+  status = write_uint32(client.out, (uint32_t)status * read_room_id);
   if (!status) {
     TraceLog(LOG_WARNING, "Couldn't send joined room id to client_id=%ld,fd=%d",
              client.client_id, client.fd_main);
@@ -660,7 +1264,7 @@ void Server::handleJoinRoom(Client &client) {
   }
 
   TraceLog(LOG_DEBUG, "Sending playerid to id=%lu", client.player_id);
-  status = write_uint32(client.fd_main, client.player_id);
+  status = write_uint32(client.out, client.player_id);
   if (!status) {
     TraceLog(LOG_WARNING, "Couldn't send player id to client_id=%ld,fd=%d",
              client.client_id, client.fd_main);
@@ -668,25 +1272,32 @@ void Server::handleJoinRoom(Client &client) {
   }
 
   try {
-    auto &gr = games.at(client.room_id);
+    auto &gr = get_room(client.room_id);
     std::lock_guard<std::mutex> lg(gr.gameRoomMutex);
     for (auto c : gr.clients) {
-      todos.at(c).push([&](Client c1) { sendUpdateRoomState(c1); });
+      todos.at(c).push([&](Client &c1) { sendUpdateRoomState(c1); });
     }
   } catch (const std::out_of_range &ex) {
   }
 }
 
 void Server::handleLeaveRoom(Client &client, bool send_confirmation) {
+  if (client.room_id == 0) {
+    TraceLog(LOG_DEBUG, "client_id=%ld,fd=%d isn't in any room to leave",
+             client.client_id, client.fd_main);
+    return;
+  }
   std::vector<uint32_t> client_ids;
   try {
-    auto &gr = games.at(client.room_id);
+    auto &gr = get_room(client.room_id);
     std::lock_guard<std::mutex> lg(gr.gameRoomMutex);
     for (auto i = gr.clients.begin(); i != gr.clients.end(); i++) {
       if (*i == client.client_id) {
         client_ids = gr.clients;
         // Found, remove client from GameRoom
         gr.clients.erase(i);
+        gr.snapshot_acks.erase(client.client_id);
+        gr.format_clients[(size_t)client.format]--;
         try {
           gr.room.players.at(client.player_id).state = PlayerInfo::NONE;
           gr.gameManager.players.at(client.player_id).active = false;
@@ -711,14 +1322,15 @@ void Server::handleLeaveRoom(Client &client, bool send_confirmation) {
     if (c == client.client_id)
       continue;
     try {
-      todos.at(c).push([=](Client c1) {
+      // Only the player id, a whole Client would copy its buffers
+      todos.at(c).push([this, player_id = client.player_id](Client &c1) {
         serverSetEvent(c1, NetworkEvents::LeaveRoom);
-        bool status = write_uint32(c1.fd_main, client.player_id);
+        bool status = write_uint32(c1.out, player_id);
         if (!status) {
           TraceLog(LOG_WARNING,
                    "Couldn't send leaving room confirmation to "
                    "client_id=%ld,fd=%d",
-                   client.room_id, client.client_id, client.fd_main);
+                   c1.client_id, c1.fd_main);
           disconnect_client(c1);
         }
         sendUpdateRoomState(c1);
@@ -729,7 +1341,7 @@ void Server::handleLeaveRoom(Client &client, bool send_confirmation) {
 
   if (send_confirmation) {
     serverSetEvent(client, NetworkEvents::LeaveRoom);
-    bool status = write_uint32(client.fd_main, client.player_id);
+    bool status = write_uint32(client.out, client.player_id);
     if (!status) {
       TraceLog(LOG_WARNING,
                "Couldn't send leaving room confirmation to "
@@ -739,13 +1351,15 @@ void Server::handleLeaveRoom(Client &client, bool send_confirmation) {
     }
   }
   client.player_id = -1;
+  // The room may be reclaimed as soon as it's empty
+  client.room_id = 0;
 }
 
 void Server::handleUpdateGameState(Client &client) {
   try {
-    json gameState = games.at(client.room_id).gameManager;
+    auto &gameState = get_room(client.room_id).gameManager;
     serverSetEvent(client, NetworkEvents::UpdateGameState);
-    bool status = write_json(client.fd_main, gameState);
+    bool status = write_value(client.out, gameState, client.format);
     if (!status) {
       TraceLog(LOG_WARNING,
                "Couldn't send game state json to"
@@ -763,16 +1377,7 @@ void Server::handleUpdateGameState(Client &client) {
 }
 
 void Server::handleUpdateRoomState(Client &client) {
-  bool status;
-  uint32_t room_id;
-  status = read_uint32(client.fd_main, room_id);
-  if (!status) {
-    TraceLog(LOG_WARNING, "Couldn't read room id fetch for client_id=%ld,fd=%d",
-             client.client_id, client.fd_main);
-    disconnect_client(client);
-    return;
-  }
-  status = sendUpdateRoomState(client);
+  bool status = sendUpdateRoomState(client);
   if (!status) {
     disconnect_client(client);
     return;
@@ -781,15 +1386,18 @@ void Server::handleUpdateRoomState(Client &client) {
 
 bool Server::sendUpdateRoomState(Client &client) {
   try {
-    json room_json = games.at(client.room_id).room;
-    serverSetEvent(client, NetworkEvents::UpdateRoomState);
-    bool status = write_json(client.fd_main, room_json);
+    auto &room = get_room(client.room_id).room;
+    auto bytes = std::make_shared<std::vector<uint8_t>>();
+    write_uint32(*bytes, NetworkEvents::UpdateRoomState);
+    bool status = write_value(*bytes, room, client.format);
     if (!status) {
       TraceLog(LOG_WARNING, "Couldn't send json of room to client_id=%ld,fd=%d",
                client.client_id, client.fd_main);
       disconnect_client(client);
       return false;
     }
+    // Only the latest room state matters to a client that is behind
+    send_latest(client, NetworkEvents::UpdateRoomState, 0, std::move(bytes));
     return status;
   } catch (const std::out_of_range &ex) {
     // Invalid room id
@@ -803,9 +1411,9 @@ bool Server::sendUpdateRoomState(Client &client) {
 void Server::handleUpdatePlayers(Client &client) {
   try {
     bool status;
-    json players_json = games.at(client.room_id).gameManager.players;
+    auto &players = get_room(client.room_id).gameManager.players;
     serverSetEvent(client, NetworkEvents::UpdatePlayers);
-    status = write_json(client.fd_main, players_json);
+    status = write_value(client.out, players, client.format);
     if (!status) {
       TraceLog(LOG_WARNING,
                "Couldn't send json of players to client_id=%ld,fd=%d",
@@ -824,8 +1432,8 @@ void Server::handleUpdatePlayers(Client &client) {
 void Server::handleUpdateAsteroids(Client &client) {
   try {
     serverSetEvent(client, NetworkEvents::UpdateAsteroids);
-    json j = games.at(client.room_id).gameManager.asteroids;
-    bool status = write_json(client.fd_main, j);
+    auto &asteroids = get_room(client.room_id).gameManager.asteroids;
+    bool status = write_value(client.out, asteroids, client.format);
     if (!status) {
       TraceLog(LOG_WARNING, "Couldn't send asteroids to client_id=%ld,fd=%d",
                client.room_id, client.client_id, client.fd_main);
@@ -843,9 +1451,9 @@ void Server::handleUpdateAsteroids(Client &client) {
 void Server::handleUpdateBullets(Client &client) {
   try {
     bool status;
-    json bullets_json = games.at(client.room_id).gameManager.bullets;
+    auto &bullets = get_room(client.room_id).gameManager.bullets;
     serverSetEvent(client, NetworkEvents::UpdateBullets);
-    status = write_json(client.fd_main, bullets_json);
+    status = write_value(client.out, bullets, client.format);
     if (!status) {
       TraceLog(LOG_WARNING,
                "Couldn't send json of bullets to client_id=%ld,fd=%d",
@@ -868,7 +1476,8 @@ void Server::invalid_network_event(Client &client, uint32_t event) {
   disconnect_client(client);
 }
 
-void Server::handle_network_event(Client &client, uint32_t event) {
+void Server::handle_network_event(Client &client, Frame &frame) {
+  uint32_t event = frame.event;
   switch ((NetworkEvents)event) {
   case NetworkEvents::NoEvent:
     TraceLog(LOG_WARNING, "NoEvent received from client_id=%ld,fd=%d",
@@ -895,8 +1504,8 @@ void Server::handle_network_event(Client &client, uint32_t event) {
   case NetworkEvents::VoteReady:
     handleVoteReady(client);
     break;
-  case NetworkEvents::PlayerMovement:
-    handlePlayerMovement(client);
+  case NetworkEvents::PlayerInput:
+    handlePlayerInput(client, frame.inputs);
     break;
   case NetworkEvents::ShootBullets:
     handleShootBullet(client);
@@ -905,7 +1514,7 @@ void Server::handle_network_event(Client &client, uint32_t event) {
     handleGetRoomList(client);
     break;
   case NetworkEvents::JoinRoom:
-    handleJoinRoom(client);
+    handleJoinRoom(client, frame.value);
     break;
   case NetworkEvents::LeaveRoom:
     handleLeaveRoom(client, true);
@@ -925,6 +1534,9 @@ void Server::handle_network_event(Client &client, uint32_t event) {
   case NetworkEvents::UpdateBullets:
     handleUpdateBullets(client);
     break;
+  case NetworkEvents::SnapshotAck:
+    handleSnapshotAck(client, frame.value, frame.delay_us);
+    break;
   case NetworkEvents::NewGameSoon:
     // Not received by server
     invalid_network_event(client, event);
@@ -944,46 +1556,160 @@ void Server::handle_network_event(Client &client, uint32_t event) {
 }
 
 void Server::disconnect_client(Client &client) {
-  if (client.epd > 0) {
-    close(client.epd);
-  }
   if (client.fd_main > 2) {
     // No info for client
-    {
-      try {
-        {
-          auto &g = games.at(client.room_id);
-          // std::lock_guard<std::mutex> lr(g.gameRoomMutex);
-          handleLeaveRoom(client, false);
-
-          auto i =
-              std::remove(g.clients.begin(), g.clients.end(), client.client_id);
-          g.clients.erase(i, g.clients.end());
-        }
-        {
-          std::lock_guard<std::mutex> lc(clients_mutex);
-          todos.erase(client.client_id);
-          clients.erase(client.client_id);
-        }
-      } catch (const std::out_of_range &ex) {
-      }
+    try {
+      auto &g = get_room(client.room_id);
+      // std::lock_guard<std::mutex> lr(g.gameRoomMutex);
+      handleLeaveRoom(client, false);
+
+      auto i =
+          std::remove(g.clients.begin(), g.clients.end(), client.client_id);
+      g.clients.erase(i, g.clients.end());
+    } catch (const std::out_of_range &ex) {
     }
 
+    // Client entry itself is released by its worker
     shutdown(client.fd_main, SHUT_RDWR);
     close(client.fd_main);
     client.fd_main = -1;
   }
 }
 
+GameRoom &Server::get_room(uint32_t room_id) {
+  std::lock_guard<std::mutex> gml(games_mutex);
+  return games.at(room_id);
+}
+
 std::map<uint32_t, Room> Server::get_available_rooms() {
   std::map<uint32_t, Room> rs;
-  for (const auto &game : this->games) {
+  std::lock_guard<std::mutex> gml(games_mutex);
+  bool any_room_open = false;
+  for (auto &game : this->games) {
+    std::lock_guard<std::mutex> grl(game.second.gameRoomMutex);
     const auto &r = game.second.room;
     rs[r.room_id] = r;
+    any_room_open |= r.status == GameStatus::LOBBY &&
+                     get_X_players(r.players, PlayerInfo::NONE) > 0;
+  }
+  // All rooms are full, open a new one
+  if (!any_room_open && games.size() < config.max_rooms) {
+    auto &r = create_room().room;
+    rs[r.room_id] = r;
   }
   return rs;
 }
 
+// Called with games_mutex held
+GameRoom &Server::create_room() {
+  uint32_t game_id = _next_game_id++;
+
+  // Reuse a previously allocated room if possible
+  if (room_pool.empty()) {
+    games[game_id];
+  } else {
+    auto node = std::move(room_pool.back());
+    room_pool.pop_back();
+    node.key() = game_id;
+    games.insert(std::move(node));
+  }
+
+  GameRoom &gr = games.at(game_id);
+  std::lock_guard<std::mutex> grl(gr.gameRoomMutex);
+  const auto names_count = std::size(Constants::COOL_ROOM_NAMES);
+  std::string name = Constants::COOL_ROOM_NAMES[(game_id - 1) % names_count];
+  if (game_id > names_count)
+    name += " " + std::to_string((game_id - 1) / names_count + 1);
+  RoomType type =
+      config.room_types[(game_id - 1) % config.room_types.size()];
+  size_t players = WithRoomConfig(
+      type, [](auto room) { return decltype(room)::PLAYERS; });
+  gr.room = Room{game_id, std::vector<PlayerIdState>(players),
+                 GameStatus::LOBBY, name, type,
+                 config.tick_rate, config.deterministic};
+  for (uint32_t j = 0; j < players; j++) {
+    gr.room.players.at(j).player_id = j;
+  }
+  gr.gameManager.type = type;
+  gr.gameManager.tick_rate = gr.room.tick_rate;
+  gr.gameManager.fixed_tick_rate =
+      gr.room.deterministic ? gr.room.tick_rate : 0;
+  gr.gameManager.room_id = game_id;
+  gr.gameManager.NewGame(gr.room.players);
+  if (gr.snapshots.front().type != type)
+    gr.snapshots.assign(Constants::SNAPSHOT_HISTORY, Snapshot(type));
+  gr.clients.clear();
+  gr.snapshot_acks.clear();
+  gr.format_clients = {};
+  gr.round_is_running = false;
+  gr.tick_overruns = 0;
+  gr.scheduler = TickScheduler(config.tick_rate);
+  gr.hit_history = HitHistory(config.tick_rate);
+  gr.player_rtt = {};
+  gr.player_delay = {};
+  gr.tick_events.clear();
+  gr.empty_since = steady_clock::now();
+
+  TraceLog(LOG_INFO, "Created %s room %lu (%lu rooms, %lu pooled)",
+           room_type_name(type), game_id, games.size(), room_pool.size());
+  return gr;
+}
+
+// Reclaims rooms that stayed empty for the grace period
+void Server::manage_rooms() {
+  {
+    auto now = steady_clock::now();
+    std::lock_guard<std::mutex> gml(games_mutex);
+    for (auto i = games.begin();
+         i != games.end() && games.size() > config.min_rooms;) {
+      GameRoom &gr = i->second;
+      {
+        std::lock_guard<std::mutex> grl(gr.gameRoomMutex);
+        if (!gr.clients.empty() || gr.round_is_running) {
+          gr.empty_since = now;
+        }
+        if (now - gr.empty_since < config.room_grace_period) {
+          i++;
+          continue;
+        }
+      }
+      uint32_t room_id = i->first;
+      i++;
+      room_pool.push_back(games.extract(room_id));
+      TraceLog(LOG_INFO, "Reclaimed room %lu (%lu rooms, %lu pooled)",
+               room_id, games.size(), room_pool.size());
+    }
+  }
+  room_executor.submit_at(steady_clock::now() + 1s,
+                          [this]() { manage_rooms(); });
+}
+
+size_t room_memory_usage(const GameRoom &gr) {
+  const auto &gm = gr.gameManager;
+  const auto &ev = gr.tick_events;
+  // map node: value plus red-black tree header
+  size_t bytes = sizeof(std::pair<const uint32_t, GameRoom>) + 32;
+  bytes += gr.room.players.capacity() * sizeof(PlayerIdState);
+  bytes += gr.room.name.capacity();
+  bytes += gm.asteroids.heap_bytes();
+  bytes += gm.players.capacity() * sizeof(Player);
+  bytes += gm.bullets.heap_bytes();
+  bytes += gm.asteroid_pool.heap_bytes();
+  for (auto &pool : gm.bullet_pools)
+    bytes += sizeof(pool) + pool.heap_bytes();
+  bytes += gr.clients.capacity() * sizeof(uint32_t);
+  for (auto &snapshot : gr.snapshots)
+    bytes += sizeof(snapshot) + snapshot.words.capacity() * sizeof(uint32_t);
+  bytes += gr.snapshot_times.capacity() * sizeof(steady_clock::time_point);
+  bytes += gr.hit_history.heap_bytes();
+  bytes += (ev.destroyed_asteroids.capacity() +
+            ev.spawned_asteroids.capacity() +
+            ev.destroyed_players_ids.capacity() +
+            ev.destroyed_bullets_ids.capacity()) *
+           sizeof(uint32_t);
+  return bytes;
+}
+
 uint32_t Server::get_next_available_player_id(GameRoom &gr) {
   uint32_t player_id = 0;
   for (PlayerIdState &player : gr.room.players) {
@@ -998,67 +1724,29 @@ uint32_t Server::get_next_available_player_id(GameRoom &gr) {
   return -1;
 }
 
-void Server::handleBulletDestroyed(Client &client, uint32_t bullet_id) {
-  serverSetEvent(client, NetworkEvents::BulletDestroyed);
-  bool status = write_uint32(client.fd_main, bullet_id);
-  if (!status) {
-    TraceLog(
-        LOG_WARNING,
-        "Couldn't write NetworkEvent BulletDestroyed to client_id=%ld,fd=%d",
-        client.client_id, client.fd_main);
-    disconnect_client(client);
-    return;
-  }
-  TraceLog(LOG_DEBUG,
-           "sent NetworkEvent BulletDestroyed to client_id=%ld,fd=%d",
-           client.client_id, client.fd_main);
+void Server::encodeBulletDestroyed(std::vector<uint8_t> &out,
+                                   uint32_t bullet_id) {
+  write_uint32(out, NetworkEvents::BulletDestroyed);
+  write_uint32(out, bullet_id);
 }
 
-void Server::handlePlayerDestroyed(Client &client, uint32_t player_id) {
-  serverSetEvent(client, NetworkEvents::PlayerDestroyed);
-  bool status = write_uint32(client.fd_main, player_id);
-  if (!status) {
-    TraceLog(
-        LOG_WARNING,
-        "Couldn't write NetworkEvent PlayerDestroyed to client_id=%ld,fd=%d",
-        client.client_id, client.fd_main);
-    disconnect_client(client);
-    return;
-  }
-  TraceLog(LOG_DEBUG,
-           "sent NetworkEvent PlayerDestroyed to client_id=%ld,fd=%d",
-           client.client_id, client.fd_main);
+void Server::encodePlayerDestroyed(std::vector<uint8_t> &out,
+                                   uint32_t player_id) {
+  write_uint32(out, NetworkEvents::PlayerDestroyed);
+  write_uint32(out, player_id);
 }
 
-void Server::handleSpawnAsteroid(Client &client, Asteroid a, uint32_t id) {
-  serverSetEvent(client, NetworkEvents::SpawnAsteroid);
-  bool status = write_uint32(client.fd_main, id);
-  if (!status) {
-    TraceLog(LOG_WARNING,
-             "Couldn't write NetworkEvent SpawnAsteroid to client_id=%ld,fd=%d",
-             client.client_id, client.fd_main);
-    disconnect_client(client);
-    return;
-  }
-  json j = a;
-  status = write_json(client.fd_main, j);
-  if (!status) {
-    TraceLog(LOG_WARNING,
-             "Couldn't write spawned asteroid to client_id=%ld,fd=%d",
-             client.client_id, client.fd_main);
-    disconnect_client(client);
-    return;
+void Server::encodeSpawnAsteroid(std::vector<uint8_t> &out, const Asteroid &a,
+                                 uint32_t id, WireFormat format) {
+  write_uint32(out, NetworkEvents::SpawnAsteroid);
+  write_uint32(out, id);
+  if (!write_value(out, a, format)) {
+    TraceLog(LOG_WARNING, "Couldn't encode spawned asteroid %lu", id);
   }
 }
-void Server::handleAsteroidDestroyed(Client &client, uint32_t asteroid_id) {
-  serverSetEvent(client, NetworkEvents::AsteroidDestroyed);
-  bool status = write_uint32(client.fd_main, asteroid_id);
-  if (!status) {
-    TraceLog(
-        LOG_WARNING,
-        "Couldn't write NetworkEvent AsteroidDestroyed to client_id=%ld,fd=%d",
-        client.client_id, client.fd_main);
-    disconnect_client(client);
-    return;
-  }
+
+void Server::encodeAsteroidDestroyed(std::vector<uint8_t> &out,
+                                     uint32_t asteroid_id) {
+  write_uint32(out, NetworkEvents::AsteroidDestroyed);
+  write_uint32(out, asteroid_id);
 }
@@ -4,76 +4,260 @@
 #include <sys/epoll.h>
 #include <sys/types.h>
 
+#include <array>
 #include <atomic>
 #include <cstdint>
 #include <functional>
+#include <memory>
 #include <mutex>
+#include <random>
 #include <thread>
 #include <vector>
 
 #include "client.hpp"
+#include "binaryCodec.hpp"
+#include "datagram.hpp"
 #include "gameManager.hpp"
-#include "lockingQueue.hpp"
+#include "hitHistory.hpp"
+#include "inputQueue.hpp"
+#include "ioUring.hpp"
+#include "mpscQueue.hpp"
 #include "networkEvents.hpp"
 #include "room.hpp"
+#include "serverConfig.hpp"
+#include "snapshot.hpp"
+#include "tickScheduler.hpp"
+#include "workStealingPool.hpp"
+
+// Entities changed by a single simulation tick
+struct TickEvents {
+  std::vector<uint32_t> destroyed_asteroids;
+  std::vector<uint32_t> spawned_asteroids;
+  std::vector<uint32_t> destroyed_players_ids;
+  std::vector<uint32_t> destroyed_bullets_ids;
+
+  void clear() {
+    destroyed_asteroids.clear();
+    spawned_asteroids.clear();
+    destroyed_players_ids.clear();
+    destroyed_bullets_ids.clear();
+  }
+};
 
 struct GameRoom {
   Room room;
   GameManager gameManager;
   std::vector<uint32_t> clients;
   std::mutex gameRoomMutex;
-  std::atomic_bool thread_is_running = false;
+  std::atomic_bool round_is_running = false;
+  std::atomic_uint64_t tick_overruns = 0;
+  TickScheduler scheduler;
+  TickEvents tick_events;
+  // Input of every player, consumed by the ticks
+  std::array<InputQueue, Constants::PLAYERS_MAX> inputs;
+  time_point<steady_clock> empty_since;
+
+  // Recent snapshots by id % SNAPSHOT_HISTORY and the last one acknowledged
+  // by each client receiving them (0 before the first)
+  std::vector<Snapshot> snapshots =
+      std::vector<Snapshot>(Constants::SNAPSHOT_HISTORY);
+  uint32_t snapshot_id = 0;
+  std::map<uint32_t, uint32_t> snapshot_acks;
+  uint64_t snapshots_sent = 0;
+  uint64_t snapshot_bytes = 0;
+  std::vector<steady_clock::time_point> snapshot_times =
+      std::vector<steady_clock::time_point>(Constants::SNAPSHOT_HISTORY);
+
+  // Lag compensation: round trip of every player, smoothed from how long
+  // its snapshots took to be acknowledged (0 while unknown), the delay its
+  // client draws the others with, and the players' recent positions to
+  // rewind to
+  std::array<duration<double>, Constants::PLAYERS_MAX> player_rtt{};
+  std::array<duration<double>, Constants::PLAYERS_MAX> player_delay{};
+  HitHistory hit_history;
+  duration<double> max_rewind{0}; // Of the round
+
+  // Joined clients by wire format, shared messages are only encoded in the
+  // formats someone uses
+  std::array<uint32_t, WIRE_FORMATS> format_clients{};
+  bool uses(WireFormat format) const {
+    return format_clients[(size_t)format] > 0;
+  }
+};
+
+// Approximate heap and map node footprint of a room
+size_t room_memory_usage(const GameRoom &gr);
+
+// Decoded client message, payload fields are set depending on the event
+struct Frame {
+  uint32_t event = NetworkEvents::NoEvent;
+  uint32_t value = 0;
+  uint32_t delay_us = 0; // Of a SnapshotAck
+  std::vector<InputState> inputs;
+};
+
+// Output counters of a worker, logged every NETWORK_STATS_INTERVAL
+struct NetworkStats {
+  time_point<steady_clock> since;
+  uint64_t flushes = 0;
+  uint64_t syscalls = 0;
+  uint64_t bytes = 0;
+  uint64_t accepted = 0;
+  uint64_t max_queued = 0; // Deepest output queue after a flush
+  uint64_t dropped_updates = 0;
+  uint64_t slow_disconnects = 0;
+  uint64_t datagrams_sent = 0;
+  uint64_t datagrams_received = 0;
+  uint64_t stale_datagrams = 0; // Discarded as out of order
+  uint64_t shim_dropped = 0;
+  // Microseconds from encoding a tick broadcast until it reached the kernel
+  std::vector<uint32_t> broadcast_latency;
+
+  uint32_t latency_percentile(double q);
+};
+
+// Datagram queued during a worker cycle, the payload is shared with the
+// other recipients
+struct OutgoingDatagram {
+  sockaddr_in addr;
+  uint8_t header[DatagramHeader::SIZE];
+  SharedBytes payload;
+};
+
+// Reactor thread multiplexing many client connections over one epoll set
+struct Worker {
+  uint32_t worker_id = 0;
+  int epoll_fd = -1;
+  int listen_fd = -1; // SO_REUSEPORT listener, only on acceptor workers
+  std::thread thread;
+  std::unique_ptr<IoUring> ring; // Set when using the io_uring backend
+
+  // Sockets accepted by other workers, waiting to be added to epoll
+  MpscQueue<int> new_connections;
+
+  // Client sockets and todo queue eventfds -> client_id (0 until handshake)
+  std::map<int, uint32_t> clients_by_fd;
+  // Bytes received from connections still waiting for their handshake
+  std::map<int, InputBuffer> pending_input;
+  time_point<steady_clock> last_connection_check;
+
+  // Clients with output queued during the current epoll cycle
+  std::vector<uint32_t> pending_flush;
+  // Sent with sendmmsg at the end of the cycle, the shim holds some back for
+  // the next one
+  std::vector<OutgoingDatagram> pending_datagrams;
+  std::vector<OutgoingDatagram> held_datagrams;
+  std::mt19937 shim_rng;
+  NetworkStats stats;
 };
 
 struct Server {
-  int mainfd;
+  ServerConfig config;
 
-  std::thread connection_thread;
+  std::map<uint32_t, Worker> workers;
+  std::atomic_uint32_t _next_worker_id = 0;
+  int udp_fd = -1; // Shared by all workers, received by the first one
 
   std::atomic_bool _stop = false;
 
   std::mutex games_mutex;
   std::map<uint32_t, GameRoom> games;
   std::atomic_uint32_t _next_game_id = 1;
+  // Seeds of the rounds, the first one is random
+  std::atomic_uint32_t _next_seed = 0;
+  // Reclaimed rooms ready to be reused, guarded by games_mutex
+  std::vector<std::map<uint32_t, GameRoom>::node_type> room_pool;
 
   std::mutex clients_mutex;
   std::map<uint32_t, Client> clients;
   std::atomic_uint32_t _next_client_id = 1;
 
-  std::map<uint32_t, LockingQueue<std::function<void(Client c)>>> todos;
+  std::map<uint32_t, MpscQueue<std::function<void(Client &c)>>> todos;
+
+  // Runs room countdowns and simulation ticks
+  WorkStealingPool room_executor;
 
-  Server(in_port_t main_port);
+  Server(const ServerConfig &config);
   ~Server();
 
-  void listen_for_connections();
+  int open_listener();
+  void accept_connections(Worker &worker);
+  int open_udp_socket();
+  void receive_datagrams(Worker &worker);
+  void handle_datagram(Client &client, const DatagramHeader &header,
+                       const sockaddr_in &from, InputBuffer &in);
+  void send_unreliable(Client &client, uint32_t event, uint32_t id,
+                       SharedBytes bytes);
+  void flush_datagrams(Worker &worker);
+  void run_worker(Worker &worker);
+  void run_uring_worker(Worker &worker);
+  void handle_completion(Worker &worker, const io_uring_cqe &cqe);
+  void watch_handshake(Worker &worker, int fd);
+  void watch_client_uring(Worker &worker, Client &client);
+  void unwatch_client_uring(Worker &worker, Client &client);
+  bool submit_send(Worker &worker, Client &client);
+  void add_connection(Worker &worker, int client_fd);
+  void handle_worker_event(Worker &worker, const epoll_event &event);
+  void handle_handshake(Worker &worker, int fd, uint32_t events);
+  void check_connections(Worker &worker);
+  void release_client(Worker &worker, Client &client);
+  static ReadStatus decode_frame(InputCursor &cursor, Frame &frame,
+                                 WireFormat format);
+  void process_frames(Client &client);
+  void schedule_flush(Worker &worker, Client &client);
+  void flush_clients(Worker &worker);
+  bool flush_client(Worker &worker, Client &client);
+  bool take_superseded(Client &client);
+  void output_drained(Worker &worker, Client &client);
+  void send_latest(Client &client, uint32_t event, uint32_t id,
+                   SharedBytes bytes);
+  bool within_output_budget(Client &client, steady_clock::time_point now);
+  GameRoom &get_room(uint32_t room_id);
+  GameRoom &create_room();
+  void manage_rooms();
   std::map<uint32_t, Room> get_available_rooms();
   uint32_t get_next_available_player_id(GameRoom &gr);
   void new_game(uint32_t room_id);
+  void begin_round(uint32_t room_id);
+  void tick_room(uint32_t room_id);
+  void rewind_players(GameRoom &gr);
+  void step_players(GameRoom &gr, duration<double> frametime);
+  void relay_movement(GameRoom &gr, uint32_t player_id);
+  void shoot_bullet(GameRoom &gr, uint32_t player_id);
+  void end_round(GameRoom &gr);
+  void send_snapshots(GameRoom &gr);
   void restart_timer(GameRoom &gr, std::vector<uint32_t> &last_clients);
 
-  void handle_connection(int client_fd);
-  void handle_network_event(Client &client, uint32_t networkEvent);
+  void handle_network_event(Client &client, Frame &frame);
   void disconnect_client(Client &client);
   bool serverSetEvent(Client &client, NetworkEvents event);
   void invalid_network_event(Client &client, uint32_t event);
 
   // NetworkEvents handlers
-  uint32_t handleGetClientId(int client_fd);
+  uint32_t handleGetClientId(int client_fd, const Frame &frame);
   void handleGetRoomList(Client &client);
   void handleVoteReady(Client &client);
-  void handlePlayerMovement(Client &client);
+  void handlePlayerInput(Client &client,
+                         const std::vector<InputState> &inputs);
   void handleShootBullet(Client &client);
-  void handleJoinRoom(Client &client);
+  void handleJoinRoom(Client &client, uint32_t read_room_id);
   void handleLeaveRoom(Client &client, bool send_confirmation);
   void handleUpdateGameState(Client &client);
   void handleUpdateRoomState(Client &client);
   void handleUpdatePlayers(Client &client);
   void handleUpdateAsteroids(Client &client);
   void handleUpdateBullets(Client &client);
-  void handleBulletDestroyed(Client &client, uint32_t bullet_id);
-  void handlePlayerDestroyed(Client &c1, uint32_t player_id);
-  void handleSpawnAsteroid(Client &client, Asteroid a, uint32_t id);
-  void handleAsteroidDestroyed(Client &client, uint32_t asteroid_id);
+  void handleSnapshotAck(Client &client, uint32_t snapshot_id,
+                         uint32_t delay_us);
+  // Room broadcasts, encoded once per tick
+  static void encodeBulletDestroyed(std::vector<uint8_t> &out,
+                                    uint32_t bullet_id);
+  static void encodePlayerDestroyed(std::vector<uint8_t> &out,
+                                    uint32_t player_id);
+  static void encodeSpawnAsteroid(std::vector<uint8_t> &out, const Asteroid &a,
+                                  uint32_t id, WireFormat format);
+  static void encodeAsteroidDestroyed(std::vector<uint8_t> &out,
+                                      uint32_t asteroid_id);
   bool sendCheckConnection(Client &client);
   bool sendUpdateRoomState(Client &client);
   void sendNewGameSoon(Client &client, uint32_t when);
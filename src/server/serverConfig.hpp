@@ -0,0 +1,73 @@
+#pragma once
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "roomConfig.hpp"
+
+using namespace std::chrono;
+
+enum class IoBackend { Epoll, IoUring };
+
+struct ServerConfig {
+  in_port_t port = 0;
+
+  // Number of reactor threads serving client connections
+  // (defaults to the number of cores, at least 1)
+  unsigned int workers = std::max(1u, std::thread::hardware_concurrency());
+
+  // Workers with their own SO_REUSEPORT listening socket (0 means all of
+  // them) and the listen() backlog of each
+  unsigned int acceptors = 0;
+  int backlog = SOMAXCONN;
+
+  // io_uring falls back to epoll when the kernel doesn't support it
+  IoBackend io_backend = IoBackend::Epoll;
+
+  // Room simulation ticks per second
+  unsigned int tick_rate = 60;
+
+  // WorldSnapshot deltas per second sent to clients asking for them
+  // (capped by the tick rate)
+  unsigned int snapshot_rate = 20;
+
+  // Binary payloads offered in the handshake, JSON is kept for debugging.
+  // Quantized ones additionally shrink positions, velocities and angles.
+  bool binary = true;
+  bool quantize = true;
+
+  // Number of threads shared by all room simulations
+  unsigned int room_threads =
+      std::max(1u, std::thread::hardware_concurrency());
+
+  // Rooms are created on demand when all of them are full, and reclaimed
+  // after staying empty for the grace period
+  unsigned int min_rooms = 4;
+  unsigned int max_rooms = 64;
+  unsigned int prewarmed_rooms = 4;
+  seconds room_grace_period = 30s;
+  // Types of the rooms in the order they are created, repeated
+  std::vector<RoomType> room_types = {RoomType::Classic};
+  // Rounds are stepped in fixed point from a seed sent to the clients, so
+  // they simulate the same bits as the server
+  bool deterministic = false;
+
+  // Socket options of client connections, TCP_CORK is toggled around every
+  // flush when enabled
+  bool tcp_nodelay = true;
+  bool tcp_cork = false;
+
+  // UDP side channel offered in the handshake for movement updates. The shim
+  // drops and reorders that percentage of datagrams, like netem on loopback.
+  bool udp = true;
+  double udp_loss = 0;
+  double udp_reorder = 0;
+
+  // Output budget of a client, slower clients are disconnected
+  size_t max_output_bytes = 1024 * 1024;
+  milliseconds max_output_delay{3000};
+};
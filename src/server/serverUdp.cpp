@@ -0,0 +1,220 @@
+#include "server.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <raylib.h>
+
+#include "client.hpp"
+#include "datagram.hpp"
+#include "jsonutils.hpp"
+#include "networkUtils.hpp"
+
+// UDP side channel. Movement updates are latest-wins, so a lost datagram is
+// simply replaced by the next one instead of stalling the TCP stream behind
+// a retransmission. Control events always stay on TCP.
+
+const static unsigned DATAGRAM_BATCH = 64;
+const static int DATAGRAM_SOCKET_BUFFER = 4 * 1024 * 1024;
+
+// Percentage chance of the shim acting on a datagram
+static bool shim_hit(Worker &worker, double percent) {
+  if (percent <= 0)
+    return false;
+  return std::uniform_real_distribution<double>(0, 100)(worker.shim_rng) <
+         percent;
+}
+
+int Server::open_udp_socket() {
+  int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd == -1) {
+    TraceLog(LOG_WARNING, "Couldn't create UDP socket: %s", strerror(errno));
+    return -1;
+  }
+  setReuseAddr(fd);
+  // A single socket receives the movement of every client, absorb bursts
+  // (capped by net.core.rmem_max)
+  const int size = DATAGRAM_SOCKET_BUFFER;
+  setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+
+  sockaddr_in serverAddr{};
+  serverAddr.sin_family = AF_INET;
+  serverAddr.sin_port = htons((short)config.port);
+  serverAddr.sin_addr = {INADDR_ANY};
+  if (bind(fd, (sockaddr *)&serverAddr, sizeof(serverAddr))) {
+    TraceLog(LOG_WARNING, "Couldn't bind UDP port %u: %s", config.port,
+             strerror(errno));
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+// Hands every datagram to the worker owning its client, one recvmmsg batch
+// per wakeup
+void Server::receive_datagrams(Worker &worker) {
+  uint8_t buffers[DATAGRAM_BATCH][DATAGRAM_MAX_SIZE];
+  iovec iov[DATAGRAM_BATCH];
+  sockaddr_in addrs[DATAGRAM_BATCH];
+  mmsghdr msgs[DATAGRAM_BATCH];
+  for (unsigned i = 0; i < DATAGRAM_BATCH; i++) {
+    iov[i] = {buffers[i], DATAGRAM_MAX_SIZE};
+    msgs[i] = mmsghdr{};
+    msgs[i].msg_hdr.msg_name = &addrs[i];
+    msgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+    msgs[i].msg_hdr.msg_iov = &iov[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  int n = recvmmsg(udp_fd, msgs, DATAGRAM_BATCH, MSG_DONTWAIT, nullptr);
+  worker.stats.syscalls++;
+  for (int i = 0; i < n; i++) {
+    if (msgs[i].msg_hdr.msg_flags & MSG_TRUNC)
+      continue;
+    if (shim_hit(worker, config.udp_loss)) {
+      worker.stats.shim_dropped++;
+      continue;
+    }
+
+    InputBuffer in;
+    in.append(buffers[i], msgs[i].msg_len);
+    InputCursor cursor(in);
+    DatagramHeader header;
+    if (read_datagram_header(cursor, header) != ReadStatus::Ok)
+      continue;
+    cursor.commit();
+
+    std::lock_guard<std::mutex> lg(clients_mutex);
+    auto c = clients.find(header.client_id);
+    if (c == clients.end() || c->second.udp_token == 0 ||
+        c->second.udp_token != header.token)
+      continue;
+    worker.stats.datagrams_received++;
+    sockaddr_in from = addrs[i];
+    todos.at(header.client_id)
+        .push([this, header, from, in](Client &c1) mutable {
+          handle_datagram(c1, header, from, in);
+        });
+  }
+}
+
+// Runs on the client's worker. Also learns the address to reply to, which
+// may change behind a NAT.
+void Server::handle_datagram(Client &client, const DatagramHeader &header,
+                             const sockaddr_in &from, InputBuffer &in) {
+  if (client.fd_main == -1)
+    return;
+  if (client.udp_received &&
+      !sequence_newer(header.sequence, client.udp_in_sequence)) {
+    workers.at(client.worker_id).stats.stale_datagrams++;
+    return;
+  }
+  client.udp_received = true;
+  client.udp_in_sequence = header.sequence;
+  client.udp_addr = from;
+
+  InputCursor cursor(in);
+  Frame frame;
+  if (decode_frame(cursor, frame, client.format) != ReadStatus::Ok) {
+    TraceLog(LOG_WARNING, "Couldn't decode datagram from client_id=%ld,fd=%d",
+             client.client_id, client.fd_main);
+    return;
+  }
+  switch ((NetworkEvents)frame.event) {
+  case NetworkEvents::NoEvent:
+    // Only announces the client's address
+    break;
+  case NetworkEvents::PlayerInput:
+    handlePlayerInput(client, frame.inputs);
+    break;
+  case NetworkEvents::SnapshotAck:
+    handleSnapshotAck(client, frame.value, frame.delay_us);
+    break;
+  default:
+    TraceLog(LOG_WARNING, "%s can't be sent over UDP by client_id=%ld,fd=%d",
+             network_event_to_string(frame.event).c_str(), client.client_id,
+             client.fd_main);
+    break;
+  }
+}
+
+// Latest-wins update, over UDP once the client's address is known and over
+// TCP otherwise
+void Server::send_unreliable(Client &client, uint32_t event, uint32_t id,
+                             SharedBytes bytes) {
+  if (!client.udp_received ||
+      DatagramHeader::SIZE + bytes->size() > DATAGRAM_MAX_SIZE) {
+    send_latest(client, event, id, std::move(bytes));
+    return;
+  }
+  std::vector<uint8_t> header;
+  write_datagram_header(header,
+                        {0, client.udp_token, ++client.udp_out_sequence});
+
+  OutgoingDatagram datagram;
+  datagram.addr = client.udp_addr;
+  memcpy(datagram.header, header.data(), sizeof(datagram.header));
+  datagram.payload = std::move(bytes);
+  workers.at(client.worker_id).pending_datagrams.push_back(std::move(datagram));
+}
+
+// Sends the datagrams of this cycle with as few sendmmsg calls as possible.
+// Nothing is retried, a full socket buffer loses datagrams like the network.
+void Server::flush_datagrams(Worker &worker) {
+  if (worker.pending_datagrams.empty() && worker.held_datagrams.empty())
+    return;
+
+  std::vector<OutgoingDatagram> sending, held;
+  for (auto &datagram : worker.pending_datagrams) {
+    if (shim_hit(worker, config.udp_loss)) {
+      worker.stats.shim_dropped++;
+    } else if (shim_hit(worker, config.udp_reorder)) {
+      held.push_back(std::move(datagram));
+    } else {
+      sending.push_back(std::move(datagram));
+    }
+  }
+  worker.pending_datagrams.clear();
+  // Held back by the shim until a newer datagram overtakes them
+  if (!sending.empty()) {
+    for (auto &datagram : worker.held_datagrams)
+      sending.push_back(std::move(datagram));
+    worker.held_datagrams.clear();
+  }
+  for (auto &datagram : held)
+    worker.held_datagrams.push_back(std::move(datagram));
+
+  iovec iov[DATAGRAM_BATCH][2];
+  mmsghdr msgs[DATAGRAM_BATCH];
+  for (size_t first = 0; first < sending.size(); first += DATAGRAM_BATCH) {
+    size_t n = std::min<size_t>(DATAGRAM_BATCH, sending.size() - first);
+    for (size_t i = 0; i < n; i++) {
+      auto &datagram = sending[first + i];
+      iov[i][0] = {datagram.header, sizeof(datagram.header)};
+      iov[i][1] = {(void *)datagram.payload->data(), datagram.payload->size()};
+      msgs[i] = mmsghdr{};
+      msgs[i].msg_hdr.msg_name = &datagram.addr;
+      msgs[i].msg_hdr.msg_namelen = sizeof(datagram.addr);
+      msgs[i].msg_hdr.msg_iov = iov[i];
+      msgs[i].msg_hdr.msg_iovlen = 2;
+    }
+    size_t done = 0;
+    while (done < n) {
+      int res = sendmmsg(udp_fd, msgs + done, n - done, MSG_DONTWAIT);
+      worker.stats.syscalls++;
+      if (res == -1 && errno == EINTR)
+        continue;
+      if (res == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        break;
+      if (res == -1) {
+        done++; // e.g. a pending ICMP error of one destination, skip it
+        continue;
+      }
+      done += res;
+      worker.stats.datagrams_sent += res;
+    }
+  }
+}
@@ -0,0 +1,203 @@
+#include "server.hpp"
+#include <cerrno>
+#include <poll.h>
+#include <sys/socket.h>
+
+#include <raylib.h>
+
+#include "client.hpp"
+#include "constants.hpp"
+#include "ioUring.hpp"
+
+// io_uring backend of the workers. Every wakeup is a completion: one-shot
+// polls for the listener, eventfds and handshakes, a multishot receive per
+// client and at most one sendmsg per client in flight. Everything prepared
+// during a cycle is submitted with the next wait, in a single syscall.
+
+enum UringOp : uint64_t {
+  OpListen = 1,
+  OpNewConnections,
+  OpDatagrams,
+  OpHandshake, // id is the pending fd
+  OpTodo,      // id is the client id from here on
+  OpRecv,
+  OpSend,
+};
+
+static uint64_t uring_data(UringOp op, uint64_t id) { return op << 56 | id; }
+
+const static size_t URING_SEND_IOV = 64;
+
+void Server::run_uring_worker(Worker &worker) {
+  IoUring &ring = *worker.ring;
+  worker.last_connection_check = steady_clock::now();
+
+  if (worker.listen_fd != -1)
+    ring.prep_poll(worker.listen_fd, POLLIN, uring_data(OpListen, 0));
+  ring.prep_poll(worker.new_connections.get_event_fd(), POLLIN,
+                 uring_data(OpNewConnections, 0));
+  if (worker.worker_id == 0 && udp_fd != -1)
+    ring.prep_poll(udp_fd, POLLIN, uring_data(OpDatagrams, 0));
+
+  while (!this->_stop) {
+    auto enters = ring.enters;
+    ring.submit_and_wait(
+        milliseconds(Constants::CONNECTION_CHECK_INTERVAL_MILISECONDS));
+    ring.for_each_cqe(
+        [&](const io_uring_cqe &cqe) { handle_completion(worker, cqe); });
+    check_connections(worker);
+    flush_clients(worker);
+    worker.stats.syscalls += ring.enters - enters;
+  }
+}
+
+void Server::watch_handshake(Worker &worker, int fd) {
+  worker.ring->prep_poll(fd, POLLIN | POLLRDHUP, uring_data(OpHandshake, fd));
+}
+
+void Server::watch_client_uring(Worker &worker, Client &client) {
+  worker.ring->prep_recv_multishot(client.fd_main,
+                                   uring_data(OpRecv, client.client_id));
+  worker.ring->prep_poll(client.todo_fd, POLLIN,
+                         uring_data(OpTodo, client.client_id));
+  client.todo_poll_armed = true;
+}
+
+void Server::unwatch_client_uring(Worker &worker, Client &client) {
+  // The receive ends with the socket shutdown, the todo eventfd is closed
+  // with its queue so its poll has to be removed
+  if (client.todo_poll_armed)
+    worker.ring->prep_poll_remove(uring_data(OpTodo, client.client_id));
+}
+
+bool Server::submit_send(Worker &worker, Client &client) {
+  if (client.send_in_flight) {
+    // Still sending the previous batch, updates are superseded meanwhile
+    if (!client.waiting_for_write) {
+      client.waiting_for_write = true;
+      client.write_blocked_since = steady_clock::now();
+    }
+    return true;
+  }
+  take_superseded(client);
+  if (client.out.empty())
+    return true;
+
+  client.send_iov.resize(URING_SEND_IOV);
+  client.send_msg = msghdr{};
+  client.send_msg.msg_iov = client.send_iov.data();
+  client.send_msg.msg_iovlen =
+      client.out.gather(client.send_iov.data(), URING_SEND_IOV);
+  worker.ring->prep_sendmsg(client.fd_main, &client.send_msg,
+                            uring_data(OpSend, client.client_id));
+  client.send_in_flight = true;
+  client.out.flushes++;
+  worker.stats.flushes++;
+  return true;
+}
+
+void Server::handle_completion(Worker &worker, const io_uring_cqe &cqe) {
+  auto op = (UringOp)(cqe.user_data >> 56);
+  uint64_t id = cqe.user_data & ((1ull << 56) - 1);
+
+  if (op == OpListen) {
+    accept_connections(worker);
+    worker.ring->prep_poll(worker.listen_fd, POLLIN, uring_data(OpListen, 0));
+    return;
+  }
+  if (op == OpNewConnections) {
+    worker.new_connections.drain([&](int client_fd) {
+      add_connection(worker, client_fd);
+      return true;
+    });
+    worker.ring->prep_poll(worker.new_connections.get_event_fd(), POLLIN,
+                           uring_data(OpNewConnections, 0));
+    return;
+  }
+  if (op == OpDatagrams) {
+    receive_datagrams(worker);
+    worker.ring->prep_poll(udp_fd, POLLIN, uring_data(OpDatagrams, 0));
+    return;
+  }
+  if (op == OpHandshake) {
+    int fd = id;
+    auto i = worker.clients_by_fd.find(fd);
+    if (i == worker.clients_by_fd.end() || i->second != 0)
+      return;
+    handle_handshake(worker, fd, cqe.res < 0 ? POLLERR : cqe.res);
+    i = worker.clients_by_fd.find(fd);
+    if (i != worker.clients_by_fd.end() && i->second == 0)
+      watch_handshake(worker, fd); // Handshake still incomplete
+    return;
+  }
+
+  bool has_buffer = cqe.flags & IORING_CQE_F_BUFFER;
+  uint16_t buffer_id = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+
+  Client *client_ptr = nullptr;
+  try {
+    std::lock_guard<std::mutex> lg(clients_mutex);
+    client_ptr = &clients.at(id);
+  } catch (const std::out_of_range &ex) {
+    // Completion of an already released client
+    if (has_buffer)
+      worker.ring->recycle_buffer(buffer_id);
+    return;
+  }
+  Client &client = *client_ptr;
+
+  if (op == OpRecv) {
+    if (client.fd_main != -1) {
+      client.last_activity = steady_clock::now();
+      if (cqe.res > 0) {
+        client.good_connection = true;
+        client.in.append(worker.ring->buffer(buffer_id), cqe.res);
+        process_frames(client);
+      } else if (cqe.res != -ENOBUFS) {
+        disconnect_client(client); // EOF or error
+      }
+      if (client.fd_main != -1 && !(cqe.flags & IORING_CQE_F_MORE)) {
+        // Out of buffers, receive again once they are recycled
+        worker.ring->prep_recv_multishot(client.fd_main,
+                                         uring_data(OpRecv, client.client_id));
+      }
+    }
+    if (has_buffer)
+      worker.ring->recycle_buffer(buffer_id);
+  } else if (op == OpTodo) {
+    client.todo_poll_armed = false;
+    if (client.fd_main != -1) {
+      // Run everything queued since the last wakeup
+      todos.at(client.client_id).drain([&](auto &f) {
+        f(client);
+        return client.fd_main != -1;
+      });
+    }
+    if (client.fd_main != -1) {
+      worker.ring->prep_poll(client.todo_fd, POLLIN,
+                             uring_data(OpTodo, client.client_id));
+      client.todo_poll_armed = true;
+    }
+  } else if (op == OpSend) {
+    client.send_in_flight = false;
+    if (cqe.res > 0) {
+      client.out.consume(cqe.res);
+      worker.stats.bytes += cqe.res;
+    } else if (cqe.res != -EAGAIN && cqe.res != -EINTR &&
+               client.fd_main != -1) {
+      TraceLog(LOG_WARNING, "Couldn't flush output to client_id=%ld,fd=%d",
+               client.client_id, client.fd_main);
+      disconnect_client(client);
+    }
+    if (client.out.empty()) {
+      client.waiting_for_write = false;
+      output_drained(worker, client);
+    }
+  }
+
+  if (client.fd_main == -1) {
+    release_client(worker, client);
+  } else {
+    schedule_flush(worker, client);
+  }
+}
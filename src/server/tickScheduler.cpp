@@ -0,0 +1,40 @@
+#include "tickScheduler.hpp"
+
+TickScheduler::TickScheduler(unsigned int tick_rate)
+    : period(duration_cast<steady_clock::duration>(duration<double>(1.0) /
+                                                    tick_rate)) {}
+
+duration<double> TickScheduler::frametime() const { return period; }
+
+void TickScheduler::start() {
+  ticks = 0;
+  overruns = 0;
+  latency_total = steady_clock::duration{0};
+  latency_max = steady_clock::duration{0};
+  next_tick = steady_clock::now();
+}
+
+void TickScheduler::tick_started(steady_clock::time_point now) {
+  auto latency = now > next_tick ? now - next_tick : steady_clock::duration{0};
+  latency_total += latency;
+  if (latency > latency_max)
+    latency_max = latency;
+}
+
+steady_clock::time_point TickScheduler::advance() {
+  ticks++;
+  next_tick += period;
+
+  auto now = steady_clock::now();
+  if (now >= next_tick) {
+    overruns++;
+    next_tick = now;
+  }
+  return next_tick;
+}
+
+duration<double, std::milli> TickScheduler::average_latency() const {
+  if (ticks == 0)
+    return duration<double, std::milli>{0};
+  return duration<double, std::milli>(latency_total) / ticks;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+
+using namespace std::chrono;
+
+// Fixed-rate tick clock, ticks are aligned to absolute deadlines so the rate
+// doesn't drift with the time spent simulating a tick
+struct TickScheduler {
+  steady_clock::duration period;
+  steady_clock::time_point next_tick;
+  uint64_t ticks = 0;
+  uint64_t overruns = 0;
+
+  // How late ticks started compared to their deadline
+  steady_clock::duration latency_total{0};
+  steady_clock::duration latency_max{0};
+
+  TickScheduler(unsigned int tick_rate = 60);
+
+  // Fixed simulation step matching the tick rate
+  duration<double> frametime() const;
+
+  void start();
+
+  // Records the start of the tick scheduled at next_tick
+  void tick_started(steady_clock::time_point now);
+
+  // Returns the deadline of the next tick, late ticks are counted as overruns
+  // and the schedule is realigned instead of trying to catch up
+  steady_clock::time_point advance();
+
+  duration<double, std::milli> average_latency() const;
+};
@@ -0,0 +1,157 @@
+#include "workStealingPool.hpp"
+#include <algorithm>
+#include <exception>
+#include <raylib.h>
+
+// Queue owned by the current pool thread, UINT32_MAX outside of the pool
+static thread_local uint32_t current_queue_id = UINT32_MAX;
+
+WorkStealingPool::WorkStealingPool(unsigned int thread_count) {
+  for (uint32_t i = 0; i < thread_count; i++) {
+    queues[i];
+  }
+  threads.reserve(thread_count);
+  for (uint32_t i = 0; i < thread_count; i++) {
+    threads.emplace_back(&WorkStealingPool::run, this, i);
+  }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+  _stop = true;
+  for (auto &[queue_id, queue] : queues) {
+    std::lock_guard<std::mutex> lg(queue.mutex);
+    queue.wakeup.notify_one();
+  }
+  for (auto &thread : threads) {
+    if (thread.joinable())
+      thread.join();
+  }
+}
+
+uint32_t WorkStealingPool::target_queue() {
+  // Keep work local to the submitting thread, others will steal if idle
+  return current_queue_id != UINT32_MAX ? current_queue_id
+                                        : _next_queue++ % queues.size();
+}
+
+void WorkStealingPool::push(uint32_t queue_id, Task task) {
+  auto &queue = queues.at(queue_id);
+  std::lock_guard<std::mutex> lg(queue.mutex);
+  // Counted before it can be popped
+  pending++;
+  queue.tasks.push_back(std::move(task));
+  if (queue.sleeping)
+    queue.wakeup.notify_one();
+}
+
+// One sleeping thread is enough to steal a new task
+void WorkStealingPool::wake_sleeping(uint32_t except_queue_id) {
+  for (auto &[queue_id, queue] : queues) {
+    if (queue_id == except_queue_id || !queue.sleeping)
+      continue;
+    std::lock_guard<std::mutex> lg(queue.mutex);
+    queue.wakeup.notify_one();
+    return;
+  }
+}
+
+void WorkStealingPool::submit(Task task) {
+  uint32_t queue_id = target_queue();
+  push(queue_id, std::move(task));
+  wake_sleeping(queue_id);
+}
+
+void WorkStealingPool::submit_at(steady_clock::time_point when, Task task) {
+  auto &queue = queues.at(target_queue());
+  std::lock_guard<std::mutex> lg(queue.mutex);
+  bool earliest = queue.timers.empty() || when < queue.timers.top().when;
+  queue.timers.push(TimedTask{when, queue.next_timer_order++,
+                              std::move(task)});
+  if (earliest && queue.sleeping)
+    queue.wakeup.notify_one();
+}
+
+void WorkStealingPool::release_due_timers(TaskQueue &queue,
+                                          steady_clock::time_point now) {
+  while (!queue.timers.empty() && queue.timers.top().when <= now) {
+    pending++;
+    queue.tasks.push_back(queue.timers.top().task);
+    queue.timers.pop();
+  }
+}
+
+steady_clock::time_point WorkStealingPool::next_deadline() {
+  auto deadline = steady_clock::time_point::max();
+  for (auto &[queue_id, queue] : queues) {
+    std::lock_guard<std::mutex> lg(queue.mutex);
+    if (!queue.timers.empty())
+      deadline = std::min(deadline, queue.timers.top().when);
+  }
+  return deadline;
+}
+
+bool WorkStealingPool::pop_or_steal(uint32_t queue_id, Task &task) {
+  auto now = steady_clock::now();
+  {
+    // Own queue is used as a LIFO stack
+    auto &queue = queues.at(queue_id);
+    std::lock_guard<std::mutex> lg(queue.mutex);
+    release_due_timers(queue, now);
+    if (!queue.tasks.empty()) {
+      task = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+      pending--;
+      return true;
+    }
+  }
+
+  // Steal the oldest task of another queue, the due timers of a busy thread
+  // included
+  for (uint32_t i = 1; i < queues.size(); i++) {
+    auto &queue = queues.at((queue_id + i) % queues.size());
+    std::lock_guard<std::mutex> lg(queue.mutex);
+    release_due_timers(queue, now);
+    if (!queue.tasks.empty()) {
+      task = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+      pending--;
+      return true;
+    }
+  }
+  return false;
+}
+
+void WorkStealingPool::run(uint32_t queue_id) {
+  current_queue_id = queue_id;
+  auto &own = queues.at(queue_id);
+  while (!_stop) {
+    Task task;
+    if (pop_or_steal(queue_id, task)) {
+      // A room throwing doesn't take the other rooms down with the thread
+      try {
+        task();
+      } catch (const std::exception &ex) {
+        TraceLog(LOG_ERROR, "Pool task failed: %s", ex.what());
+      } catch (...) {
+        TraceLog(LOG_ERROR, "Pool task failed");
+      }
+      continue;
+    }
+
+    auto deadline = next_deadline();
+    std::unique_lock<std::mutex> lock(own.mutex);
+    // Set before looking at pending, a submitter increments pending before
+    // looking at it, so one of them sees the other
+    own.sleeping = true;
+    if (!_stop && pending == 0 && own.tasks.empty() &&
+        (own.timers.empty() || own.timers.top().when > steady_clock::now())) {
+      if (!own.timers.empty())
+        deadline = std::min(deadline, own.timers.top().when);
+      if (deadline == steady_clock::time_point::max())
+        own.wakeup.wait(lock);
+      else
+        own.wakeup.wait_until(lock, deadline);
+    }
+    own.sleeping = false;
+  }
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono;
+
+// Fixed set of threads running short tasks (room ticks). Every thread owns a
+// deque, idle threads steal from the others. Tasks can also be delayed until
+// a deadline, which is how rooms keep their tick rate without sleeping
+// threads. Every thread also owns the heap of the deadlines submitted from
+// it, so rescheduling a room's tick only locks the thread's own queue.
+struct WorkStealingPool {
+  using Task = std::function<void()>;
+
+private:
+  struct TimedTask {
+    steady_clock::time_point when;
+    uint64_t order;
+    Task task;
+    bool operator>(const TimedTask &other) const {
+      return when != other.when ? when > other.when : order > other.order;
+    }
+  };
+
+  struct TaskQueue {
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    std::deque<Task> tasks;
+    std::priority_queue<TimedTask, std::vector<TimedTask>, std::greater<>>
+        timers;
+    uint64_t next_timer_order = 0;
+    // The owner waits on wakeup, set with mutex held
+    std::atomic_bool sleeping = false;
+  };
+
+  std::map<uint32_t, TaskQueue> queues;
+  std::vector<std::thread> threads;
+
+  std::atomic_bool _stop = false;
+  std::atomic_uint32_t _next_queue = 0;
+  // Tasks in the deques, not counting the delayed ones
+  std::atomic_size_t pending = 0;
+
+  void run(uint32_t queue_id);
+  bool pop_or_steal(uint32_t queue_id, Task &task);
+  void push(uint32_t queue_id, Task task);
+  void wake_sleeping(uint32_t except_queue_id);
+  // Called with the queue's mutex held
+  void release_due_timers(TaskQueue &queue, steady_clock::time_point now);
+  // Earliest deadline of all queues, time_point::max() without any
+  steady_clock::time_point next_deadline();
+  uint32_t target_queue();
+
+public:
+  WorkStealingPool(unsigned int thread_count);
+  ~WorkStealingPool();
+
+  void submit(Task task);
+  void submit_at(steady_clock::time_point when, Task task);
+
+  size_t size() const { return threads.size(); }
+};
@@ -0,0 +1,88 @@
+// Quantization error bounds and bit packing
+#include <catch2/catch.hpp>
+
+#include <cmath>
+
+#include "binaryCodec.hpp"
+#include "bitstream.hpp"
+
+namespace {
+
+// Distance on the circle for wrapping quantizations
+float error(const Quantization &q, float value) {
+  float e = std::fabs(q.dequantize(q.quantize(value)) - value);
+  if (q.wrap)
+    e = std::min(e, (q.max - q.min) - e);
+  return e;
+}
+
+// Largest error over a dense sweep of [min, max], both ends included
+float largest_error(const Quantization &q) {
+  const int SAMPLES = 1 << 20;
+  float largest = 0;
+  for (int i = 0; i <= SAMPLES; i++) {
+    float value = q.min + (q.max - q.min) * ((double)i / SAMPLES);
+    largest = std::max(largest, error(q, value));
+  }
+  return std::max(largest, error(q, q.max));
+}
+
+} // namespace
+
+TEST_CASE("Reconstruction stays within max_error up to the top of the range") {
+  auto [name, q] = GENERATE(
+      std::make_pair("position x", codec::POSITION.x),
+      std::make_pair("position y", codec::POSITION.y),
+      std::make_pair("velocity", codec::VELOCITY.x),
+      std::make_pair("angle", codec::ANGLE),
+      std::make_pair("angular velocity", codec::ANGULAR_VELOCITY),
+      std::make_pair("3 bits", Quantization{0, 1, 3}),
+      std::make_pair("3 bits wrapping", Quantization{0, 1, 3, true}));
+  INFO(name);
+
+  // Rounding of the float math, far below a step
+  const float slack = (q.max - q.min) * 1e-6f;
+  float largest = largest_error(q);
+  CHECK(largest <= q.max_error() + slack);
+  // The bound is reached, not just a loose upper limit
+  CHECK(largest >= q.max_error() * 0.99f);
+
+  // Ends of a clamped range come back exactly, outside values clamp to them
+  if (!q.wrap) {
+    CHECK(q.dequantize(q.quantize(q.min)) == q.min);
+    CHECK(q.dequantize(q.quantize(q.max)) == Approx(q.max));
+    CHECK(q.quantize(q.max + 100) == q.quantize(q.max));
+    CHECK(q.quantize(q.min - 100) == 0);
+  }
+  CHECK(q.quantize(NAN) == 0);
+  CHECK(q.quantize(q.max) < (1u << q.bits));
+}
+
+TEST_CASE("Angles wrap around") {
+  const Quantization &q = codec::ANGLE;
+  CHECK(q.quantize(360) == 0);
+  CHECK(q.quantize(-90) == q.quantize(270));
+  CHECK(q.quantize(725) == q.quantize(5));
+  CHECK(error(q, 359.99f) <= q.max_error());
+}
+
+TEST_CASE("Bits read back in the widths they were written") {
+  const unsigned widths[] = {1, 3, 32, 7, 12, 8, 32, 14, 5, 1, 32};
+  std::vector<uint8_t> bytes;
+  BitWriter writer(bytes);
+  uint32_t value = 0x9e3779b9;
+  for (unsigned bits : widths)
+    writer.write(value * bits, bits);
+  writer.flush();
+
+  BitReader reader(bytes.data(), bytes.data() + bytes.size());
+  for (unsigned bits : widths) {
+    uint32_t read;
+    REQUIRE(reader.read(read, bits));
+    uint32_t mask = bits == 32 ? ~0u : (1u << bits) - 1;
+    CHECK(read == ((value * bits) & mask));
+  }
+  CHECK(reader.finished());
+  uint32_t past;
+  CHECK_FALSE(reader.read(past, 8));
+}
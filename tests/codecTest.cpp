@@ -0,0 +1,268 @@
+// Round trips of the field-list codec in both binary layouts
+#include <catch2/catch.hpp>
+
+#include <cmath>
+#include <random>
+
+#include "binaryCodec.hpp"
+#include "fixedPoint.hpp"
+
+namespace {
+
+std::mt19937 rng(7);
+
+float uniform(float min, float max) {
+  return std::uniform_real_distribution<float>(min, max)(rng);
+}
+
+uint32_t uniform_bits(unsigned bits) {
+  return std::uniform_int_distribution<uint32_t>(0, (1u << bits) - 1)(rng);
+}
+
+Vector2 random_position() {
+  return {uniform(codec::POSITION.x.min, codec::POSITION.x.max),
+          uniform(codec::POSITION.y.min, codec::POSITION.y.max)};
+}
+
+Vector2 random_velocity() {
+  return {uniform(codec::VELOCITY.x.min, codec::VELOCITY.x.max),
+          uniform(codec::VELOCITY.y.min, codec::VELOCITY.y.max)};
+}
+
+// Every slot filled, some inactive, values in the quantized ranges
+GameManager random_game(RoomType type) {
+  GameManager gm;
+  gm.type = type;
+  gm.NewGame(std::vector<PlayerIdState>(Constants::PLAYERS_MAX));
+  gm.room_id = rng();
+  gm.winner_player_id = rng();
+  for (size_t i = 0; i < gm.asteroids.count(); i++)
+    gm.asteroids.set(i, Asteroid{i % 5 != 0, random_position(),
+                                 random_velocity(), uniform(0, 360),
+                                 uniform(-512, 512), (int)uniform_bits(7),
+                                 (int)uniform_bits(4)});
+  for (auto &p : gm.players) {
+    p.active = rng() % 2;
+    p.position = random_position();
+    p.velocity = random_velocity();
+    p.rotation = uniform(0, 360);
+    p.player_color = Color{(uint8_t)rng(), (uint8_t)rng(), (uint8_t)rng(),
+                           (uint8_t)rng()};
+  }
+  for (size_t k = 0; k < gm.bullets.count(); k++)
+    gm.bullets.set(k, Bullet{k % 3 == 0, random_position(), uniform(0, 360)});
+  return gm;
+}
+
+// What the quantized layout should reproduce: every quantized field
+// through its quantization, the rest as it was
+template <class T> T requantize(T v);
+
+template <class M> M requantize_field(const M &v, codec::NotQuantized) {
+  return requantize(v);
+}
+template <class M> M requantize_field(const M &v, codec::Bits) { return v; }
+inline float requantize_field(float v, const Quantization &q) {
+  return q.dequantize(q.quantize(v));
+}
+inline Vector2 requantize_field(Vector2 v, const codec::Quantization2 &q) {
+  return {requantize_field(v.x, q.x), requantize_field(v.y, q.y)};
+}
+
+template <class T> T requantize(T v) {
+  if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T> ||
+                std::is_same_v<T, std::string>) {
+    return v;
+  } else if constexpr (codec::is_vector<T>::value) {
+    for (auto &e : v)
+      e = requantize(e);
+    return v;
+  } else if constexpr (codec::is_slot_array<T>) {
+    for (size_t i = 0; i < v.count(); i++)
+      v.set(i, requantize(v.at(i)));
+    return v;
+  } else {
+    std::apply(
+        [&](auto... f) {
+          ((v.*(f.member) = requantize_field(v.*(f.member), f.quantization)),
+           ...);
+        },
+        codec::Fields<T>::list);
+    return v;
+  }
+}
+
+// Field by field, floats bit for bit
+template <class T> bool same(const T &a, const T &b) {
+  if constexpr (std::is_same_v<T, float>) {
+    return memcmp(&a, &b, sizeof(float)) == 0;
+  } else if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T> ||
+                       std::is_same_v<T, std::string>) {
+    return a == b;
+  } else if constexpr (codec::is_vector<T>::value) {
+    if (a.size() != b.size())
+      return false;
+    for (size_t i = 0; i < a.size(); i++) {
+      if (!same(a[i], b[i]))
+        return false;
+    }
+    return true;
+  } else if constexpr (codec::is_slot_array<T>) {
+    if (a.count() != b.count())
+      return false;
+    for (size_t i = 0; i < a.count(); i++) {
+      if (!same(a.at(i), b.at(i)))
+        return false;
+    }
+    return true;
+  } else {
+    return std::apply(
+        [&](auto... f) { return (same(a.*(f.member), b.*(f.member)) && ...); },
+        codec::Fields<T>::list);
+  }
+}
+
+// Payload of write_value, without its size prefix
+template <class T>
+std::vector<uint8_t> encode(const T &value, WireFormat format) {
+  std::vector<uint8_t> bytes;
+  REQUIRE(write_value(bytes, value, format));
+  REQUIRE(bytes.size() >= sizeof(uint32_t));
+  uint32_t size;
+  memcpy(&size, bytes.data(), sizeof(size));
+  REQUIRE(ntohl(size) == bytes.size() - sizeof(uint32_t));
+  bytes.erase(bytes.begin(), bytes.begin() + sizeof(uint32_t));
+  return bytes;
+}
+
+template <class T>
+bool decode(const std::vector<uint8_t> &bytes, T &value, WireFormat format) {
+  return codec::decode_payload(bytes.data(), bytes.data() + bytes.size(),
+                               value, format);
+}
+
+} // namespace
+
+TEST_CASE("Game states round trip") {
+  RoomType type = GENERATE(RoomType::Classic, RoomType::Duel, RoomType::Arena);
+  GameManager sent = random_game(type);
+
+  SECTION("binary is exact") {
+    GameManager received;
+    REQUIRE(decode(encode(sent, WireFormat::Binary), received,
+                   WireFormat::Binary));
+    CHECK(same(sent.asteroids, received.asteroids));
+    CHECK(same(sent.players, received.players));
+    CHECK(same(sent.bullets, received.bullets));
+    CHECK(sent.room_id == received.room_id);
+    CHECK(sent.winner_player_id == received.winner_player_id);
+  }
+
+  SECTION("quantized keeps what its quantizations do") {
+    GameManager expected = requantize(sent), received;
+    auto bytes = encode(sent, WireFormat::Quantized);
+    REQUIRE(decode(bytes, received, WireFormat::Quantized));
+    CHECK(same(expected.asteroids, received.asteroids));
+    CHECK(same(expected.players, received.players));
+    CHECK(same(expected.bullets, received.bullets));
+    CHECK(expected.room_id == received.room_id);
+    CHECK(bytes.size() < encode(sent, WireFormat::Binary).size());
+  }
+}
+
+TEST_CASE("Rooms round trip with their strings and player lists") {
+  WireFormat format = GENERATE(WireFormat::Binary, WireFormat::Quantized);
+  Room sent{7,
+            {{0, PlayerInfo::READY}, {3, PlayerInfo::NOT_READY}},
+            GameStatus::LOBBY,
+            "pokój zażółć",
+            RoomType::Arena,
+            30,
+            true,
+            0xdeadbeef};
+  Room received;
+  REQUIRE(decode(encode(sent, format), received, format));
+  CHECK(same(sent, received));
+
+  std::vector<Room> rooms{sent, Room{}, sent};
+  std::vector<Room> received_rooms;
+  REQUIRE(decode(encode(rooms, format), received_rooms, format));
+  CHECK(same(rooms, received_rooms));
+}
+
+TEST_CASE("Inputs and movements round trip") {
+  WireFormat format = GENERATE(WireFormat::Binary, WireFormat::Quantized);
+  std::vector<InputState> inputs;
+  for (uint32_t i = 0; i < 40; i++)
+    inputs.push_back(InputState{(uint32_t)rng(), uniform_bits(4)});
+  std::vector<InputState> received_inputs;
+  REQUIRE(decode(encode(inputs, format), received_inputs, format));
+  CHECK(same(inputs, received_inputs));
+
+  Movement movement{random_position(), random_velocity(), uniform(0, 360),
+                    false, (uint32_t)rng()};
+  Movement received;
+  REQUIRE(decode(encode(movement, format), received, format));
+  if (format == WireFormat::Binary)
+    CHECK(same(movement, received));
+  else
+    CHECK(same(requantize(movement), received));
+}
+
+TEST_CASE("Truncated or padded payloads are rejected") {
+  WireFormat format = GENERATE(WireFormat::Binary, WireFormat::Quantized);
+  GameManager sent = random_game(RoomType::Duel), received;
+  auto bytes = encode(sent, format);
+
+  for (size_t size : {(size_t)0, (size_t)3, bytes.size() / 2,
+                      bytes.size() - 1}) {
+    std::vector<uint8_t> truncated(bytes.begin(), bytes.begin() + size);
+    CHECK_FALSE(decode(truncated, received, format));
+  }
+  auto padded = bytes;
+  padded.push_back(0);
+  CHECK_FALSE(decode(padded, received, format));
+
+  // A count larger than the bits left can't allocate its elements
+  std::vector<uint8_t> huge_count = {0xff, 0xff, 0xff, 0x7f};
+  std::vector<Room> rooms;
+  CHECK_FALSE(decode(huge_count, rooms, format));
+}
+
+TEST_CASE("Deterministic rounds put quantized states back on the grid") {
+  auto on_grid = [](float v) {
+    return v * FIXED_ONE == std::rint(v * FIXED_ONE);
+  };
+  GameManager sent = random_game(RoomType::Arena), received;
+  auto bytes = encode(sent, WireFormat::Quantized);
+  REQUIRE(decode(bytes, received, WireFormat::Quantized));
+
+  // Untouched outside of deterministic rounds
+  GameManager floats = received;
+  floats.SnapToGrid();
+  CHECK(floats.asteroids.x == received.asteroids.x);
+
+  received.fixed_tick_rate = 60;
+  received.SnapToGrid();
+  for (auto *field :
+       {&received.asteroids.x, &received.asteroids.y, &received.asteroids.vx,
+        &received.asteroids.vy, &received.asteroids.rotation,
+        &received.asteroids.rotation_speed, &received.bullets.x,
+        &received.bullets.y, &received.bullets.rotation}) {
+    for (float v : *field)
+      CHECK(on_grid(v));
+  }
+  for (auto &p : received.players)
+    CHECK((on_grid(p.position.x) && on_grid(p.velocity.y) &&
+           on_grid(p.rotation)));
+
+  Movement movement{random_position(), random_velocity(), uniform(0, 360),
+                    true, 0};
+  Movement relayed;
+  REQUIRE(decode(encode(movement, WireFormat::Quantized), relayed,
+                 WireFormat::Quantized));
+  received.SnapToGrid(relayed);
+  CHECK((on_grid(relayed.position.x) && on_grid(relayed.position.y) &&
+         on_grid(relayed.velocity.x) && on_grid(relayed.velocity.y) &&
+         on_grid(relayed.rotation)));
+}
@@ -0,0 +1,144 @@
+// The vector circle kernels against raylib's CheckCollisionCircles
+#include <catch2/catch.hpp>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "bullet.hpp"
+#include "collision.hpp"
+#include "constants.hpp"
+#include "integration.hpp"
+
+namespace {
+
+std::mt19937 rng(3);
+
+float uniform(float min, float max) {
+  return std::uniform_real_distribution<float>(min, max)(rng);
+}
+
+uint64_t scalar_hits(Vector2 center, float radius, const float *x,
+                     const float *y, float block_radius, size_t count) {
+  uint64_t hits = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (CheckCollisionCircles(center, radius, Vector2{x[i], y[i]},
+                              block_radius))
+      hits |= uint64_t(1) << i;
+  }
+  return hits;
+}
+
+// A block padded like the slot arrays. The padding lanes sit on the
+// center, so a hit from them would show.
+struct Block {
+  std::vector<float> x, y;
+  Block(size_t count, Vector2 center)
+      : x(PaddedSlots(count), center.x), y(PaddedSlots(count), center.y) {}
+};
+
+// Around the center at distance reach * scale, in any direction
+Vector2 at_distance(Vector2 center, float reach, float scale) {
+  float angle = uniform(0, 2 * PI);
+  return {center.x + reach * scale * cosf(angle),
+          center.y + reach * scale * sinf(angle)};
+}
+
+} // namespace
+
+TEST_CASE("Circle hits match CheckCollisionCircles") {
+  INFO("Kernels: " << CollisionKernels());
+  size_t count = GENERATE(range(1, 65));
+
+  for (int round = 0; round < 50; round++) {
+    Vector2 center{uniform(-64, 964), uniform(-64, 714)};
+    float radius = uniform(1, 64), block_radius = uniform(1, 40);
+    float reach = radius + block_radius;
+    Block block(count, center);
+    for (size_t i = 0; i < count; i++) {
+      // Half far and half right at the edge, where rounding decides
+      Vector2 p = i % 2 ? Vector2{uniform(-64, 964), uniform(-64, 714)}
+                        : at_distance(center, reach, uniform(0.999f, 1.001f));
+      block.x[i] = p.x;
+      block.y[i] = p.y;
+    }
+    CHECK(CircleHits(center, radius, block.x.data(), block.y.data(),
+                     block_radius, count) ==
+          scalar_hits(center, radius, block.x.data(), block.y.data(),
+                      block_radius, count));
+  }
+}
+
+TEST_CASE("Touching circles hit, a step further they don't") {
+  INFO("Kernels: " << CollisionKernels());
+  // 3-4-5 triangles, exact in floats: the distance equals the radii's sum
+  Vector2 center{100, 200};
+  const float x[8] = {103, 97, 103, 100, 105, 103, 100, 95};
+  const float y[8] = {204, 196, 196, 205, 200, 204.0001f, 205.0001f, 200};
+  uint64_t expected = scalar_hits(center, 3, x, y, 2, 8);
+  CHECK(expected == 0b10011111);
+  CHECK(CircleHits(center, 3, x, y, 2, 8) == expected);
+}
+
+TEST_CASE("Padded tail lanes never hit") {
+  INFO("Kernels: " << CollisionKernels());
+  Vector2 center{450, 325};
+  for (size_t count : {1, 3, 5, 7, 9, 20, 33, 63}) {
+    // Every real lane misses, every padding lane is on the center
+    Block block(count, center);
+    for (size_t i = 0; i < count; i++) {
+      block.x[i] = center.x + 1000;
+      block.y[i] = center.y;
+    }
+    CHECK(CircleHits(center, 10, block.x.data(), block.y.data(), 5, count) ==
+          0);
+  }
+}
+
+TEST_CASE("Inactive slots keep their bits for the caller to mask") {
+  INFO("Kernels: " << CollisionKernels());
+  // Deactivated bullets keep their stale position, callers and the hits
+  // with the active mask like CollideAsteroid
+  const size_t BULLETS = 20;
+  BulletArrays bullets(BULLETS);
+  Vector2 center{300, 300};
+  for (size_t k = 0; k < BULLETS; k++)
+    bullets.set(k, Bullet{true, at_distance(center, 20, uniform(0.5f, 1.5f)),
+                          0});
+  for (size_t k = 0; k < BULLETS; k += 3)
+    bullets.deactivate(k);
+
+  uint64_t hits = CircleHits(center, 15, bullets.x.data(), bullets.y.data(),
+                             Constants::BULLET_SIZE, BULLETS);
+  uint64_t expected = 0;
+  for (size_t k = 0; k < BULLETS; k++) {
+    if (bullets.is_active(k) &&
+        CheckCollisionCircles(center, 15, bullets.position(k),
+                              Constants::BULLET_SIZE))
+      expected |= uint64_t(1) << k;
+  }
+  CHECK((hits & bullets.active.words[0]) == expected);
+  CHECK(hits == scalar_hits(center, 15, bullets.x.data(), bullets.y.data(),
+                            Constants::BULLET_SIZE, BULLETS));
+}
+
+TEST_CASE("Block hits test every pair") {
+  INFO("Kernels: " << CollisionKernels());
+  size_t count1 = GENERATE(1, 4, 20, 64);
+  size_t count2 = GENERATE(1, 2, 4, 13);
+  Block first(count1, {0, 0}), second(count2, {0, 0});
+  for (size_t i = 0; i < count1; i++) {
+    first.x[i] = uniform(0, 200);
+    first.y[i] = uniform(0, 200);
+  }
+  for (size_t j = 0; j < count2; j++) {
+    second.x[j] = uniform(0, 200);
+    second.y[j] = uniform(0, 200);
+  }
+  std::vector<uint64_t> hits(count1);
+  CircleBlockHits(first.x.data(), first.y.data(), 5, count1, second.x.data(),
+                  second.y.data(), 33, count2, hits.data());
+  for (size_t i = 0; i < count1; i++)
+    CHECK(hits[i] == scalar_hits({first.x[i], first.y[i]}, 5, second.x.data(),
+                                 second.y.data(), 33, count2));
+}
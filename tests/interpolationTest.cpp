@@ -0,0 +1,85 @@
+// Interpolation across the screen edges and slots taken over
+#include <catch2/catch.hpp>
+
+#include "gameManager.hpp"
+#include "interpolation.hpp"
+#include "snapshot.hpp"
+
+namespace {
+
+const auto t0 = steady_clock::time_point{} + 1h;
+
+EntityHistory history_of(Vector2 from, Vector2 to) {
+  EntityHistory history;
+  history.push({t0, from, 0});
+  history.push({t0 + 100ms, to, 0});
+  return history;
+}
+
+} // namespace
+
+TEST_CASE("Players interpolate across the screen edge") {
+  EntityHistory history = history_of({890, 640}, {10, 5});
+  Vector2 position;
+  float rotation;
+  history.sample(t0 + 50ms, true, position, rotation);
+  CHECK(position.x == Approx(0).margin(0.01));
+  CHECK(position.y == Approx(Constants::screenHeight - 2.5f).margin(0.01));
+}
+
+TEST_CASE("Asteroids in the spawn margin interpolate in a straight line") {
+  // Spawned at -64, flying in through the left and top edges
+  EntityHistory history = history_of({-64, -60}, {-44, -20});
+  Vector2 position;
+  float rotation;
+  history.sample(t0 + 50ms, false, position, rotation);
+  CHECK(position.x == Approx(-54));
+  CHECK(position.y == Approx(-40));
+
+  // The same through InterpolationBuffer, drawn at every frame
+  GameManager gm;
+  InterpolationBuffer buffer;
+  auto at = [](int ms) { return t0 + milliseconds(ms); };
+  float drawn_min = 1e9, drawn_max = -1e9;
+  for (int ms = 0; ms <= 1000; ms += 16) {
+    if (ms % 48 == 0) {
+      gm.asteroids.set(0, Asteroid{true, {-64.0f + ms * 0.1f, 300}, {100, 0},
+                                   0, 0, 32, 5});
+      buffer.record(gm, 0, at(ms));
+    }
+    buffer.apply(gm, 0, at(ms));
+    if (ms > 300) {
+      drawn_min = std::min(drawn_min, gm.asteroids.x[0]);
+      drawn_max = std::max(drawn_max, gm.asteroids.x[0]);
+    }
+  }
+  CHECK(drawn_min >= -64);
+  CHECK(drawn_max <= 40);
+}
+
+TEST_CASE("An asteroid taking over a slot is snapped to, not slid to") {
+  // The server destroys the asteroid in slot 0 and spawns another one there
+  // between two snapshots
+  GameManager server, client;
+  server.asteroids.spawn(0, Asteroid{true, {100, 100}, {0, 0}, 0, 0, 32, 5});
+  Snapshot first(server.type), second(server.type);
+  first.capture(server, 1);
+  server.asteroids.deactivate(0);
+  server.asteroids.spawn(0, Asteroid{true, {800, 500}, {0, 0}, 0, 0, 32, 5});
+  second.capture(server, 2);
+
+  InterpolationBuffer buffer;
+  auto at = [](int ms) { return t0 + milliseconds(ms); };
+  first.apply(client, UINT32_MAX);
+  buffer.record(client, UINT32_MAX, at(0));
+  second.apply(client, UINT32_MAX);
+  REQUIRE(client.asteroids.spawns[0] == server.asteroids.spawns[0]);
+  buffer.record(client, UINT32_MAX, at(50));
+
+  for (int ms = 50; ms <= 200; ms += 10) {
+    GameManager drawn = client;
+    buffer.apply(drawn, UINT32_MAX, at(ms));
+    CHECK(drawn.asteroids.x[0] == 800);
+    CHECK(drawn.asteroids.y[0] == 500);
+  }
+}
@@ -0,0 +1,214 @@
+// Prediction and interpolation over a link that drops and reorders
+// datagrams the way the server's -l/-o shim does
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <deque>
+#include <random>
+
+#include "datagram.hpp"
+#include "gameManager.hpp"
+#include "inputPrediction.hpp"
+#include "inputQueue.hpp"
+#include "interpolation.hpp"
+#include "networkUtils.hpp"
+
+using namespace std::chrono;
+
+namespace {
+
+const uint32_t TICK_RATE = 60;
+const duration<double> TICK(1.0 / TICK_RATE);
+
+// Drops loss% of the messages and holds reorder% back until the next one
+// overtakes them, after a fixed latency in ticks. Like the receivers of
+// datagrams, only messages newer than the last delivered one get through.
+template <typename T> struct LossyLink {
+  double loss, reorder;
+  size_t latency;
+  std::mt19937 rng{42};
+  struct Message {
+    size_t arrival;
+    uint32_t sequence;
+    T value;
+  };
+  std::deque<Message> in_flight;
+  std::vector<Message> held;
+  uint32_t sent = 0, delivered = 0;
+  size_t dropped = 0, stale = 0;
+
+  bool hit(double percent) {
+    return std::uniform_real_distribution<double>(0, 100)(rng) < percent;
+  }
+  void send(size_t now, const T &value) {
+    Message message{now + latency, ++sent, value};
+    if (hit(loss)) {
+      dropped++;
+      return;
+    }
+    if (hit(reorder)) {
+      held.push_back(message);
+      return;
+    }
+    in_flight.push_back(message);
+    for (auto &late : held) {
+      late.arrival = message.arrival;
+      in_flight.push_back(late);
+    }
+    held.clear();
+  }
+  template <typename F> void deliver(size_t now, F receive) {
+    while (!in_flight.empty() && in_flight.front().arrival <= now) {
+      const Message &message = in_flight.front();
+      if (sequence_newer(message.sequence, delivered)) {
+        delivered = message.sequence;
+        receive(message.value);
+      } else {
+        stale++;
+      }
+      in_flight.pop_front();
+    }
+  }
+};
+
+uint32_t buttons_at(size_t tick) {
+  static const uint32_t pattern[] = {InputThrust, InputThrust | InputLeft,
+                                     InputNone, InputRight,
+                                     InputThrust | InputRight};
+  return pattern[(tick / 20) % 5];
+}
+
+} // namespace
+
+TEST_CASE("Prediction converges to the server over a lossy link") {
+  double loss = GENERATE(0.0, 30.0);
+  double reorder = GENERATE(0.0, 10.0);
+  LossyLink<std::vector<InputState>> up{loss, reorder, 3};
+  LossyLink<Movement> down{loss, reorder, 3};
+
+  Player start{true, {450, 325}, {0, 0}, 0};
+  Player client = start, server = start;
+  InputPrediction prediction;
+  InputQueue queue;
+  uint32_t slack = TICK_RATE * 0.25;
+
+  const size_t TICKS = 600;
+  size_t now = 0;
+  for (; now < TICKS; now++) {
+    // Client frame: reconcile, predict one tick, send on change or every
+    // other tick like the game does
+    down.deliver(now, [&](const Movement &movement) {
+      prediction.reconcile(client, movement, TICK_RATE, 0);
+    });
+    REQUIRE(prediction.advance(client, buttons_at(now), TICK, TICK_RATE,
+                               0) == 1);
+    if (prediction.changed || now % 2 == 0) {
+      prediction.changed = false;
+      up.send(now, prediction.recent());
+    }
+
+    // Server tick
+    up.deliver(now, [&](const std::vector<InputState> &states) {
+      queue.receive(states, slack);
+    });
+    ApplyInputButtons(server, queue.step(), TICK, 0);
+    if (now % 2 == 0)
+      down.send(now, Movement{server.position, server.velocity,
+                              server.rotation, true, queue.tick});
+  }
+
+  // Let the server catch up with the last client tick, nothing new is sent
+  for (; queue.tick != prediction.tick && now < TICKS + 60; now++) {
+    up.deliver(now, [&](const std::vector<InputState> &states) {
+      queue.receive(states, slack);
+    });
+    ApplyInputButtons(server, queue.step(), TICK, 0);
+  }
+  REQUIRE(queue.tick == prediction.tick);
+  if (loss > 0)
+    CHECK(up.dropped > 0);
+
+  CHECK(server.position.x == Approx(client.position.x).margin(0.01));
+  CHECK(server.position.y == Approx(client.position.y).margin(0.01));
+  CHECK(server.rotation == Approx(client.rotation).margin(0.01));
+}
+
+TEST_CASE("Interpolated remote players move smoothly over a lossy link") {
+  double loss = GENERATE(0.0, 30.0);
+  double reorder = GENERATE(0.0, 10.0);
+  LossyLink<Movement> down{loss, reorder, 3};
+
+  const float SPEED = 60; // px/s along x
+  GameManager gm;
+  gm.players.at(1).active = true;
+  InterpolationBuffer buffer;
+  auto t0 = steady_clock::time_point{} + 1h;
+  auto at = [&](size_t tick) {
+    return t0 + duration_cast<steady_clock::duration>(TICK * tick);
+  };
+
+  float drawn = -1, largest_step = 0;
+  size_t backwards = 0, last_delivery = 0, longest_gap = 0;
+  for (size_t now = 0; now < 600; now++) {
+    if (now % 2 == 0)
+      down.send(now, Movement{{100 + SPEED * (float)(TICK * now).count(),
+                               300},
+                              {SPEED, 0},
+                              0,
+                              true,
+                              0});
+    down.deliver(now, [&](const Movement &movement) {
+      longest_gap = std::max(longest_gap, now - last_delivery);
+      last_delivery = now;
+      Player p = gm.players[1];
+      p.position = movement.position;
+      buffer.record_player(1, p, at(now));
+    });
+    buffer.apply(gm, 0, at(now));
+
+    float x = gm.players[1].position.x;
+    if (now > 30 && drawn >= 0) {
+      backwards += x < drawn;
+      largest_step = std::max(largest_step, x - drawn);
+    }
+    drawn = x;
+  }
+
+  // Reordered states arrive stale and are dropped. Lost ones are bridged
+  // while the delay covers the gap, past it the newest state is held and
+  // the catch-up is at most the way the player went in the gap.
+  if (reorder > 0)
+    CHECK(down.stale > 0);
+  CHECK(backwards == 0);
+  float tick_step = SPEED * TICK.count();
+  if (loss == 0 && reorder == 0)
+    CHECK(largest_step <= 2 * tick_step);
+  CHECK(largest_step <= (longest_gap + 1) * tick_step);
+  CHECK(buffer.delay() <= Constants::INTERPOLATION_DELAY_MAX);
+}
+
+TEST_CASE("The acknowledged input tick never goes back") {
+  InputQueue queue;
+  uint32_t slack = TICK_RATE * 0.25;
+  std::vector<InputState> states;
+  for (uint32_t t = 1; t <= 10; t++)
+    states.push_back({t, InputThrust});
+  queue.receive(states, slack);
+
+  // The client stalls while the simulation holds its buttons
+  for (int i = 0; i < 30; i++)
+    queue.step();
+  uint32_t acked = queue.tick;
+
+  queue.receive({{11, InputThrust}, {12, InputLeft}}, slack);
+  CHECK(queue.tick == acked);
+  CHECK(queue.step() == InputLeft);
+  CHECK(queue.tick == acked + 1);
+}
+
+TEST_CASE("Shim percentages can be turned off") {
+  char off[] = "0", some[] = "30", all[] = "100";
+  CHECK(readPercent(off) == 0);
+  CHECK(readPercent(some) == 30);
+  CHECK(readPercent(all) == 100);
+}
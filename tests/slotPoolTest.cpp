@@ -0,0 +1,72 @@
+// Slot reuse by the pools and within a collision pass
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+
+#include "gameManager.hpp"
+#include "slotPool.hpp"
+
+TEST_CASE("Retired slots come back only when released") {
+  ActiveMask active;
+  active.resize(0, 8);
+  SlotPool pool(0, 4);
+  for (uint32_t slot = 0; slot < 4; slot++) {
+    REQUIRE(pool.allocate(active) == slot);
+    active.set(slot, true);
+  }
+
+  active.set(2, false);
+  pool.retire(2);
+  // reclaim skips it even with the list empty
+  uint32_t none = SlotPool::NONE;
+  CHECK(pool.allocate(active) == none);
+  CHECK(pool.exhausted == 1);
+
+  pool.release_retired();
+  CHECK(pool.allocate(active) == 2);
+
+  // Deactivated without retiring, reclaim finds it
+  active.set(2, true);
+  active.set(1, false);
+  CHECK(pool.allocate(active) == 1);
+}
+
+TEST_CASE("A split asteroid isn't hit again in the same pass") {
+  GameManager gm;
+  Vector2 center{450, 325};
+  uint32_t i = gm.AddAsteroid();
+  REQUIRE(i != UINT32_MAX);
+  gm.asteroids.set(i, Asteroid{true, center, {10, 0}, 0, 0, 60, 5});
+  // Bullets of two players on it, either one would destroy it
+  size_t first = 0, second = gm.BulletsPerPlayer();
+  gm.bullets.set(first, Bullet{true, center, 0});
+  gm.bullets.set(second, Bullet{true, center, 0});
+
+  std::vector<uint32_t> destroyed_asteroids, spawned_asteroids,
+      destroyed_players, destroyed_bullets;
+  gm.ManageCollisions(destroyed_asteroids, spawned_asteroids,
+                      destroyed_players, destroyed_bullets);
+  CHECK(destroyed_asteroids == std::vector<uint32_t>{i});
+  CHECK(destroyed_bullets == std::vector<uint32_t>{(uint32_t)first});
+  // The children landed elsewhere, at the parent's position
+  REQUIRE(spawned_asteroids.size() == 2);
+  for (uint32_t child : spawned_asteroids) {
+    CHECK(child != i);
+    CHECK(gm.asteroids.is_active(child));
+  }
+  CHECK(gm.bullets.is_active(second));
+  CHECK_FALSE(gm.asteroids.is_active(i));
+
+  // The next pass tests the children, a split in it can reuse the parent's
+  // slot
+  destroyed_asteroids.clear();
+  spawned_asteroids.clear();
+  destroyed_bullets.clear();
+  gm.ManageCollisions(destroyed_asteroids, spawned_asteroids,
+                      destroyed_players, destroyed_bullets);
+  CHECK(destroyed_bullets == std::vector<uint32_t>{(uint32_t)second});
+  REQUIRE(destroyed_asteroids.size() == 1);
+  CHECK(destroyed_asteroids[0] != i);
+  CHECK(std::count(spawned_asteroids.begin(), spawned_asteroids.end(), i) ==
+        1);
+}